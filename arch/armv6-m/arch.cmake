@@ -16,6 +16,21 @@
 # this program. If not, see <https://www.gnu.org/licenses/>.
 #
 
+# armv7-m and armv8-m.main include this file with own cpu and sources, cpu
+# may be also set by user, so defaults are independent. Cached sources are set
+# on each configuration, so they don't stay from previous architecture
+if(NOT DEFINED yasld_arch_cpu)
+  set(yasld_arch_cpu cortex-m0plus)
+endif()
+
+if(NOT DEFINED yasld_arch_sources_dir)
+  set(yasld_arch_sources_dir armv6-m)
+endif()
+
+set(yasld_arch_sources
+    ${yasld_arch_sources_dir}
+    CACHE INTERNAL "" FORCE)
+
 add_library(yasld_standalone_executable_flags INTERFACE)
 add_library(yasld_executable_flags INTERFACE)
 add_library(yasld_shared_library_flags INTERFACE)
@@ -119,7 +134,7 @@ target_link_libraries(yasld_common_flags INTERFACE yasld_arch_flags)
 
 target_compile_options(
   yasld_arch_flags
-  INTERFACE -mcpu=cortex-m0plus
+  INTERFACE -mcpu=${yasld_arch_cpu}
             -mfloat-abi=soft
             -fno-plt
             -mthumb
@@ -130,10 +145,10 @@ target_compile_options(
 target_link_options(
   yasld_arch_flags
   INTERFACE
-  -mcpu=cortex-m0plus
+  -mcpu=${yasld_arch_cpu}
   -mfloat-abi=soft
   -mthumb)
 
 set(yasld_arch_flags_str
-    "-fomit-frame-pointer -mlong-calls -fPIC -nostartfiles -msingle-pic-base -mno-pic-data-is-text-relative -mcpu=cortex-m0plus -mfloat-abi=soft -mthumb -fno-section-anchors -fno-inline"
+    "-fomit-frame-pointer -mlong-calls -fPIC -nostartfiles -msingle-pic-base -mno-pic-data-is-text-relative -mcpu=${yasld_arch_cpu} -mfloat-abi=soft -mthumb -fno-section-anchors -fno-inline"
     CACHE INTERNAL "" FORCE)
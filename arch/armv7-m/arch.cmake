@@ -0,0 +1,27 @@
+#
+# arch.cmake
+#
+# Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+#
+# This program is free software: you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at your option) any later
+# version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with
+# this program. If not, see <https://www.gnu.org/licenses/>.
+#
+
+# Flags and linker scripts are shared with armv6-m, only cpu and sources
+# with Thumb-2 wrappers differ
+if(NOT DEFINED yasld_arch_cpu)
+  set(yasld_arch_cpu cortex-m4)
+endif()
+
+set(yasld_arch_sources_dir armv7-m)
+
+include(${CMAKE_CURRENT_LIST_DIR}/../armv6-m/arch.cmake)
@@ -0,0 +1,27 @@
+#
+# arch.cmake
+#
+# Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+#
+# This program is free software: you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at your option) any later
+# version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with
+# this program. If not, see <https://www.gnu.org/licenses/>.
+#
+
+# armv8-m.main executes armv7-m code, so Thumb-2 sources are shared with
+# armv7-m. Security extension is not used, modules run in one state
+if(NOT DEFINED yasld_arch_cpu)
+  set(yasld_arch_cpu cortex-m33)
+endif()
+
+set(yasld_arch_sources_dir armv7-m)
+
+include(${CMAKE_CURRENT_LIST_DIR}/../armv6-m/arch.cmake)
@@ -16,6 +16,10 @@
 # this program. If not, see <https://www.gnu.org/licenses/>.
 #
 
+set(yasld_arch_sources
+    host
+    CACHE INTERNAL "" FORCE)
+
 add_library(yasld_arch_flags INTERFACE)
 
 target_compile_options(yasld_arch_flags INTERFACE)
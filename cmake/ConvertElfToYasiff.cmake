@@ -23,9 +23,9 @@ include(GenerateWrappers)
 
 macro(convert_elf_to_yasiff)
   set(prefix YASIFF)
-  set(optionArgs "") 
-  set(singleValueArgs TARGET TYPE)
-  set(multiValueArgs LIBRARIES)
+  set(optionArgs DIRECT_CALLS SHARED_DISPATCHER WRAPPERS_SIZE_REPORT)
+  set(singleValueArgs TARGET TYPE FLASH_ADDRESS)
+  set(multiValueArgs LIBRARIES COMPRESS)
 
   include(CMakeParseArguments)
   cmake_parse_arguments(
@@ -36,11 +36,37 @@ macro(convert_elf_to_yasiff)
     ${ARGN})
 
   if(${YASIFF_TYPE} STREQUAL "shared_library")
-    generate_wrappers_for(${YASIFF_TARGET})
+    set(wrappers_options "")
+    if(YASIFF_DIRECT_CALLS)
+      list(APPEND wrappers_options DIRECT_CALLS)
+    elseif(YASIFF_SHARED_DISPATCHER)
+      list(APPEND wrappers_options SHARED_DISPATCHER)
+    endif()
+    if(YASIFF_WRAPPERS_SIZE_REPORT)
+      list(APPEND wrappers_options SIZE_REPORT)
+    endif()
+    generate_wrappers_for(${YASIFF_TARGET} ${wrappers_options})
   endif()
 
   get_filename_component(MKIMAGE_DIR ${MKIMAGE_DIR} ABSOLUTE)
 
+  set(mkimage_arch "")
+  if(YASLD_ARCH)
+    set(mkimage_arch --arch=${YASLD_ARCH})
+  endif()
+
+  # image placed at known flash address keeps .data.rel.ro in flash
+  set(mkimage_flash_address "")
+  if(YASIFF_FLASH_ADDRESS)
+    set(mkimage_flash_address --flash-address=${YASIFF_FLASH_ADDRESS})
+  endif()
+
+  # sections (text, data) stored as LZ4 blocks
+  set(mkimage_compress "")
+  if(YASIFF_COMPRESS)
+    set(mkimage_compress --compress ${YASIFF_COMPRESS})
+  endif()
+
   add_custom_command(
     OUTPUT ${YASIFF_TARGET}.yaff
     COMMAND ${CMAKE_OBJCOPY} --localize-hidden $<TARGET_FILE:${YASIFF_TARGET}>
@@ -51,9 +77,11 @@ macro(convert_elf_to_yasiff)
       ${mkimage_python_executable} ${MKIMAGE_DIR}/mkimage.py
       --type=${YASIFF_TYPE} --input=$<TARGET_FILE:${YASIFF_TARGET}>.pre
       --output=${CMAKE_CURRENT_BINARY_DIR}/${YASIFF_TARGET}.yaff --libraries
-      ${YASIFF_LIBRARIES} --verbose
+      ${YASIFF_LIBRARIES} ${mkimage_arch} ${mkimage_flash_address} ${mkimage_compress}
+      --verbose
     VERBATIM
-    DEPENDS ${MKIMAGE_DIR}/mkimage.py ${YASIFF_TARGET} ${YASIFF_LIBRARIES}
+    DEPENDS ${MKIMAGE_DIR}/mkimage.py ${MKIMAGE_DIR}/lz4.py ${YASIFF_TARGET}
+            ${YASIFF_LIBRARIES}
     COMMENT "Generating YASIFF image for module ${YASIFF_TARGET}")
 
   add_custom_target(generate_${YASIFF_TARGET}.yaff ALL
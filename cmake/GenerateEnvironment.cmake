@@ -0,0 +1,64 @@
+#
+# GenerateEnvironment.cmake
+#
+# Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+#
+# This program is free software: you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at your option) any later
+# version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with
+# this program. If not, see <https://www.gnu.org/licenses/>.
+#
+
+set(CURRENT_FILE_DIR ${CMAKE_CURRENT_LIST_DIR})
+set(MKIMAGE_DIR ${CURRENT_FILE_DIR}/../mkimage)
+
+# Adds to TARGET StaticEnvironment generated from symbols exported by INPUTS
+# (ELF files or static libraries objects). Environment is returned by function
+# NAME (default: get_firmware_environment). Optional SYMBOLS file limits
+# exported symbols to listed names.
+function(generate_environment)
+  set(prefix ENVIRONMENT)
+  set(optionArgs "")
+  set(singleValueArgs TARGET NAME SYMBOLS)
+  set(multiValueArgs INPUTS)
+
+  include(CMakeParseArguments)
+  cmake_parse_arguments(
+    ${prefix}
+    "${optionArgs}"
+    "${singleValueArgs}"
+    "${multiValueArgs}"
+    ${ARGN})
+
+  if(NOT ENVIRONMENT_NAME)
+    set(ENVIRONMENT_NAME get_firmware_environment)
+  endif()
+
+  set(optional_args "")
+  if(ENVIRONMENT_SYMBOLS)
+    set(optional_args --symbols ${ENVIRONMENT_SYMBOLS})
+  endif()
+
+  set(output ${CMAKE_CURRENT_BINARY_DIR}/${ENVIRONMENT_TARGET}_environment.cpp)
+  string(REPLACE ";" "," inputs "${ENVIRONMENT_INPUTS}")
+
+  add_custom_command(
+    OUTPUT ${output}
+    COMMAND
+      ${mkimage_python_executable} ${MKIMAGE_DIR}/generate_environment.py
+      --input ${inputs} --output ${output} --name ${ENVIRONMENT_NAME}
+      ${optional_args}
+    DEPENDS ${MKIMAGE_DIR}/generate_environment.py ${ENVIRONMENT_INPUTS}
+            ${ENVIRONMENT_SYMBOLS}
+    COMMENT "Generating environment for ${ENVIRONMENT_TARGET}"
+    VERBATIM)
+
+  target_sources(${ENVIRONMENT_TARGET} PRIVATE ${output})
+endfunction()
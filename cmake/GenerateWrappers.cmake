@@ -20,17 +20,38 @@ set(CURRENT_FILE_DIR ${CMAKE_CURRENT_LIST_DIR})
 set(MKIMAGE_DIR ${CURRENT_FILE_DIR}/../mkimage)
 set(YASLD_ARCH_PATH ${YASLD_ARCH_PATH})
 
+# DIRECT_CALLS generates wrappers without supervisor calls
+# SHARED_DISPATCHER generates small stubs calling one dispatcher
+# SIZE_REPORT prints code size of wrappers with and without dispatcher
 function(generate_wrappers_for target)
+  set(wrappers_flavour "")
+  set(wrappers_template call_wrapped.s.tmpl)
+  if("DIRECT_CALLS" IN_LIST ARGN)
+    set(wrappers_flavour --direct)
+    set(wrappers_template call_wrapped_direct.s.tmpl)
+    # arguments of functions are read from debug information, functions
+    # taking arguments from stack are called through supervisor calls
+    target_compile_options(${target} PRIVATE -g)
+  elseif("SHARED_DISPATCHER" IN_LIST ARGN)
+    set(wrappers_flavour --shared-dispatcher)
+    set(wrappers_template call_wrapped_dispatcher.s.tmpl)
+  endif()
+  if("SIZE_REPORT" IN_LIST ARGN)
+    list(APPEND wrappers_flavour --size-report)
+  endif()
+
   add_custom_command(
     TARGET ${target}
     PRE_LINK
     COMMAND
       ${mkimage_python_executable} ${MKIMAGE_DIR}/generate_wrappers.py --input
       $<TARGET_OBJECTS:${target}> --output ${target}_wrappers.s --objcopy
-      ${CMAKE_OBJCOPY} --verbose --template ${YASLD_ARCH_DIR}/${YASLD_ARCH}
+      ${CMAKE_OBJCOPY} --verbose --template
+      ${YASLD_ARCH_DIR}/${yasld_arch_sources}
       --compiler=${CMAKE_C_COMPILER} --ar ${CMAKE_AR}
-      --compiler_flags=${yasld_arch_flags_str}
-    DEPENDS ${MKIMAGE_DIR}/generate_wrappers.py ${YASLD_ARCH_DIR}/${YASLD_ARCH}/call_wrapped.s.tmpl
+      --compiler_flags=${yasld_arch_flags_str} ${wrappers_flavour}
+    DEPENDS ${MKIMAGE_DIR}/generate_wrappers.py
+            ${MKIMAGE_DIR}/register_arguments.py ${YASLD_ARCH_DIR}/${yasld_arch_sources}/${wrappers_template}
     VERBATIM)
 
   add_custom_command(
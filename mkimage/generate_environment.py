@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+#
+# generate_environment.py
+#
+# Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+#
+# This program is free software: you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation, either version
+# 3 of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be
+# useful, but WITHOUT ANY WARRANTY; without even the implied
+# warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+# PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General
+# Public License along with this program. If not, see
+# <https://www.gnu.org/licenses/>.
+#
+
+# Generates yasld::StaticEnvironment with symbols exported from ELF files
+# (firmware from previous build or static libraries linked into it).
+# Entries are emitted as constexpr array sorted by name, so table is placed in
+# flash. Unsorted table fails compilation of constinit environment.
+# Addresses are resolved by linker, only names and types are taken from ELF.
+
+import argparse
+import os
+
+from pathlib import Path
+
+from elf_parser import ElfParser
+
+parser = argparse.ArgumentParser(
+    description="""
+                Generates StaticEnvironment from symbols exported by ELF files
+                """
+)
+
+parser.add_argument(
+    "-i", "--input", action="store", help="List of files separated by ',' or ';'"
+)
+parser.add_argument(
+    "-o", "--output", action="store", help="Generated C++ source file"
+)
+parser.add_argument(
+    "-n",
+    "--name",
+    action="store",
+    default="get_firmware_environment",
+    help="Name of generated function returning environment",
+)
+parser.add_argument(
+    "-s",
+    "--symbols",
+    action="store",
+    help="Optional file with symbol names to export, one per line",
+)
+
+args, _ = parser.parse_known_args()
+
+
+def is_exported(data):
+    return (
+        data["binding"] in ("STB_GLOBAL", "STB_WEAK")
+        and data["visibility"] != "STV_HIDDEN"
+        and data["section_index"] != "SHN_UNDEF"
+        and data["type"] in ("STT_FUNC", "STT_OBJECT")
+    )
+
+
+allowed = None
+if args.symbols:
+    with open(args.symbols, "r") as file:
+        allowed = {line.strip() for line in file if line.strip()}
+
+symbols = {}
+for file in args.input.replace(",", ";").split(";"):
+    for name, data in ElfParser(file).symbols.items():
+        if not is_exported(data):
+            continue
+        if allowed is not None and name not in allowed:
+            continue
+        # only C linkage can be declared without knowing signature
+        if name.startswith("_Z"):
+            print("Skipping C++ symbol: " + name)
+            continue
+        symbols[name] = data["type"]
+
+if allowed is not None:
+    for name in sorted(allowed - symbols.keys()):
+        print("Warning: symbol not found: " + name)
+
+names = sorted(symbols.keys(), key=lambda name: name.encode("ascii"))
+
+generated = "// Generated by generate_environment.py, do not edit\n\n"
+generated += "#include <yasld/environment.hpp>\n\n"
+# declarations are renamed with asm labels, so they never conflict with
+# builtins or headers declaring real signatures. Functions are declared as
+# objects too, so their addresses are constant expressions. Linker still sets
+# Thumb bit, since defined symbol is a function
+generated += 'extern "C"\n{\n'
+for name in names:
+    generated += "  extern const char yasld_env_" + name
+    generated += ' __asm__("' + name + '");\n'
+generated += "}\n\n"
+
+generated += "namespace\n{\n\n"
+table = "{}"
+# zero sized array is ill formed
+if names:
+    table = "symbols"
+    generated += "constexpr yasld::SymbolEntry symbols[] = {\n"
+    generated += ",\n".join(
+        '  yasld::SymbolEntry{ "' + name + '", &yasld_env_' + name + " }"
+        for name in names
+    )
+    generated += "\n};\n\n"
+generated += "constinit const yasld::StaticEnvironment environment{ "
+generated += table + " };\n\n"
+generated += "} // namespace\n\n"
+
+generated += "const yasld::Environment &" + args.name + "()\n{\n"
+generated += "  return environment;\n}\n"
+
+if os.path.exists(args.output):
+    os.remove(args.output)
+
+with open(args.output, "x") as file:
+    file.write(generated)
+
+print("Generated environment with {} symbols: {}".format(len(names), args.output))
@@ -30,6 +30,7 @@ import sys
 from pathlib import Path
 
 from elf_parser import ElfParser
+from register_arguments import find_register_argument_functions
 
 print("Generating wrappers for public functions:")
 
@@ -54,6 +55,24 @@ parser.add_argument(
 parser.add_argument("-b", "--compiler", action="store", help="Compile command")
 parser.add_argument("-f", "--compiler_flags", action="store", help="Compile flags")
 parser.add_argument("-a", "--ar", action="store", help="Compile command")
+parser.add_argument(
+    "-d",
+    "--direct",
+    action="store_true",
+    help="Generate wrappers without supervisor calls, module text is placed in RAM",
+)
+parser.add_argument(
+    "-s",
+    "--shared-dispatcher",
+    action="store_true",
+    help="Generate small stubs branching to one dispatcher with supervisor calls",
+)
+parser.add_argument(
+    "-r",
+    "--size-report",
+    action="store_true",
+    help="Print code size of wrappers with and without shared dispatcher",
+)
 
 
 args, _ = parser.parse_known_args()
@@ -65,9 +84,17 @@ files = args.input.replace(",", ";").split(";")
 templates = Path(args.template)
 print("Template path is: ", templates)
 env = jinja2.Environment(loader=jinja2.FileSystemLoader(templates))
-template = env.get_template("call_wrapped.s.tmpl")
-
-generated_file = ""
+direct_template = "call_wrapped_direct.s.tmpl"
+fallback_template = "call_wrapped.s.tmpl"
+if args.direct:
+    template_name = direct_template
+elif args.shared_dispatcher:
+    template_name = "call_wrapped_dispatcher.s.tmpl"
+else:
+    template_name = "call_wrapped.s.tmpl"
+
+wrapped_symbols_per_file = []
+register_arguments = set()
 for file in files:
     symbols = []
     print("File: ", file)
@@ -85,32 +112,88 @@ for file in files:
         if is_global_and_visible and data["type"] == "STT_FUNC":
             symbols.append(name)
             wrapped_symbols.append(name)
-
-    generated_file += template.render(names=wrapped_symbols)
-
-if os.path.exists(args.output):
-    os.remove(args.output)
-
-with open(args.output, "x") as file:
-    file.write(generated_file)
-
-command = (
-    args.compiler
-    + " "
-    + args.compiler_flags
-    + " -c "
-    + args.output
-    + " -o "
-    + args.output
-    + ".obj"
-)
-print("Generate file with command: ", command)
-output = subprocess.run(command, shell=True, capture_output=True)
-print(output.stdout)
-print(output.stderr)
-if output.returncode != 0:
-    sys.exit(output.returncode)
-
+    wrapped_symbols_per_file.append(wrapped_symbols)
+    if args.direct:
+        register_arguments |= find_register_argument_functions(file)
+
+if args.direct and not register_arguments:
+    print("Warning: no debug information, compile module with -g to use direct calls")
+
+
+def render_wrappers(template_name):
+    generated_file = ""
+    rendered_templates = set()
+    for wrapped_symbols in wrapped_symbols_per_file:
+        groups = [(template_name, wrapped_symbols)]
+        if template_name == direct_template:
+            # direct wrapper moves stack pointer before call, so functions
+            # reading arguments from stack are called with supervisor calls
+            groups = [
+                (
+                    direct_template,
+                    [name for name in wrapped_symbols if name in register_arguments],
+                ),
+                (
+                    fallback_template,
+                    [
+                        name
+                        for name in wrapped_symbols
+                        if name not in register_arguments
+                    ],
+                ),
+            ]
+        for name, names in groups:
+            if not names:
+                continue
+            print("Wrappers from", name, "for:", names)
+            # lot base and dispatcher are defined once for all files
+            generated_file += env.get_template(name).render(
+                names=names,
+                define_lot_base=name not in rendered_templates,
+                define_dispatcher=name not in rendered_templates,
+            )
+            rendered_templates.add(name)
+    return generated_file
+
+
+def compile_wrappers(source, output):
+    if os.path.exists(output):
+        os.remove(output)
+
+    with open(output, "x") as file:
+        file.write(source)
+
+    command = (
+        args.compiler
+        + " "
+        + args.compiler_flags
+        + " -c "
+        + output
+        + " -o "
+        + output
+        + ".obj"
+    )
+    print("Generate file with command: ", command)
+    output = subprocess.run(command, shell=True, capture_output=True)
+    print(output.stdout)
+    print(output.stderr)
+    if output.returncode != 0:
+        sys.exit(output.returncode)
+
+
+compile_wrappers(render_wrappers(template_name), args.output)
+
+if args.size_report:
+    number_of_wrappers = sum(len(names) for names in wrapped_symbols_per_file)
+    print("Wrappers code size for", number_of_wrappers, "functions:")
+    for layout, name in [
+        ("per symbol wrappers", "call_wrapped.s.tmpl"),
+        ("shared dispatcher", "call_wrapped_dispatcher.s.tmpl"),
+    ]:
+        report_file = args.output + "." + name.removesuffix(".s.tmpl") + ".s"
+        compile_wrappers(render_wrappers(name), report_file)
+        text = ElfParser(report_file + ".obj").sections[".text"]["size"]
+        print("  {:<20} {:>8} B".format(layout, text))
 
 command = (
     args.ar + " rcs lib" + args.output.split(".")[0] + ".a" + " " + args.output + ".obj"
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+#
+# lz4.py
+#
+# Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+#
+# This program is free software: you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation, either version
+# 3 of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be
+# useful, but WITHOUT ANY WARRANTY; without even the implied
+# warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+# PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General
+# Public License along with this program. If not, see
+# <https://www.gnu.org/licenses/>.
+#
+
+
+# LZ4 block format (without frame) used for compressed text and data
+# sections. Loader decodes it in blocks read from image, so encoder must
+# follow block format end conditions.
+
+MIN_MATCH = 4
+# last 5 bytes are always literals and last match starts at least 12 bytes
+# before end of block
+LAST_LITERALS = 5
+MATCH_FIND_LIMIT = 12
+MAX_OFFSET = 0xFFFF
+
+
+def _write_length(output, length):
+    length -= 15
+    while length >= 255:
+        output.append(255)
+        length -= 255
+    output.append(length)
+
+
+def _write_sequence(output, literals, offset, match_length):
+    match_code = match_length - MIN_MATCH if match_length else 0
+    output.append((min(len(literals), 15) << 4) | min(match_code, 15))
+    if len(literals) >= 15:
+        _write_length(output, len(literals))
+    output += literals
+    if match_length == 0:
+        return
+    output += offset.to_bytes(2, "little")
+    if match_code >= 15:
+        _write_length(output, match_code)
+
+
+def compress(data):
+    data = bytes(data)
+    output = bytearray()
+    positions = {}
+    anchor = 0
+    position = 0
+    while position + MATCH_FIND_LIMIT < len(data):
+        key = data[position : position + MIN_MATCH]
+        match = positions.get(key)
+        positions[key] = position
+        if match is None or position - match > MAX_OFFSET:
+            position += 1
+            continue
+
+        length = MIN_MATCH
+        max_length = len(data) - LAST_LITERALS - position
+        while (
+            length < max_length
+            and data[match + length] == data[position + length]
+        ):
+            length += 1
+        _write_sequence(output, data[anchor:position], position - match, length)
+        position += length
+        anchor = position
+    _write_sequence(output, data[anchor:], 0, 0)
+    return output
+
+
+def _read_length(data, position, length):
+    if length != 15:
+        return length, position
+    while True:
+        byte = data[position]
+        position += 1
+        length += byte
+        if byte != 255:
+            return length, position
+
+
+def decompress(data):
+    output = bytearray()
+    position = 0
+    while position < len(data):
+        token = data[position]
+        position += 1
+        length, position = _read_length(data, position, token >> 4)
+        output += data[position : position + length]
+        position += length
+        if position == len(data):
+            break
+        offset = int.from_bytes(data[position : position + 2], "little")
+        position += 2
+        length, position = _read_length(data, position, token & 0x0F)
+        length += MIN_MATCH
+        if offset == 0 or offset > len(output):
+            raise ValueError("LZ4 match outside of decoded data")
+        for _ in range(length):
+            output.append(output[-offset])
+    return output
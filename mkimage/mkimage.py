@@ -30,6 +30,8 @@ from colorama import Fore
 
 from elf_parser import ElfParser
 from relocation_set import RelocationSet
+from symbol_hash import SymbolHashTable
+import lz4
 from enum import Enum
 
 from pathlib import Path
@@ -42,6 +44,30 @@ class SectionCode(Enum):
     Unknown = 3
 
 
+class HeaderFlags:
+    ExportedSymbolsHash = 0x01
+    ImportedFunctions = 0x02
+    DirectCalls = 0x04
+    ReadOnlyDataInText = 0x08
+    CompressedText = 0x10
+    CompressedData = 0x20
+
+
+# values of Header::Architecture
+ARCHITECTURES = {"armv6-m": 1, "armv7-m": 2, "armv8-m.main": 3}
+
+
+# defined by direct call wrappers, loader stores LOT base of module there
+LOT_BASE_SYMBOL = "__yasld_lot_base"
+
+
+YASIFF_VERSION = 2
+# offset and size for: name, imported libraries, symbol table, local and data
+# relocations, imported, exported symbols, exported symbols hash, text, init
+# and data
+SECTION_DIRECTORY_SIZE = 11 * 8
+
+
 def parse_cli_arguments():
     parser = argparse.ArgumentParser(
         description="""
@@ -98,6 +124,44 @@ def parse_cli_arguments():
         action="store",
         help="Type of module: library/executable. Workaround for Cortex-M0 to create shared libraries from executables",
     )
+    parser.add_argument(
+        "--arch",
+        dest="arch",
+        action="store",
+        choices=ARCHITECTURES.keys(),
+        default="armv6-m",
+        help="Architecture of module code, Thumb-2 modules can't be executed on armv6-m (default: armv6-m)",
+    )
+    parser.add_argument(
+        "--symbol-hash",
+        dest="symbol_hash",
+        action=argparse.BooleanOptionalAction,
+        default=True,
+        help="Emit hash index for exported symbols (default: enabled)",
+    )
+    parser.add_argument(
+        "--flash-address",
+        dest="flash_address",
+        action="store",
+        type=lambda value: int(value, 0),
+        help="Address of memory mapped image in flash. When given, .data.rel.ro (vtables, pointer tables) is resolved for this address and kept in text instead of being copied to RAM",
+    )
+    parser.add_argument(
+        "--compress",
+        dest="compress",
+        nargs="*",
+        action="store",
+        choices=["text", "data"],
+        default=[],
+        help="Sections stored as LZ4 blocks, decompressed by loader to RAM. Section is kept raw when compression doesn't reduce its size. Text with read only data linked for flash address is never compressed",
+    )
+    parser.add_argument(
+        "--imported-functions",
+        dest="imported_functions",
+        nargs="*",
+        action="store",
+        help="Imported symbols that are functions, for undefined symbols without type in ELF. Separated by , or ;. Only functions may be bound lazily.",
+    )
 
     args, _ = parser.parse_known_args()
     return args
@@ -112,11 +176,8 @@ class Application:
             self.logger.register_logger(
                 FileLogger(self.args.verbose, True, self.args.log)
             )
-        if args.type:
-            if args.type == "shared_library":
-                self.is_executable = False
-            else:
-                self.is_executable = True
+        # modules are executables unless type says otherwise
+        self.is_executable = getattr(args, "type", None) != "shared_library"
 
     def __print_header(self):
         self.logger.log(" ===========================================", Fore.YELLOW)
@@ -164,9 +225,29 @@ class Application:
             self.init_arrays = bytearray()
             data_section_address = self.text_section["address"] + self.text_section["size"]
 
+        # relocated read only data is placed before .data, when flash address
+        # is known it is moved to end of text, otherwise it is copied to RAM
+        # with data
+        self.read_only = bytearray()
+        self.read_only_relocations = []
+        if self.__has_section(".data.rel.ro"):
+            self.read_only_section = self.__fetch_section(".data.rel.ro", data_section_address)
+            data_section_address = self.read_only_section["address"] + self.read_only_section["size"]
+        else:
+            self.read_only_section = None
+
         self.data_section = self.__fetch_section(".data", data_section_address)
         self.data = bytearray(self.data_section["data"])
 
+        if self.read_only_section is not None:
+            if getattr(self.args, "flash_address", None) is None:
+                self.data = bytearray(self.read_only_section["data"]) + self.data
+            else:
+                self.read_only = bytearray(self.read_only_section["data"])
+                self.read_only_base = self.read_only_section["address"]
+                # keeps alignment of read only data relative to text
+                self.read_only_offset = len(self.text) + (self.read_only_base - len(self.text)) % 8
+
         bss_section_address = self.data_section["address"] + self.data_section["size"]
         self.bss_section = self.__fetch_section(".bss", bss_section_address)
         self.bss = bytearray(self.bss_section["data"])
@@ -311,7 +392,12 @@ class Application:
                             )
                         )
                         raise RuntimeError("Data relocation processing failure")
-                    from_address = int(relocation["offset"] - data_offset)
+                    read_only_end = data_offset + len(self.read_only)
+                    if data_offset <= relocation["offset"] < read_only_end:
+                        self.__resolve_read_only_relocation(relocation)
+                        continue
+
+                    from_address = int(relocation["offset"] - read_only_end)
                     data = self.data
                     section_code = SectionCode.Data
                     offset = data_offset 
@@ -336,10 +422,14 @@ class Application:
                     
                     if relocation["symbol_name"] == ".data":
                         print("Rel: ", hex(relocation["symbol_value"]), "offset:", hex(offset), "section_code: ", section_code.value)
-                    if relocation["symbol_value"] < offset:
+                    if self.read_only and data_offset <= relocation["symbol_value"] < read_only_end:
+                        offset = self.__text_offset(original_offset) << 2 | SectionCode.Code.value
+                    elif relocation["symbol_value"] < offset:
                         if relocation["symbol_name"] == ".data":
                             print("But i take code...")
                         offset = original_offset << 2 | SectionCode.Code.value
+                    elif section_code == SectionCode.Data:
+                        offset = (self.__data_offset(original_offset) << 2) | section_code.value
                     else:
                         offset = ((original_offset - offset) << 2) | section_code.value 
 
@@ -347,6 +437,32 @@ class Application:
                         relocation, from_address, offset
                     )
 
+    def __resolve_read_only_relocation(self, relocation):
+        # read only data stays in flash, so pointers are resolved for flash
+        # address when image is built, only text can be targeted
+        index = relocation["section_index"]
+        if index != self.text_section["index"] and index != self.read_only_section["index"]:
+            self.logger.error(
+                "Read only data points to '{}' outside of text, it can't be kept in flash".format(
+                    relocation["symbol_name"]
+                )
+            )
+            raise RuntimeError("Data relocation processing failure")
+
+        from_address = relocation["offset"] - self.read_only_base
+        target = struct.unpack_from("<I", self.read_only, from_address)[0]
+        self.read_only_relocations.append((from_address, self.__text_offset(target)))
+
+    def __link_read_only_data(self, image, text_offset):
+        text_address = self.args.flash_address + text_offset
+        for from_address, target in self.read_only_relocations:
+            struct.pack_into(
+                "<I",
+                image,
+                text_offset + self.read_only_offset + from_address,
+                text_address + target,
+            )
+
     def __dump_local_relocations(self):
         self.logger.verbose("Dumping local relocations")
         rels = self.relocations.get_relocations("local")
@@ -478,19 +594,7 @@ class Application:
             if rel["type"] == "data":
                 continue
 
-            data_base = self.text 
-            relative_offset = rel["offset"]
-
-            if rel["offset"] > len(self.text):
-                if rel["offset"] > len(self.text) + len(self.init_arrays) + len(self.data):
-                    data_base = self.bss 
-                    relative_offset = rel["offset"] - len(self.text) - len(self.data) - len(self.init_arrays)
-                elif rel["offset"] > len(self.text) + len(self.init_arrays):
-                    data_base = self.data 
-                    relative_offset = rel["offset"] - len(self.text) - len(self.init_arrays)
-                else:
-                    data_base = self.init_arrays
-                    relative_offset = rel["offset"] - len(self.text)
+            data_base, relative_offset = self.__locate(rel["offset"])
             try: 
                 old = struct.unpack_from("<I", data_base, relative_offset)[0]
             except struct.error as err: 
@@ -509,19 +613,7 @@ class Application:
             if rel["type"] == "data":
                 continue
 
-            data_base = self.text 
-            relative_offset = rel["offset"]
-
-            if rel["offset"] > len(self.text):
-                if rel["offset"] > len(self.text) + len(self.init_arrays) + len(self.data):
-                    data_base = self.bss 
-                    relative_offset = rel["offset"] - len(self.text) - len(self.data) - len(self.init_arrays)
-                elif rel["offset"] > len(self.text) + len(self.init_arrays):
-                    data_base = self.data 
-                    relative_offset = rel["offset"] - len(self.text) - len(self.init_arrays)
-                else:
-                    data_base = self.init_arrays
-                    relative_offset = rel["offset"] - len(self.text)
+            data_base, relative_offset = self.__locate(rel["offset"])
  
             old = struct.unpack_from("<I", data_base, relative_offset)[0]
             new = rel["index"] * 4
@@ -536,12 +628,39 @@ class Application:
             "+-------------------+-------------------+-------------------+"
         )
 
+    def __locate(self, offset):
+        # section containing ELF offset and offset relative to that section
+        text_end = len(self.text)
+        init_end = text_end + len(self.init_arrays)
+        read_only_end = init_end + len(self.read_only)
+        data_end = read_only_end + len(self.data)
+        if offset > data_end:
+            return self.bss, offset - data_end
+        elif offset > read_only_end:
+            return self.data, offset - read_only_end
+        elif offset > init_end:
+            return self.read_only, offset - init_end
+        elif offset > text_end:
+            return self.init_arrays, offset - text_end
+        return self.text, offset
+
+    def __text_offset(self, address):
+        # read only data kept in flash is moved from behind init to end of text
+        if self.read_only and address >= self.read_only_base:
+            return address - self.read_only_base + self.read_only_offset
+        return address
+
+    def __data_offset(self, address):
+        return address - len(self.text) - len(self.init_arrays) - len(self.read_only)
+
     def __get_symbol_section(self, symbol):
         index = symbol["section_index"]
         if index == self.text_section["index"]:
             return SectionCode.Code
         elif self.init_arrays_section != None and index == self.init_arrays_section["index"]:
             return SectionCode.Init
+        elif self.read_only_section != None and index == self.read_only_section["index"]:
+            return SectionCode.Code if self.read_only else SectionCode.Data
         elif index == self.data_section["index"] or index == self.bss_section["index"]:
             return SectionCode.Data
         return None
@@ -552,9 +671,20 @@ class Application:
             return SectionCode.Code
         elif self.init_arrays_section != None and index == self.init_arrays_section["index"]:
             return SectionCode.Init
+        elif self.read_only_section != None and index == self.read_only_section["index"]:
+            return SectionCode.Code if self.read_only else SectionCode.Data
         elif index == self.data_section["index"] or index == self.bss_section["index"]:
             return SectionCode.Data
 
+    def __is_imported_function(self, name, data):
+        if data["type"] == "STT_FUNC":
+            return True
+        functions = getattr(self.args, "imported_functions", None) or []
+        for line in functions:
+            if name in line.replace(",", ";").split(";"):
+                return True
+        return False
+
     def __build_symbol_tables(self):
         self.exported_symbol_table = []
         self.imported_symbol_table = []
@@ -571,23 +701,35 @@ class Application:
                 )
 
             elif visibility == "imported":
+                # loader may bind functions lazily, any other import must be
+                # resolved at load time
                 self.imported_symbol_table.append(
                     {
-                        "section": self.__get_symbol_section(data),
+                        "section": SectionCode.Code
+                        if self.__is_imported_function(symbol, data)
+                        else SectionCode.Unknown,
                         "value": data["value"],
                         "name": symbol,
                     }
                 )
 
+        self.exported_symbol_hash = None
+        if getattr(self.args, "symbol_hash", True):
+            self.exported_symbol_hash = SymbolHashTable(self.exported_symbol_table)
+            # hash chains requires symbols from same bucket to be adjacent
+            self.exported_symbol_table = self.exported_symbol_hash.sort(
+                self.exported_symbol_table
+            )
+
     def __filter_relocations(self, visibility, skip_duplications):
         filtered = []
-        processed = []
+        processed = set()
 
         for rel in self.relocations.get_relocations(visibility):
             if rel["name"] in processed and skip_duplications:
                 continue
             filtered.append(rel)
-            processed.append(rel["name"])
+            processed.add(rel["name"])
         return filtered
 
     @staticmethod
@@ -601,9 +743,11 @@ class Application:
         for symbol in symbols:
             value = symbol["value"]
             if symbol["section"] == SectionCode.Data:
-                value -= (len(self.text) + len(self.init_arrays))
+                value = self.__data_offset(value)
             elif symbol["section"] == SectionCode.Init:
                 value -= len(self.text)
+            elif symbol["section"] == SectionCode.Code:
+                value = self.__text_offset(value)
             # if undefined treat same as text
             section = symbol["section"].value if symbol["section"] is not None else 0
             value = value << 2 | section
@@ -624,31 +768,26 @@ class Application:
     ):
         table = []
 
+        imported_indexes = {s["name"]: i for i, s in enumerate(imported_symbol_table)}
+        exported_indexes = {s["name"]: i for i, s in enumerate(exported_symbol_table)}
+
+        symbol_table = []
         for rel in symbol_table_relocations:
-            symbol = None
-            symbol_table_index = 0
-            for s in imported_symbol_table:
-                if s["name"] == rel["name"]:
-                    symbol = s
-                    break
-                else:
-                    symbol_table_index += 1
+            symbol_table_index = imported_indexes.get(rel["name"])
 
             # todo: reproduce in test
-            if symbol is None:
-                symbol_table_index = 0
-                for s in exported_symbol_table:
-                    if s["name"] == rel["name"]:
-                        symbol = s
-                        break
-                    else:
-                        symbol_table_index += 1
+            if symbol_table_index is None:
+                symbol_table_index = exported_indexes.get(rel["name"])
 
-            if not symbol:
+            if symbol_table_index is None:
                 raise RuntimeError(
                     "Symbol {} not found in symbol table.".format(rel["name"])
                 )
-            table.append({"index": rel["index"], "offset": symbol_table_index})
+            symbol_table.append({"index": rel["index"], "offset": symbol_table_index})
+
+        # loader walks symbol table with single cursor, so relocations must be
+        # ordered by symbol index to visit each symbol once
+        table += sorted(symbol_table, key=lambda rel: rel["offset"])
 
         for rel in local_relocations:
             section = self.__get_relocation_section(rel)
@@ -656,7 +795,9 @@ class Application:
             if section == SectionCode.Init:
                 value -= len(self.text)
             if section == SectionCode.Data:
-                value -= (len(self.text) + len(self.init_arrays))
+                value = self.__data_offset(value)
+            if section == SectionCode.Code:
+                value = self.__text_offset(value)
 
             if section == SectionCode.Unknown or section is None:
                 raise RuntimeError(
@@ -671,6 +812,22 @@ class Application:
 
         return table
 
+    def __get_fini_array_amount(self):
+        # linker scripts place .fini_array at end of .init_arrays, so loader
+        # needs only number of entries
+        if self.init_arrays_section is None:
+            return 0
+        symbols = self.elf.symbols
+        if "__fini_array_start" not in symbols or "__fini_array_end" not in symbols:
+            return 0
+        start = symbols["__fini_array_start"]["value"]
+        end = symbols["__fini_array_end"]["value"]
+        init_end = self.init_arrays_section["address"] + self.init_arrays_section["size"]
+        if end != init_end:
+            self.logger.error(".fini_array must be placed at end of .init_arrays")
+            raise RuntimeError("Fini array processing failed")
+        return (end - start) // 4
+
     def __build_image(self):
         self.logger.step("Building Yasiff image")
         image = bytearray("YAFF", "ascii")
@@ -681,13 +838,45 @@ class Application:
         else:
             module_type = 2
 
-        image += struct.pack("<BHB", module_type, 1, 1)  # dummy values for now
-        image += struct.pack("<IIII", len(self.text), len(self.init_arrays), len(self.data), len(self.bss)) 
+        image += struct.pack(
+            "<BHB", module_type, ARCHITECTURES[getattr(self.args, "arch", "armv6-m")], YASIFF_VERSION
+        )
+        text = self.text
+        if self.read_only:
+            # image address is stored in last word, so loader can verify that
+            # image is placed where read only data was linked for
+            text = (
+                self.text
+                + bytearray(self.read_only_offset - len(self.text))
+                + self.read_only
+                + struct.pack("<I", self.args.flash_address)
+            )
+        image += struct.pack("<IIII", len(text), len(self.init_arrays), len(self.data), len(self.bss)) 
         entry = 0xffffffff
         if not self.main_is_entry: 
             entry = self.elf.entry
         image += struct.pack("<I", entry)
-        image += struct.pack("<HBB", len(self.dependant_libraries), alignment, 0)
+        # header contains decompressed sizes, section directory stored ones
+        stored_text = text
+        compress = getattr(self.args, "compress", ())
+        if "text" in compress and not self.read_only:
+            stored_text = self.__compress("text", text)
+        stored_data = self.data
+        if "data" in compress:
+            stored_data = self.__compress("data", self.data)
+        flags = 0
+        if self.exported_symbol_hash is not None:
+            flags |= HeaderFlags.ExportedSymbolsHash
+        flags |= HeaderFlags.ImportedFunctions
+        if any(s["name"] == LOT_BASE_SYMBOL for s in self.exported_symbol_table):
+            flags |= HeaderFlags.DirectCalls
+        if self.read_only:
+            flags |= HeaderFlags.ReadOnlyDataInText
+        if stored_text is not text:
+            flags |= HeaderFlags.CompressedText
+        if stored_data is not self.data:
+            flags |= HeaderFlags.CompressedData
+        image += struct.pack("<HBB", len(self.dependant_libraries), alignment, flags)
         image += struct.pack("<HH", 0, 0)
 
         symbol_table_relocations = self.__filter_relocations("symbol_table", True)
@@ -699,7 +888,7 @@ class Application:
             len(symbol_table_relocations),
             len(local_relocations),
             len(data_relocations),
-            0,  # TODO: Update header
+            self.__get_fini_array_amount(),
         )
 
         exported_symbol_table = self.__build_binary_symbol_table_for(
@@ -721,37 +910,84 @@ class Application:
         image += struct.pack(
             "<HH", len(self.exported_symbol_table), len(self.imported_symbol_table)
         )
-        image += Application.__align_bytes(
-            bytearray(Path(self.args.input).stem + "\0", "ascii"), alignment
+
+        # section directory is filled when all sections are placed
+        directory_offset = len(image)
+        image += bytearray(SECTION_DIRECTORY_SIZE)
+        directory = []
+
+        def add_section(data, size=None, align_to=1):
+            nonlocal image
+            image = Application.__align_bytes(image, align_to)
+            directory.append((len(image), len(data) if size is None else size))
+            image += data
+
+        name = Path(self.args.input).stem
+        add_section(
+            Application.__align_bytes(bytearray(name + "\0", "ascii"), alignment),
+            size=len(name) + 1,
         )
 
+        libraries = bytearray()
         for lib in self.dependant_libraries:
-            image += Application.__align_bytes(
+            libraries += Application.__align_bytes(
                 bytearray(lib + "\0", "ascii"), alignment
             )
+        add_section(libraries)
 
-        for rel in relocations:
-            image += struct.pack("<II", rel["index"], rel["offset"])
-
-        image += imported_symbol_table
-        image += exported_symbol_table
-
-        image = Application.__align_bytes(image, 16)
-        image += self.text
-        image += self.init_arrays
-        image += self.data
+        binary_relocations = [
+            struct.pack("<II", rel["index"], rel["offset"]) for rel in relocations
+        ]
+        local_start = len(symbol_table_relocations)
+        data_start = local_start + len(local_relocations)
+        add_section(b"".join(binary_relocations[:local_start]))
+        add_section(b"".join(binary_relocations[local_start:data_start]))
+        add_section(b"".join(binary_relocations[data_start:]))
+
+        add_section(imported_symbol_table)
+        add_section(exported_symbol_table)
+        if self.exported_symbol_hash is not None:
+            add_section(self.exported_symbol_hash.build(self.exported_symbol_table))
+        else:
+            add_section(bytearray())
+
+        add_section(stored_text, align_to=16)
+        if self.read_only:
+            self.__link_read_only_data(image, directory[-1][0])
+        add_section(self.init_arrays)
+        add_section(stored_data)
+
+        packed_directory = bytearray()
+        for offset, size in directory:
+            packed_directory += struct.pack("<II", offset, size)
+        image[directory_offset : directory_offset + SECTION_DIRECTORY_SIZE] = (
+            packed_directory
+        )
         self.image = image
         if not self.args.dryrun:
             self.logger.info("Writing to: " + self.args.output)
             with open(self.args.output, "wb") as file:
                 file.write(image)
 
+    def __compress(self, name, data):
+        compressed = lz4.compress(data)
+        if len(data) == 0 or len(compressed) >= len(data):
+            self.logger.info(name + " kept uncompressed")
+            return data
+        self.logger.info(
+            "Compressed {}: {} -> {} bytes ({:.1f}%)".format(
+                name, len(data), len(compressed), 100 * len(compressed) / len(data)
+            )
+        )
+        return compressed
+
     def __resolve_dependant_libraries(self):
         self.dependant_libraries = []
-        if args.libraries is None:
+        libraries = getattr(self.args, "libraries", None)
+        if libraries is None:
             return
 
-        for line in args.libraries:
+        for line in libraries:
             self.dependant_libraries += line.replace(",", ";").split(";")
 
         self.logger.info("Module depends on:")
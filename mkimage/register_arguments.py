@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+#
+# register_arguments.py
+#
+# Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+#
+# This program is free software: you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation, either version
+# 3 of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be
+# useful, but WITHOUT ANY WARRANTY; without even the implied
+# warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+# PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General
+# Public License along with this program. If not, see
+# <https://www.gnu.org/licenses/>.
+#
+
+# Finds functions which receive all arguments in R0-R3, read from DWARF of
+# object file. Direct call wrappers store caller state on stack, so functions
+# reading arguments from stack (more than 4 words, variadic) can't use them.
+# Function without debug information or with argument of unknown size is
+# treated as one using stack.
+
+from elftools.elf.elffile import ELFFile
+
+ARGUMENT_REGISTERS = 4
+WORD_SIZE = 4
+
+POINTER_TYPES = (
+    "DW_TAG_pointer_type",
+    "DW_TAG_reference_type",
+    "DW_TAG_rvalue_reference_type",
+)
+
+COMPOSITE_TYPES = (
+    "DW_TAG_structure_type",
+    "DW_TAG_class_type",
+    "DW_TAG_union_type",
+    "DW_TAG_array_type",
+)
+
+
+def _referenced(die, attribute):
+    if attribute not in die.attributes:
+        return None
+    return die.get_DIE_from_attribute(attribute)
+
+
+def _origin_of(die):
+    # definition of C++ function refers to declaration, concrete instance of
+    # inline function refers to abstract one
+    origin = _referenced(die, "DW_AT_specification")
+    if origin is None:
+        origin = _referenced(die, "DW_AT_abstract_origin")
+    return origin
+
+
+def _type_of(die):
+    while die is not None and "DW_AT_type" not in die.attributes:
+        die = _origin_of(die)
+    return _referenced(die, "DW_AT_type") if die is not None else None
+
+
+def _type_size(die):
+    # typedefs and qualifiers are followed to type with size
+    while die is not None:
+        if "DW_AT_byte_size" in die.attributes:
+            return die.attributes["DW_AT_byte_size"].value
+        if die.tag in POINTER_TYPES:
+            return WORD_SIZE
+        die = _referenced(die, "DW_AT_type")
+    return None
+
+
+def _is_composite(die):
+    while die is not None and die.tag not in COMPOSITE_TYPES:
+        die = _referenced(die, "DW_AT_type")
+    return die is not None
+
+
+def _name_of(die):
+    # mangled name of C++ function may be kept only by its declaration
+    while die is not None:
+        for attribute in ("DW_AT_linkage_name", "DW_AT_MIPS_linkage_name"):
+            if attribute in die.attributes:
+                return die.attributes[attribute].value.decode("utf-8")
+        origin = _origin_of(die)
+        if origin is None:
+            break
+        die = origin
+    if die is not None and "DW_AT_name" in die.attributes:
+        return die.attributes["DW_AT_name"].value.decode("utf-8")
+    return None
+
+
+def _used_registers(function):
+    registers = 0
+    return_type = _type_of(function)
+    # composite returned in memory is written through pointer passed in R0
+    if return_type is not None and _is_composite(return_type):
+        size = _type_size(return_type)
+        if size is None or size > WORD_SIZE:
+            registers += 1
+
+    for child in function.iter_children():
+        if child.tag == "DW_TAG_unspecified_parameters":
+            return None
+        if child.tag != "DW_TAG_formal_parameter":
+            continue
+        size = _type_size(_type_of(child))
+        if size is None:
+            return None
+        words = (size + WORD_SIZE - 1) // WORD_SIZE
+        # doubleword aligned arguments start at even register, alignment
+        # isn't known, so each argument of doubleword size is aligned
+        if size % (2 * WORD_SIZE) == 0 and registers % 2 != 0:
+            registers += 1
+        registers += words
+    return registers
+
+
+def find_register_argument_functions(filename):
+    functions = {}
+    with open(filename, "rb") as file:
+        elf = ELFFile(file)
+        if not elf.has_dwarf_info():
+            return set()
+        for unit in elf.get_dwarf_info().iter_CUs():
+            for die in unit.iter_DIEs():
+                # only definitions list parameters of exported function
+                if die.tag != "DW_TAG_subprogram" or (
+                    "DW_AT_low_pc" not in die.attributes
+                    and "DW_AT_ranges" not in die.attributes
+                ):
+                    continue
+                name = _name_of(die)
+                if name is None:
+                    continue
+                registers = _used_registers(die)
+                fits = registers is not None and registers <= ARGUMENT_REGISTERS
+                functions[name] = functions.get(name, True) and fits
+    return {name for name, fits in functions.items() if fits}
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+#
+# symbol_hash.py
+#
+# Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+#
+# This program is free software: you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation, either version
+# 3 of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be
+# useful, but WITHOUT ANY WARRANTY; without even the implied
+# warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+# PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General
+# Public License along with this program. If not, see
+# <https://www.gnu.org/licenses/>.
+#
+
+import struct
+
+BLOOM_SHIFT = 6
+EMPTY_BUCKET = 0xFFFFFFFF
+
+
+def symbol_hash(name):
+    # dl_new_hash, must be in sync with SymbolHashTable::hash
+    h = 5381
+    for c in name.encode("ascii"):
+        h = (h * 33 + c) & 0xFFFFFFFF
+    return h
+
+
+def _next_power_of_two(value):
+    result = 1
+    while result < value:
+        result <<= 1
+    return result
+
+
+def _symbol_entry_size(name):
+    length = len(name) + 1
+    if length % 4 != 0:
+        length += 4 - length % 4
+    return 4 + length
+
+
+class SymbolHashTable:
+    def __init__(self, names):
+        self.number_of_buckets = max(1, len(names) // 2)
+        self.bloom_size = _next_power_of_two(max(1, len(names) // 8))
+
+    def bucket(self, name):
+        return symbol_hash(name) % self.number_of_buckets
+
+    # Exported symbol table must be sorted by bucket before building binary
+    def sort(self, symbols):
+        return sorted(symbols, key=lambda symbol: self.bucket(symbol["name"]))
+
+    def build(self, symbols):
+        bloom = [0] * self.bloom_size
+        buckets = [EMPTY_BUCKET] * self.number_of_buckets
+        chain = []
+        offsets = []
+        offset = 0
+
+        for index, symbol in enumerate(symbols):
+            name = symbol["name"]
+            h = symbol_hash(name)
+            bloom[(h // 32) & (self.bloom_size - 1)] |= (1 << (h % 32)) | (
+                1 << ((h >> BLOOM_SHIFT) % 32)
+            )
+            bucket = h % self.number_of_buckets
+            if buckets[bucket] == EMPTY_BUCKET:
+                buckets[bucket] = index
+            is_last = (
+                index + 1 == len(symbols)
+                or self.bucket(symbols[index + 1]["name"]) != bucket
+            )
+            chain.append((h & ~1) | (1 if is_last else 0))
+            offsets.append(offset)
+            offset += _symbol_entry_size(name)
+
+        table = bytearray()
+        table += struct.pack(
+            "<III", self.number_of_buckets, self.bloom_size, BLOOM_SHIFT
+        )
+        for value in bloom + buckets + chain + offsets:
+            table += struct.pack("<I", value & 0xFFFFFFFF)
+        return table
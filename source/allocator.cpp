@@ -43,4 +43,36 @@ ReleaseType &YasldAllocatorHolder::get_release()
   return release_;
 }
 
+void *YasldAllocatorHolder::allocate(std::size_t size, AllocationType type)
+{
+  if (!allocator_)
+  {
+    return nullptr;
+  }
+  void *data = allocator_(size, type);
+  if (data != nullptr)
+  {
+    usage_.add(type, size);
+  }
+  return data;
+}
+
+void YasldAllocatorHolder::release(
+  void          *data,
+  std::size_t    size,
+  AllocationType type)
+{
+  if (data == nullptr || !release_)
+  {
+    return;
+  }
+  usage_.remove(type, size);
+  release_(data);
+}
+
+MemoryUsage &YasldAllocatorHolder::get_usage()
+{
+  return usage_;
+}
+
 } // namespace yasld
@@ -20,9 +20,46 @@
 
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
 
-constexpr static int          resolve_lot_svc_id = 10;
+#include "yasld/header.hpp"
+
+namespace yasld
+{
+
+// armv7-m and armv8-m.main share this header, so architecture of core is
+// taken from -mcpu used to build loader
+#if defined(__ARM_ARCH_8M_MAIN__)
+constexpr static Header::Architecture architecture =
+  Header::Architecture::Armv8_m_main;
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+constexpr static Header::Architecture architecture =
+  Header::Architecture::Armv7_m;
+#else
+constexpr static Header::Architecture architecture =
+  Header::Architecture::Armv6_m;
+#endif
+
+} // namespace yasld
+
+constexpr static int         resolve_lot_svc_id   = 10;
+constexpr static int         lazy_binding_svc_id  = 12;
+
+constexpr static bool        lazy_binding_supported = true;
+// Lazy binding thunk, followed by record and resolver addresses:
+//   push {r0-r3}
+//   ldr  r0, [pc, #4]
+//   ldr  r1, [pc, #4]
+//   bx   r1
+constexpr static uint16_t    lazy_binding_thunk[] = { 0xb40f,
+                                                      0x4801,
+                                                      0x4901,
+                                                      0x4708 };
+// Thumb state bit for thunk address stored in LOT
+constexpr static std::size_t lazy_binding_thunk_flags = 1;
+
+extern "C" void              yasld_lazy_binding_resolver();
 
 static __inline__ std::size_t get_pc(void)
 {
@@ -26,6 +26,22 @@
 
 namespace yasld
 {
-void process_entry_supervisor_call(Loader *loader, std::size_t *args);
-void process_exit_supervisor_call(Loader *loader, std::size_t *args);
+// Assembler names are used by SVC_Handler, see supervisor_call_handler.S
+void process_entry_supervisor_call(Loader *loader, std::size_t *args) asm(
+  "yasld_process_entry_supervisor_call");
+void process_exit_supervisor_call(Loader *loader, std::size_t *args) asm(
+  "yasld_process_exit_supervisor_call");
+// Raised from lazy binding thunk on first call of imported function
+void process_lazy_binding_supervisor_call(
+  Loader      *loader,
+  std::size_t *args) asm("yasld_process_lazy_binding_supervisor_call");
+
+// Called by SVC_Handler for services not handled by yasld, frame points to
+// registers stacked on exception entry: r0-r3, r12, lr, pc, xpsr
+using SupervisorCallChain = void (*)(std::size_t svc_id, std::size_t *frame);
+
+// SVC_Handler provided by yasld dispatches services to this loader, must be
+// set before first call into module
+void set_supervisor_call_loader(Loader &loader);
+void set_supervisor_call_chain(SupervisorCallChain chain);
 } // namespace yasld
@@ -20,13 +20,46 @@
 
 #include "yasld/supervisor_call.hpp"
 
+#include <cstddef>
 #include <cstdlib>
 
+#include "yasld/lazy_binding.hpp"
 #include "yasld/logger.hpp"
 
 namespace yasld
 {
 
+static_assert(
+  offsetof(LazyBinding, self) == 8 && offsetof(LazyBinding, resolver) == 12,
+  "Lazy binding thunk loads record and resolver from fixed offsets");
+
+// Defined with SVC_Handler in supervisor_call_handler.S
+extern Loader *supervisor_call_loader asm("yasld_supervisor_call_loader");
+extern SupervisorCallChain supervisor_call_chain asm(
+  "yasld_supervisor_call_chain");
+
+namespace
+{
+
+// Called instead of function which can't be resolved, with arguments and
+// return address of original call, so fault points at failed call
+[[noreturn]] void unresolved_function()
+{
+  std::abort();
+}
+
+} // namespace
+
+void set_supervisor_call_loader(Loader &loader)
+{
+  supervisor_call_loader = &loader;
+}
+
+void set_supervisor_call_chain(SupervisorCallChain chain)
+{
+  supervisor_call_chain = chain;
+}
+
 void process_entry_supervisor_call(Loader *loader, std::size_t *args)
 {
   const std::size_t r4 = args[2];
@@ -34,38 +67,45 @@ void process_entry_supervisor_call(Loader *loader, std::size_t *args)
   const std::size_t lr = args[3];
   const std::size_t pc = args[0];
 
-  // find parent module
-  Module *m = loader->find_module_for_pc_and_lot(pc, r9);
-
-  if (m == nullptr)
+  const auto lot =
+    loader->enter_module(pc, r9, { .r9 = r9, .lr = lr, .tmpReg = { r4 } });
+  if (!lot)
   {
-    log("Can't find module at 0x%x\n", pc);
-    // TODO: implement panic
-    return;
+    log("Call into module failed at 0x%x\n", pc);
+    // wrapper would use args[0] as LOT of called module, call can't
+    // continue
+    std::abort();
   }
-
-  m->save_caller_state({
-    .r9 = r9, .lr = lr, .tmpReg = {r4}
-  });
-  m->set_active(true);
-  args[0] = reinterpret_cast<std::size_t>(m->get_lot().data());
+  args[0] = *lot;
 }
 
 void process_exit_supervisor_call(Loader *loader, std::size_t *args)
 {
-  const std::size_t pc = args[0];
-  yasld::Module *m = loader->find_active_module(pc);
-  if (m == nullptr)
+  const auto context = loader->exit_module();
+  if (!context)
+  {
+    log("Return from module failed, caller state is lost\n");
+    // wrapper would return to stale lr with caller r9 and r4 unrestored
+    std::abort();
+  }
+  args[0] = context->lr;
+  args[1] = context->r9;
+  args[2] = context->tmpReg[0];
+}
+
+void process_lazy_binding_supervisor_call(Loader *loader, std::size_t *args)
+{
+  LazyBinding *binding = reinterpret_cast<LazyBinding *>(args[0]);
+  const auto   address = loader->resolve_lazy_binding(*binding);
+  if (!address)
   {
-    log("Danger module destroyed during work, system state is unknown\n");
-    // TODO: implement panic
+    log("Lazy binding failed for LOT[%d]\n", binding->lot_index);
+    // args[0] still points at record, which thunk would branch into. LOT is
+    // not patched, so each call of unresolved function faults
+    args[0] = reinterpret_cast<std::size_t>(&unresolved_function);
     return;
   }
-  m->set_active(false);
-  const auto s = m->restore_caller_state();
-  args[0]      = s.lr;
-  args[1]      = s.r9;
-  args[2]      = s.tmpReg[0];
+  args[0] = *address;
 }
 
 } // namespace yasld
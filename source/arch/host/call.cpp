@@ -18,19 +18,105 @@
  * <https://www.gnu.org/licenses/>.
  */
 
+#include "yasld/host_call.hpp"
+
 #include <cstdlib>
 
+#include "yasld/loader.hpp"
+
+namespace yasld
+{
+
+namespace
+{
+
+thread_local std::size_t current_lot = 0;
+
+// Restores LOT of caller when called function returns
+class LotGuard
+{
+public:
+  explicit LotGuard(const void *lot)
+    : caller_lot_{ current_lot }
+  {
+    current_lot = reinterpret_cast<std::size_t>(lot);
+  }
+
+  LotGuard(const LotGuard &) = delete;
+
+  ~LotGuard()
+  {
+    current_lot = caller_lot_;
+  }
+
+private:
+  std::size_t caller_lot_;
+};
+
+} // namespace
+
+std::size_t get_current_lot()
+{
+  return current_lot;
+}
+
+void set_current_lot(std::size_t lot)
+{
+  current_lot = lot;
+}
+
+bool enter_module_call(Loader &loader, std::size_t program_counter)
+{
+  const auto lot = loader.enter_module(
+    program_counter, current_lot, { .lot = current_lot });
+  if (!lot)
+  {
+    return false;
+  }
+  current_lot = *lot;
+  return true;
+}
+
+bool exit_module_call(Loader &loader)
+{
+  const auto context = loader.exit_module();
+  if (!context)
+  {
+    return false;
+  }
+  current_lot = context->lot;
+  return true;
+}
+
+} // namespace yasld
+
 extern "C"
 {
 
+  // Addresses are native functions, text of host modules must be placed in
+  // executable memory
   int call_main(
-    int          argc,
-    char        *argv[],
-    std::size_t  main_address,
-    std::size_t *lot)
+    int         argc,
+    char       *argv[],
+    std::size_t main_address,
+    const void *lot)
+  {
+    using MainType = int (*)(int, char *[]);
+    yasld::LotGuard guard(lot);
+    return reinterpret_cast<MainType>(main_address)(argc, argv);
+  }
+
+  int call_entry(std::size_t address, const void *lot)
+  {
+    using EntryType = int (*)();
+    yasld::LotGuard guard(lot);
+    return reinterpret_cast<EntryType>(address)();
+  }
+
+  // Lazy binding is rejected on host, so resolver is never reached
+  void yasld_lazy_binding_resolver()
   {
-    // TODO: implement smarter stub
-    return 0;
+    std::abort();
   }
 
 } // extern "C"
@@ -20,6 +20,31 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstdlib>
+
+#include "yasld/header.hpp"
+
+namespace yasld
+{
+
+// Synthetic images executed on host are accepted for each architecture
+constexpr static Header::Architecture architecture =
+  Header::Architecture::Armv8_m_main;
+
+} // namespace yasld
+
+// Host has no thunk calling resolver, Loader::set_lazy_binding is rejected
+// and placeholders below are never written to LOT
+constexpr static bool        lazy_binding_supported   = false;
+constexpr static uint16_t    lazy_binding_thunk[]     = { 0, 0, 0, 0 };
+constexpr static std::size_t lazy_binding_thunk_flags = 0;
+
+extern "C" void              yasld_lazy_binding_resolver();
+
+// Host has no pinned LOT register, LOT of running module is kept in thread
+// local variable instead, see host_call.hpp
 struct ForeignCallContext
 {
+  std::size_t lot;
 };
@@ -0,0 +1,42 @@
+/**
+ * host_call.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdlib>
+
+namespace yasld
+{
+
+class Loader;
+
+// Host equivalent of R9. Code of host modules reads LOT of running module
+// from thread local variable, call_main and call_entry switch it for
+// called module.
+std::size_t get_current_lot();
+void        set_current_lot(std::size_t lot);
+
+// Host equivalent of entry and exit supervisor calls, called by wrappers of
+// functions exported from modules. Entry switches current LOT to module
+// containing program counter, exit restores LOT of caller.
+bool        enter_module_call(Loader &loader, std::size_t program_counter);
+bool        exit_module_call(Loader &loader);
+
+} // namespace yasld
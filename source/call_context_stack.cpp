@@ -0,0 +1,114 @@
+/**
+ * call_context_stack.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/call_context_stack.hpp"
+
+#include <algorithm>
+
+#include "yasld/logger.hpp"
+#include "yasld/module.hpp"
+
+namespace yasld
+{
+
+CallContextStack::CallContextStack(std::size_t capacity)
+  : entries_{}
+  , capacity_{ capacity }
+{
+}
+
+bool CallContextStack::allocate()
+{
+  // allocator returns nullptr on failure
+  entries_.reserve(capacity_);
+  if (entries_.capacity() < capacity_ || entries_.data() == nullptr)
+  {
+    log("Call context stack allocation failure\n");
+    return false;
+  }
+  return true;
+}
+
+bool CallContextStack::push(Module &module, const ForeignCallContext &context)
+{
+  // push below can't reallocate when memory is allocated
+  if (entries_.capacity() < capacity_ || entries_.data() == nullptr)
+  {
+    log("Call context stack not allocated\n");
+    return false;
+  }
+
+  if (entries_.size() == capacity_)
+  {
+    log("Call context stack overflow, depth: %d\n", capacity_);
+    return false;
+  }
+
+  entries_.push_back({ .module = &module, .context = context });
+  module.enter();
+  return true;
+}
+
+std::optional<CallContextStack::Entry> CallContextStack::pop()
+{
+  if (entries_.empty())
+  {
+    return std::nullopt;
+  }
+  const Entry entry = entries_.back();
+  entries_.pop_back();
+  entry.module->leave();
+  return entry;
+}
+
+void CallContextStack::clear()
+{
+  while (pop())
+  {
+  }
+}
+
+bool CallContextStack::contains(const Module &module) const
+{
+  return std::any_of(
+    entries_.begin(),
+    entries_.end(),
+    [&module](const Entry &entry)
+    {
+      return entry.module == &module;
+    });
+}
+
+bool CallContextStack::empty() const
+{
+  return entries_.empty();
+}
+
+std::size_t CallContextStack::size() const
+{
+  return entries_.size();
+}
+
+std::size_t CallContextStack::capacity() const
+{
+  return capacity_;
+}
+
+} // namespace yasld
@@ -47,12 +47,30 @@ std::string_view to_string(const Header::Architecture arch)
   {
   case Header::Architecture::Armv6_m:
     return "armv6-m";
+  case Header::Architecture::Armv7_m:
+    return "armv7-m";
+  case Header::Architecture::Armv8_m_main:
+    return "armv8-m.main";
   case Header::Architecture::Unknown:
     return "unknown";
   }
   return "unknown";
 }
 
+bool Header::has(Flag flag) const
+{
+  return (flags & static_cast<uint8_t>(flag)) != 0;
+}
+
+const SectionDirectory *Header::section_directory() const
+{
+  if (yasiff_version < version_with_directory)
+  {
+    return nullptr;
+  }
+  return reinterpret_cast<const SectionDirectory *>(this + 1);
+}
+
 void print(const Header &header)
 {
   log("Cookie: %.4s\n", header.cookie);
@@ -66,11 +84,13 @@ void print(const Header &header)
   log("  .bss:  %u B\n", header.bss_length);
   log("External libraries amount: %u\n", header.external_libraries_amount);
   log("Alignment: %u\n", header.alignment);
+  log("Flags: 0x%x\n", header.flags);
   log("Version: %u.%u\n", header.version_major, header.version_minor);
   log("Relocations amount:\n");
   log("  symtab: %u\n", header.symbol_table_relocations_amount);
   log("  local:  %u\n", header.local_relocations_amount);
   log("  data:   %u\n", header.data_relocations_amount);
+  log("Fini array amount: %u\n", header.fini_array_amount);
   log("Symbol table size:\n");
   log("  exported: %u\n", header.exported_symbols_amount);
   log("  external: %u\n", header.imported_symbols_amount);
@@ -20,10 +20,15 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdlib>
+#include <span>
+#include <type_traits>
 
 #include <eul/functional/function.hpp>
 
+#include "yasld/memory_usage.hpp"
+
 namespace yasld
 {
 enum class AllocationType : uint8_t
@@ -31,7 +36,19 @@ enum class AllocationType : uint8_t
   OffsetTable,
   Data,
   Init,
-  Module
+  Module,
+  // Contains thunks, memory must be executable
+  LazyBinding,
+  // Text of module loaded from ImageSource or with direct calls, memory must
+  // be executable
+  Text,
+  // Header and tables of module loaded from ImageSource
+  Image,
+  // Caller states saved by supervisor calls
+  CallContext,
+  // Module with LOT, init, data and imported modules in single block, used
+  // instead of OffsetTable, Data, Init and Module when arena is enabled
+  Arena
 };
 
 using AllocatorType =
@@ -52,10 +69,16 @@ public:
   AllocatorType &get_allocator();
   ReleaseType   &get_release();
 
+  // Memory allocated and released through these is accounted in usage
+  void          *allocate(std::size_t size, AllocationType type);
+  void           release(void *data, std::size_t size, AllocationType type);
+  MemoryUsage   &get_usage();
+
 private:
   YasldAllocatorHolder() = default;
   AllocatorType allocator_;
   ReleaseType   release_;
+  MemoryUsage   usage_;
 };
 
 template <typename T>
@@ -66,22 +89,13 @@ public:
 
   T *allocate(std::size_t n, AllocationType alloc_type) noexcept
   {
-    auto &alloc = YasldAllocatorHolder::get().get_allocator();
-    if (alloc)
-    {
-      return static_cast<T *>(alloc(n * sizeof(T), alloc_type));
-    }
-    return nullptr;
+    return static_cast<T *>(
+      YasldAllocatorHolder::get().allocate(n * sizeof(T), alloc_type));
   }
 
-  void deallocate(T *p, std::size_t n) noexcept
+  void deallocate(T *p, std::size_t n, AllocationType alloc_type) noexcept
   {
-    static_cast<void>(n);
-    auto &release = YasldAllocatorHolder::get().get_release();
-    if (release)
-    {
-      return release(p);
-    }
+    YasldAllocatorHolder::get().release(p, n * sizeof(T), alloc_type);
   }
 };
 
@@ -95,6 +109,11 @@ public:
   {
     return YasldAllocator<T>::allocate(n, AllocationType::Module);
   }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    YasldAllocator<T>::deallocate(p, n, AllocationType::Module);
+  }
 };
 
 template <typename T>
@@ -107,6 +126,11 @@ public:
   {
     return YasldAllocator<T>::allocate(n, AllocationType::OffsetTable);
   }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    YasldAllocator<T>::deallocate(p, n, AllocationType::OffsetTable);
+  }
 };
 
 template <typename T>
@@ -119,6 +143,11 @@ public:
   {
     return YasldAllocator<T>::allocate(n, AllocationType::Data);
   }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    YasldAllocator<T>::deallocate(p, n, AllocationType::Data);
+  }
 };
 
 template <typename T>
@@ -131,6 +160,182 @@ public:
   {
     return YasldAllocator<T>::allocate(n, AllocationType::Init);
   }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    YasldAllocator<T>::deallocate(p, n, AllocationType::Init);
+  }
+};
+
+template <typename T>
+class LazyBindingAllocator : public YasldAllocator<T>
+{
+public:
+  using value_type = T;
+
+  T *allocate(std::size_t n) noexcept
+  {
+    return YasldAllocator<T>::allocate(n, AllocationType::LazyBinding);
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    YasldAllocator<T>::deallocate(p, n, AllocationType::LazyBinding);
+  }
+};
+
+template <typename T>
+class TextAllocator : public YasldAllocator<T>
+{
+public:
+  using value_type = T;
+
+  T *allocate(std::size_t n) noexcept
+  {
+    return YasldAllocator<T>::allocate(n, AllocationType::Text);
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    YasldAllocator<T>::deallocate(p, n, AllocationType::Text);
+  }
+};
+
+template <typename T>
+class ImageAllocator : public YasldAllocator<T>
+{
+public:
+  using value_type = T;
+
+  T *allocate(std::size_t n) noexcept
+  {
+    return YasldAllocator<T>::allocate(n, AllocationType::Image);
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    YasldAllocator<T>::deallocate(p, n, AllocationType::Image);
+  }
+};
+
+template <typename T>
+class CallContextAllocator : public YasldAllocator<T>
+{
+public:
+  using value_type = T;
+
+  T *allocate(std::size_t n) noexcept
+  {
+    return YasldAllocator<T>::allocate(n, AllocationType::CallContext);
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    YasldAllocator<T>::deallocate(p, n, AllocationType::CallContext);
+  }
+};
+
+template <typename T>
+class ArenaAllocator : public YasldAllocator<T>
+{
+public:
+  using value_type = T;
+
+  T *allocate(std::size_t n) noexcept
+  {
+    return YasldAllocator<T>::allocate(n, AllocationType::Arena);
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    YasldAllocator<T>::deallocate(p, n, AllocationType::Arena);
+  }
+};
+
+// Takes memory from region carved out of module arena, region is released
+// with whole arena. Allocation that doesn't fit in region, is made while
+// region is taken, or made without region, is passed to Base.
+template <typename T, template <typename> class Base>
+class RegionAllocator : public Base<T>
+{
+public:
+  using value_type                             = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap            = std::true_type;
+
+  template <typename U>
+  struct rebind
+  {
+    using other = RegionAllocator<U, Base>;
+  };
+
+  RegionAllocator() = default;
+
+  explicit RegionAllocator(std::span<std::byte> region)
+    : region_{ region }
+  {
+  }
+
+  T *allocate(std::size_t n) noexcept
+  {
+    if (!in_use_ && !region_.empty() && n * sizeof(T) <= region_.size())
+    {
+      in_use_ = true;
+      return reinterpret_cast<T *>(region_.data());
+    }
+    return Base<T>::allocate(n);
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept
+  {
+    if (contains(p))
+    {
+      in_use_ = false;
+      return;
+    }
+    Base<T>::deallocate(p, n);
+  }
+
+  // True when memory was taken from region instead of Base
+  bool contains(const T *p) const
+  {
+    return !region_.empty() && reinterpret_cast<const std::byte *>(p) ==
+                                  region_.data();
+  }
+
+  bool operator==(const RegionAllocator &other) const
+  {
+    return region_.data() == other.region_.data();
+  }
+
+private:
+  std::span<std::byte> region_;
+  // Region holds single allocation, i.e. old buffer of growing container
+  bool                 in_use_ = false;
+};
+
+// Releases memory allocated from other source than loader allocator, i.e.
+// memory region registered in loader
+class RegionDeleter
+{
+public:
+  RegionDeleter() = default;
+
+  explicit RegionDeleter(const ReleaseType &release)
+    : release_{ release }
+  {
+  }
+
+  void operator()(std::byte *p) const
+  {
+    if (release_)
+    {
+      release_(p);
+    }
+  }
+
+private:
+  ReleaseType release_;
 };
 
 template <typename T>
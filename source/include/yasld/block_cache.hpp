@@ -0,0 +1,177 @@
+/**
+ * block_cache.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "yasld/image_source.hpp"
+
+namespace yasld
+{
+
+// Least recently used cache of storage blocks. Sequential reads fetch next
+// block ahead, so streaming text and data costs single storage access per
+// block even when loader reads smaller chunks.
+template <std::size_t BlockSize, std::size_t NumberOfBlocks>
+class BlockCache : public ImageSource
+{
+public:
+  static_assert(NumberOfBlocks >= 2, "Read-ahead needs at least two blocks");
+
+  explicit BlockCache(ImageSource &storage)
+    : storage_{ storage }
+    , blocks_{}
+    , clock_{ 0 }
+    , next_offset_{ 0 }
+  {
+  }
+
+  bool read(std::size_t offset, std::span<std::byte> buffer) override
+  {
+    if (offset + buffer.size() > storage_.size())
+    {
+      return false;
+    }
+
+    const bool sequential = offset == next_offset_;
+    next_offset_          = offset + buffer.size();
+
+    while (!buffer.empty())
+    {
+      const std::size_t block_offset = offset - offset % BlockSize;
+      const Block      *block        = fetch(block_offset);
+      if (block == nullptr)
+      {
+        return false;
+      }
+
+      const std::size_t position = offset - block_offset;
+      const std::size_t size = std::min(buffer.size(), BlockSize - position);
+      std::memcpy(buffer.data(), block->data.data() + position, size);
+      buffer  = buffer.subspan(size);
+      offset += size;
+
+      if (sequential && buffer.empty())
+      {
+        read_ahead(block_offset + BlockSize);
+      }
+    }
+    return true;
+  }
+
+  std::size_t size() const override
+  {
+    return storage_.size();
+  }
+
+  void invalidate()
+  {
+    for (auto &block : blocks_)
+    {
+      block.offset = invalid_offset;
+    }
+    next_offset_ = 0;
+  }
+
+private:
+  constexpr static std::size_t invalid_offset =
+    std::numeric_limits<std::size_t>::max();
+
+  struct Block
+  {
+    std::size_t                      offset = invalid_offset;
+    uint32_t                         used   = 0;
+    std::array<std::byte, BlockSize> data{};
+  };
+
+  Block *find(std::size_t offset)
+  {
+    for (auto &block : blocks_)
+    {
+      if (block.offset == offset)
+      {
+        return &block;
+      }
+    }
+    return nullptr;
+  }
+
+  Block *load(std::size_t offset)
+  {
+    Block *block = std::min_element(
+      blocks_.begin(),
+      blocks_.end(),
+      [](const Block &a, const Block &b)
+      {
+        return a.used < b.used;
+      });
+
+    const std::size_t size = std::min(BlockSize, storage_.size() - offset);
+    block->offset          = invalid_offset;
+    if (!storage_.read(offset, std::span(block->data).first(size)))
+    {
+      return nullptr;
+    }
+    block->offset = offset;
+    return block;
+  }
+
+  const Block *fetch(std::size_t offset)
+  {
+    Block *block = find(offset);
+    if (block == nullptr)
+    {
+      block = load(offset);
+    }
+    if (block != nullptr)
+    {
+      block->used = ++clock_;
+    }
+    return block;
+  }
+
+  void read_ahead(std::size_t offset)
+  {
+    if (offset >= storage_.size() || find(offset) != nullptr)
+    {
+      return;
+    }
+
+    // block that was just read is the most recently used one, so it is
+    // never evicted by prefetch
+    Block *block = load(offset);
+    if (block != nullptr)
+    {
+      block->used = ++clock_;
+    }
+  }
+
+  ImageSource                      &storage_;
+  std::array<Block, NumberOfBlocks> blocks_;
+  uint32_t                          clock_;
+  std::size_t                       next_offset_;
+};
+
+} // namespace yasld
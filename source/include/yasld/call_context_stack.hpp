@@ -0,0 +1,74 @@
+/**
+ * call_context_stack.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "yasld/allocator.hpp"
+#include "yasld/arch.hpp"
+
+namespace yasld
+{
+
+class Module;
+
+// Caller states saved by entry supervisor call and restored by exit
+// supervisor call. Calls between modules may be nested, i.e. library calls
+// back into its caller or the same library is entered again through
+// callback, so single context per module is not enough.
+// Each task needs own stack, since calls of different tasks interleave.
+// Memory for capacity entries is allocated by owner before any call, push
+// runs in supervisor call and never allocates, it fails when stack is full
+// or memory wasn't allocated.
+class CallContextStack
+{
+public:
+  struct Entry
+  {
+    Module            *module;
+    ForeignCallContext context;
+  };
+
+  explicit CallContextStack(std::size_t capacity);
+  CallContextStack(const CallContextStack &)       = delete;
+  CallContextStack(CallContextStack &&)            = default;
+  CallContextStack &operator=(CallContextStack &&) = default;
+
+  // Allocates memory for capacity entries
+  bool                 allocate();
+  bool                 push(Module &module, const ForeignCallContext &context);
+  // Module is active until its last entry is popped, see Module::enter
+  std::optional<Entry> pop();
+  // Pops all entries, i.e. when task is deleted during call into module
+  void                 clear();
+  bool                 contains(const Module &module) const;
+  bool                 empty() const;
+  std::size_t          size() const;
+  std::size_t          capacity() const;
+
+private:
+  std::vector<Entry, CallContextAllocator<Entry>> entries_;
+  std::size_t                                     capacity_;
+};
+
+} // namespace yasld
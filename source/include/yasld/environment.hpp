@@ -20,10 +20,15 @@
 
 #pragma once
 
-#include <array>
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
+#include <optional>
+#include <span>
 #include <string_view>
+#include <type_traits>
+
+#include "yasld/fingerprint.hpp"
 
 namespace yasld
 {
@@ -31,15 +36,26 @@ namespace yasld
 struct SymbolEntry
 {
 public:
-  SymbolEntry(const std::string_view &symbol_name, auto &&symbol_address)
+  // Address of object or function with static storage is constant, so table
+  // of entries may be constexpr array placed in flash
+  constexpr SymbolEntry(
+    const std::string_view &symbol_name,
+    const void             *symbol_address)
+    : name{ symbol_name }
+    , address{ symbol_address }
+  {
+  }
+
+  template <typename Function>
+    requires std::is_function_v<std::remove_pointer_t<Function>>
+  SymbolEntry(const std::string_view &symbol_name, Function *symbol_address)
     : name{ symbol_name }
-    , address{ reinterpret_cast<std::uintptr_t>(
-        reinterpret_cast<void *&>(symbol_address)) }
+    , address{ reinterpret_cast<const void *>(symbol_address) }
   {
   }
 
   std::string_view name;
-  std::uintptr_t   address;
+  const void      *address;
 };
 
 class Environment
@@ -49,35 +65,98 @@ public:
 
   virtual const SymbolEntry *find_symbol(
     const std::string_view &name) const = 0;
+
+  // Prelinked imports are reused only when environment fingerprint is
+  // unchanged, environment without fingerprint is always resolved by name
+  virtual std::optional<uint32_t> fingerprint() const
+  {
+    return std::nullopt;
+  }
+
+  // Checked by Loader::set_environment, environment which can't be searched
+  // is rejected
+  virtual bool is_valid() const
+  {
+    return true;
+  }
 };
 
-template <std::size_t N>
+// Not constexpr, called during constant evaluation only for unsorted table,
+// so its name is reported in compilation error
+inline void static_environment_table_must_be_sorted_by_name()
+{
+}
+
+// Environment over table sorted by name, lookup is binary search. Table is
+// not copied, mkimage/generate_environment.py emits it presorted as constexpr
+// array, so it stays in flash and nothing is sorted at startup.
+// Unsorted table fails compilation of constinit or constexpr environment,
+// environment constructed at runtime is rejected by loader.
 class StaticEnvironment : public Environment
 {
 public:
-  template <typename... Args>
-  constexpr StaticEnvironment(Args &&...args)
-    : entries_({ std::forward<Args>(args)... })
+  constexpr explicit StaticEnvironment(std::span<const SymbolEntry> entries)
+    : entries_{ entries }
+    , fingerprint_{}
+    , sorted_{ std::is_sorted(entries.begin(), entries.end(), compare) }
   {
+    if consteval
+    {
+      if (!sorted_)
+      {
+        static_environment_table_must_be_sorted_by_name();
+      }
+    }
   }
 
   const SymbolEntry *find_symbol(const std::string_view &name) const override
   {
-    for (const auto &symbol : entries_)
+    const auto symbol = std::lower_bound(
+      entries_.begin(),
+      entries_.end(),
+      name,
+      [](const SymbolEntry &entry, const std::string_view &value)
+      {
+        return entry.name < value;
+      });
+
+    if (symbol != entries_.end() && symbol->name == name)
+    {
+      return &(*symbol);
+    }
+    return nullptr;
+  }
+
+  // Table doesn't change after construction, so it is hashed once
+  std::optional<uint32_t> fingerprint() const override
+  {
+    if (!fingerprint_)
     {
-      if (symbol.name == name)
+      Fingerprint fingerprint;
+      for (const auto &symbol : entries_)
       {
-        return &symbol;
+        fingerprint.add(symbol.name)
+          .add(reinterpret_cast<std::uintptr_t>(symbol.address));
       }
+      fingerprint_ = fingerprint.value();
     }
-    return nullptr;
+    return fingerprint_;
+  }
+
+  bool is_valid() const override
+  {
+    return sorted_;
   }
 
 private:
-  std::array<SymbolEntry, N> entries_;
-};
+  constexpr static bool compare(const SymbolEntry &a, const SymbolEntry &b)
+  {
+    return a.name < b.name;
+  }
 
-template <typename... Args>
-StaticEnvironment(Args &&...) -> StaticEnvironment<sizeof...(Args)>;
+  std::span<const SymbolEntry>    entries_;
+  mutable std::optional<uint32_t> fingerprint_;
+  bool                            sorted_;
+};
 
 } // namespace yasld
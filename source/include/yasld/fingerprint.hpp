@@ -0,0 +1,81 @@
+/**
+ * fingerprint.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace yasld
+{
+
+// FNV-1a accumulator used to detect changes in symbol providers
+class Fingerprint
+{
+public:
+  constexpr Fingerprint()
+    : value_{ 2166136261u }
+  {
+  }
+
+  constexpr Fingerprint &add(std::uintptr_t value)
+  {
+    for (std::size_t i = 0; i < sizeof(value); ++i)
+    {
+      add_byte(static_cast<uint8_t>(value >> (i * 8)));
+    }
+    return *this;
+  }
+
+  constexpr Fingerprint &add(const std::string_view &text)
+  {
+    for (const char c : text)
+    {
+      add_byte(static_cast<uint8_t>(c));
+    }
+    return add(text.size());
+  }
+
+  constexpr Fingerprint &add(std::span<const std::byte> bytes)
+  {
+    for (const std::byte byte : bytes)
+    {
+      add_byte(static_cast<uint8_t>(byte));
+    }
+    return add(bytes.size());
+  }
+
+  [[nodiscard]] constexpr uint32_t value() const
+  {
+    return value_;
+  }
+
+private:
+  constexpr void add_byte(uint8_t byte)
+  {
+    value_ = (value_ ^ byte) * 16777619u;
+  }
+
+  uint32_t value_;
+};
+
+} // namespace yasld
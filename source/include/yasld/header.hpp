@@ -21,10 +21,34 @@
 #pragma once
 
 #include <cstdint>
+#include <string_view>
 
 namespace yasld
 {
 
+// Location of each section, stored after header since YASIFF v2.
+// Offsets are counted from header start, sizes are in bytes.
+struct __attribute__((packed)) SectionDirectory
+{
+  struct __attribute__((packed)) Entry
+  {
+    uint32_t offset;
+    uint32_t size;
+  };
+
+  Entry name;
+  Entry imported_libraries;
+  Entry symbol_table_relocations;
+  Entry local_relocations;
+  Entry data_relocations;
+  Entry imported_symbols;
+  Entry exported_symbols;
+  Entry exported_symbols_hash;
+  Entry text;
+  Entry init;
+  Entry data;
+};
+
 struct __attribute__((packed)) Header
 {
 public:
@@ -37,10 +61,39 @@ public:
 
   enum class Architecture : uint16_t
   {
-    Unknown = 0,
-    Armv6_m = 1
+    Unknown      = 0,
+    Armv6_m      = 1,
+    Armv7_m      = 2,
+    Armv8_m_main = 3
   };
 
+  enum class Flag : uint8_t
+  {
+    // Exported symbol table is followed by hash table
+    ExportedSymbolsHash = 0x01,
+    // Imported functions are marked with code section, other imports with
+    // unknown section, only functions may be bound lazily
+    ImportedFunctions   = 0x02,
+    // Exported functions use wrappers without supervisor calls, these loads
+    // LOT base from text, so text must be placed in RAM
+    DirectCalls         = 0x04,
+    // Relocated read only data (vtables, pointer tables) is placed in text
+    // and resolved for image address stored in last word of text, so it stays
+    // in flash when image is executed in place from that address
+    ReadOnlyDataInText  = 0x08,
+    // Sections are stored as LZ4 blocks, section directory contains stored
+    // size and header decompressed one. Compressed text is copied to RAM
+    CompressedText      = 0x10,
+    CompressedData      = 0x20
+  };
+
+  constexpr static uint8_t version_with_directory = 2;
+  constexpr static uint8_t latest_version         = 2;
+
+  [[nodiscard]] bool has(Flag flag) const;
+  // Returns nullptr for images older than v2
+  [[nodiscard]] const SectionDirectory *section_directory() const;
+
   const char   cookie[4];
   Type         type;
   Architecture arch;
@@ -52,17 +105,20 @@ public:
   uint32_t     entry;
   uint16_t     external_libraries_amount;
   uint8_t      alignment;
-  uint8_t      _reserved;
+  uint8_t      flags;
   uint16_t     version_major;
   uint16_t     version_minor;
   uint16_t     symbol_table_relocations_amount;
   uint16_t     local_relocations_amount;
   uint16_t     data_relocations_amount;
-  uint16_t     _reserved2;
+  // Number of .fini_array entries placed at end of init section
+  uint16_t     fini_array_amount;
   uint16_t     exported_symbols_amount;
   uint16_t     imported_symbols_amount;
 };
 
-void print(const Header &header);
+std::string_view to_string(Header::Type type);
+std::string_view to_string(Header::Architecture arch);
+void             print(const Header &header);
 
 } // namespace yasld
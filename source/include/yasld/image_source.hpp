@@ -0,0 +1,42 @@
+/**
+ * image_source.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+namespace yasld
+{
+
+// Module image placed in storage that is not memory mapped, i.e. SPI flash
+// or SD card. Loader reads header and tables to RAM, text and data are read
+// directly to their final location.
+class ImageSource
+{
+public:
+  virtual ~ImageSource() = default;
+
+  // Reads buffer.size() bytes starting at offset from image beginning
+  virtual bool        read(std::size_t offset, std::span<std::byte> buffer) = 0;
+  virtual std::size_t size() const = 0;
+};
+
+} // namespace yasld
@@ -48,8 +48,8 @@ public:
   bool          operator!=(const ItemIterator &b) const;
 
 private:
-  const uint8_t alignment_;
-  const T      *item_;
+  uint8_t  alignment_;
+  const T *item_;
 };
 
 template <typename T>
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 
 #include "yasld/item_iterator.hpp"
 
@@ -36,6 +37,14 @@ public:
     uint16_t       number_of_items,
     uint8_t        alignment);
 
+  // Size known upfront (i.e. from section directory) makes size() and end()
+  // constant time
+  ItemTable(
+    std::uintptr_t address,
+    uint16_t       number_of_items,
+    uint8_t        alignment,
+    std::size_t    size);
+
   [[nodiscard]] std::uintptr_t address() const;
   [[nodiscard]] std::size_t    size() const;
 
@@ -45,9 +54,10 @@ public:
   const T                     &operator[](uint32_t position) const;
 
 private:
-  uint8_t  alignment_;
-  uint16_t number_of_items_;
-  const T *root_;
+  uint8_t                    alignment_;
+  uint16_t                   number_of_items_;
+  const T                   *root_;
+  std::optional<std::size_t> size_;
 };
 
 template <typename T>
@@ -58,12 +68,31 @@ ItemTable<T>::ItemTable(
   : alignment_(alignment)
   , number_of_items_(number_of_items)
   , root_(reinterpret_cast<const T *>(address))
+  , size_{}
+{
+}
+
+template <typename T>
+ItemTable<T>::ItemTable(
+  std::uintptr_t address,
+  uint16_t       number_of_items,
+  uint8_t        alignment,
+  std::size_t    size)
+  : alignment_(alignment)
+  , number_of_items_(number_of_items)
+  , root_(reinterpret_cast<const T *>(address))
+  , size_{ size }
 {
 }
 
 template <typename T>
 std::size_t ItemTable<T>::size() const
 {
+  if (size_)
+  {
+    return *size_;
+  }
+
   std::size_t size = 0;
   const T    *item = root_;
 
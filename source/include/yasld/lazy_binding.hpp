@@ -0,0 +1,48 @@
+/**
+ * lazy_binding.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace yasld
+{
+
+class Symbol;
+
+// LOT slot of lazily bound function points to thunk placed at the beginning
+// of the record. Thunk passes record to the lazy binding supervisor call,
+// which resolves symbol, patches LOT slot and jumps to the resolved function.
+// Function address may be copied from LOT before the first call, so record
+// must stay valid as long as module is loaded.
+struct LazyBinding
+{
+  uint16_t      thunk[4];
+  // thunk loads both addresses below
+  LazyBinding  *self;
+  std::size_t   resolver;
+  // module is found by LOT, it may be moved after loading
+  std::size_t  *lot;
+  const Symbol *symbol;
+  uint32_t      lot_index;
+};
+
+} // namespace yasld
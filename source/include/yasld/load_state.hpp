@@ -0,0 +1,114 @@
+/**
+ * load_state.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "yasld/allocator.hpp"
+#include "yasld/dependency_iterator.hpp"
+#include "yasld/fingerprint.hpp"
+#include "yasld/lz4_decoder.hpp"
+#include "yasld/parser.hpp"
+#include "yasld/symbol_iterator.hpp"
+#include "yasld/symbol_table.hpp"
+
+namespace yasld
+{
+
+class ImageSource;
+class Module;
+
+enum class LoadStage : uint8_t
+{
+  Header,
+  ContentFingerprint,
+  Init,
+  Text,
+  Dependencies,
+  Data,
+  Bss,
+  Imports,
+  PrelinkFingerprint,
+  PrelinkedImports,
+  LazyBindings,
+  SymbolRelocations,
+  LocalRelocations,
+  DataRelocations,
+  Entry,
+  Done
+};
+
+// Symbol table has variable length entries, so random access walks from
+// the beginning. mkimage sorts relocations by symbol index, then single
+// cursor visits each symbol once. Unsorted images still work, cursor is
+// rewound when index goes backward.
+class SymbolCursor
+{
+public:
+  explicit SymbolCursor(const SymbolTable &table);
+
+  const Symbol &seek(uint32_t index);
+
+private:
+  SymbolIterator begin_;
+  SymbolIterator current_;
+  uint32_t       index_;
+};
+
+// Progress of single module loading. Dependencies are loaded on top of
+// module that imports them, so loader keeps stack of states.
+struct LoadState
+{
+  LoadState(
+    const void  *image,
+    ImageSource *image_source,
+    Module      *loaded_module);
+
+  // Identifies image, for images read from source it is source address
+  const void                       *module_address;
+  // Set when image is not memory mapped
+  ImageSource                      *source;
+  Module                           *module;
+  const Header                     *header;
+  std::optional<Parser>             parser;
+  LoadStage                         stage;
+  // Position inside current stage
+  std::size_t                       cursor;
+  std::optional<DependencyIterator> dependency;
+  std::optional<SymbolCursor>       symbols;
+  // Decodes compressed section, cursor is position in stored section then
+  std::optional<Lz4Decoder>         decoder;
+  std::size_t                       lazy_bindings;
+  // Accumulated in blocks by fingerprint stages
+  Fingerprint                       hash;
+  Fingerprint                       tree_hash;
+  std::optional<uint32_t>           fingerprint;
+  // Imports copied from prelink cache
+  std::span<const std::size_t>      prelinked_imports;
+  // Imports resolved by name, stored in prelink cache when all are resolved
+  std::vector<std::size_t, OffsetTableAllocator<std::size_t>> resolved_imports;
+  bool                              lazy;
+};
+
+} // namespace yasld
@@ -29,8 +29,13 @@
 #include <eul/functional/function.hpp>
 
 #include "yasld/allocator.hpp"
+#include "yasld/call_context_stack.hpp"
 #include "yasld/executable.hpp"
 #include "yasld/library.hpp"
+#include "yasld/load_state.hpp"
+#include "yasld/module_index.hpp"
+#include "yasld/module_registry.hpp"
+#include "yasld/placement.hpp"
 #include "yasld/symbol_table.hpp"
 
 #include "yasld/arch.hpp"
@@ -40,6 +45,9 @@ namespace yasld
 class Header;
 class Parser;
 class Environment;
+class ImageSource;
+class PrelinkCache;
+struct LazyBinding;
 
 class Loader
 {
@@ -47,15 +55,92 @@ public:
   using FileResolverType = eul::function<
     std::optional<const void *>(const std::string_view &filename),
     sizeof(void *)>;
+  // Used for dependencies not found by file resolver
+  using SourceResolverType = eul::function<
+    ImageSource *(const std::string_view &filename),
+    sizeof(void *)>;
   Loader();
   Loader(const AllocatorType &allocator, const ReleaseType &release);
+  ~Loader();
+
+  // Returns false for invalid environment, i.e. unsorted static table
+  bool set_environment(const Environment &environment);
+  // Imports of modules loaded with unchanged environment and dependencies
+  // are copied from cache instead of resolving them by name
+  void set_prelink_cache(PrelinkCache &cache);
+  // Imported functions are resolved on first call instead of load time.
+  // Requires images with marked imported functions, others are bound eagerly.
+  // Returns false when architecture has no lazy binding thunk
+  bool set_lazy_binding(bool enabled);
+  // Module object, LOT, init, data with bss and imported modules are carved
+  // from single AllocationType::Arena block, released at once. Enabled by
+  // default, disabled loader allocates each region with own AllocationType,
+  // i.e. to place them in different RAM banks.
+  void set_module_arena(bool enabled);
 
-  void set_environment(const Environment &environment);
+  // Placement of text for modules loaded later, dependencies included
+  void set_placement(const Placement &placement);
+  // Placement of single module by its name, modules without placement
+  // returned by resolver use default one
+  using PlacementResolverType = eul::function<
+    std::optional<Placement>(const std::string_view &module_name),
+    sizeof(void *)>;
+  void register_placement_resolver(const PlacementResolverType &resolver);
+  // Region used by TextPlacement::CopyToRegion with same name
+  bool add_memory_region(const MemoryRegion &region);
 
+  // Loaded modules keep pointers to module index and registry of loader, so
+  // all of them must be dropped before loader is destroyed
   using ObservedExecutable = eul::container::observing_node<Executable>;
   std::optional<ObservedExecutable> load_executable(const void *module_address);
   using ObservedLibrary = eul::container::observing_node<Library>;
   std::optional<ObservedLibrary> load_library(const void *module_address);
+  // Text and data are read directly to RAM, header and tables are kept in
+  // RAM for module lifetime. Requires YASIFF v2.
+  std::optional<ObservedExecutable> load_executable(ImageSource &source);
+  std::optional<ObservedLibrary>    load_library(ImageSource &source);
+
+  // Calls .fini_array of module and releases its memory. Dependencies are
+  // finalized and released when last consumer is unloaded. Module dropped
+  // without unload is released without calling own .fini_array.
+  void unload(ObservedExecutable executable);
+  void unload(ObservedLibrary library);
+
+  enum class LoadStatus : uint8_t
+  {
+    InProgress,
+    Done,
+    Failed
+  };
+
+  // Resumable loading for systems that can't be blocked until whole module
+  // with dependencies is loaded, i.e. from RTOS idle task.
+  // Only one module may be loaded at a time.
+  bool       start_loading_executable(const void *module_address);
+  bool       start_loading_library(const void *module_address);
+  bool       start_loading_executable(ImageSource &source);
+  bool       start_loading_library(ImageSource &source);
+  // Processes at most budget work items. Work item is module header,
+  // dependency lookup, single relocation, import or dependency hashed for
+  // prelink cache, or block of load_block_size bytes of text, init, data or
+  // tables hashed for prelink cache. Header of image read from source
+  // includes reading its tables.
+  LoadStatus step(std::size_t budget);
+  // Returns module when step reported Done
+  std::optional<ObservedExecutable> take_executable();
+  std::optional<ObservedLibrary>    take_library();
+
+  // Live memory of all modules and loader bookkeeping per AllocationType.
+  // Memory of single module is reported by Module::get_memory_usage.
+  const MemoryUsage &get_memory_usage() const;
+  // Starts new high-water mark from currently used memory
+  void               reset_memory_peak();
+
+  constexpr static std::size_t      load_block_size = 64;
+  // Depth of nested calls between modules for default call context stack
+  constexpr static std::size_t      call_context_depth = 16;
+  // Defined by direct call wrappers, see call_wrapped_direct.s.tmpl
+  constexpr static const char      *lot_base_symbol = "__yasld_lot_base";
 
   Module *find_module(std::size_t program_counter, bool only_active = false);
   Module *find_module_for_pc_and_lot(
@@ -64,25 +149,130 @@ public:
   Module *find_module_with_lot(std::size_t lot_address);
   Module *find_active_module(std::size_t program_counter);
 
+  // Caller states of calls between modules made by running task, pushed and
+  // popped by supervisor calls. Systems with more tasks calling modules
+  // switch to stack of running task, stack must outlive its use and be
+  // allocated before, supervisor calls don't allocate.
+  CallContextStack &get_call_context_stack();
+  void              set_call_context_stack(CallContextStack &stack);
+
+  // Arch independent part of entry and exit supervisor calls. Entry finds
+  // called module by program counter inside it and LOT of caller, saves
+  // caller state and returns LOT of called module. Exit returns state of
+  // caller saved by most recent entry of running task.
+  std::optional<std::size_t> enter_module(
+    std::size_t               program_counter,
+    std::size_t               caller_lot,
+    const ForeignCallContext &context);
+  std::optional<ForeignCallContext> exit_module();
+
+  // Identifier of RTOS task, i.e. TCB address
+  using TaskId = std::size_t;
+  // Allocates call context stack for task, must be called before task
+  // calls into modules
+  bool              add_task(TaskId task_id);
+  // Modules entered by deleted task are left
+  void              remove_task(TaskId task_id);
+  // Called by RTOS before switched task runs, i.e. from PendSV handler.
+  // Supervisor calls and find_active_module use state of that task.
+  // Doesn't allocate, unknown task falls back to default stack.
+  bool              on_task_switch(TaskId task_id);
+
   void    register_file_resolver(const FileResolverType &resolver);
+  void    register_source_resolver(const SourceResolverType &resolver);
+
+  // Called from lazy binding supervisor call, patches LOT slot
+  std::optional<std::size_t> resolve_lazy_binding(LazyBinding &binding);
 
 private:
+  struct Task
+  {
+    TaskId           id;
+    CallContextStack call_contexts;
+  };
+
   const Header *process_header(const void *module_address) const;
-  bool process_data(const Header &header, const Parser &parser, Module &module);
-  void process_local_relocations(const Parser &parser, Module &module);
-  void process_data_relocations(const Parser &parser, Module &module);
-  bool process_symbol_table_relocations(const Parser &parser, Module &module);
-  bool load_module(const void *module_address, Module &module);
+  void          warm_environment_fingerprint() const;
+  bool start_loading(
+    const void  *module_address,
+    ImageSource *source,
+    bool         executable);
+  bool push_load_state(
+    const void  *module_address,
+    ImageSource *source,
+    Module      *module);
+  bool process_load_stage(LoadState &state, std::size_t &budget);
+  bool process_module_header(LoadState &state);
+  void process_content_fingerprint(LoadState &state, std::size_t &budget);
+  bool process_init(LoadState &state, std::size_t &budget);
+  bool check_link_address(const LoadState &state) const;
+  bool place_text(LoadState &state);
+  bool read_module_image(LoadState &state);
+  // Copies blocks of section from image, compressed section is decoded
+  bool copy_section(
+    LoadState                     &state,
+    std::size_t                   &budget,
+    const SectionDirectory::Entry &section,
+    std::span<std::byte>           destination,
+    bool                           compressed);
+  bool process_text(LoadState &state, std::size_t &budget);
+  bool store_lot_base(LoadState &state);
+  bool process_dependencies(LoadState &state, std::size_t &budget);
+  bool process_data(LoadState &state, std::size_t &budget);
+  void process_bss(LoadState &state, std::size_t &budget);
+  bool process_imports(LoadState &state);
+  bool process_prelink_fingerprint(LoadState &state, std::size_t &budget);
+  void process_prelinked_imports(LoadState &state, std::size_t &budget);
+  bool start_symbol_resolution(LoadState &state);
+  bool count_lazy_bindings(LoadState &state, std::size_t &budget);
+  bool process_symbol_table_relocations(LoadState &state, std::size_t &budget);
+  void process_local_relocations(LoadState &state, std::size_t &budget);
+  void process_data_relocations(LoadState &state, std::size_t &budget);
+  void process_entry(LoadState &state);
+  void set_stage(LoadState &state, LoadStage stage);
+  bool finish_module();
+  void abort_loading();
+  void allocate_call_contexts();
+  Module *allocate_dependency(
+    const void             *module_address,
+    ImageSource            *source,
+    const std::string_view &name);
   std::optional<std::size_t> find_symbol(
     Module                 &module,
     const std::string_view &name) const;
   bool is_fragment_of_module(const Module *module, std::size_t program_counter)
     const;
+  bool is_top_level_module(const Module *module);
+  Task              *find_task(TaskId task_id);
   std::size_t        get_base_address(Section section, Module &module);
 
   FileResolverType   file_resolver_;
+  SourceResolverType source_resolver_;
 
   const Environment *environment_;
+  PrelinkCache      *prelink_cache_;
+  bool               lazy_binding_;
+  bool               module_arena_;
+  Placement          placement_;
+
+  PlacementResolverType                                    placement_resolver_;
+  std::vector<MemoryRegion, ModuleAllocator<MemoryRegion>> memory_regions_;
+
+  // Ranges of all loaded modules, must outlive modules owned by loader
+  ModuleIndex        index_;
+  // Used without tasks and for tasks not added to loader
+  CallContextStack   call_contexts_;
+  CallContextStack  *active_call_contexts_;
+  // Sorted by id, running task is kept by id since stacks are moved when
+  // tasks are added or removed
+  std::vector<Task, ModuleAllocator<Task>> tasks_;
+  std::optional<TaskId>                    running_task_;
+  // Modules loaded as dependencies, shared between all consumers
+  ModuleRegistry     registry_;
+  // Modules being loaded, requested module at bottom
+  std::vector<LoadState, ModuleAllocator<LoadState>> load_stack_;
+  std::optional<ObservedExecutable>                 pending_executable_;
+  std::optional<ObservedLibrary>                    pending_library_;
   // Loaded executables observer
   using ExecutableList = eul::container::observing_list<ObservedExecutable>;
   ExecutableList executables_;
@@ -0,0 +1,67 @@
+/**
+ * lz4_decoder.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace yasld
+{
+
+// Decoder of LZ4 block format (without frame), used for compressed image
+// sections. Input may be passed in chunks of any size, i.e. blocks read from
+// ImageSource, so state is kept between calls. Matches are copied from
+// already decoded output, so no window buffer is needed and sections are
+// decoded directly into their final location.
+class Lz4Decoder
+{
+public:
+  explicit Lz4Decoder(std::span<std::byte> output);
+
+  // Returns false for corrupted stream, i.e. match outside of output
+  bool        decode(std::span<const std::byte> input);
+  // Whole output was written and stream ended on sequence boundary
+  bool        finished() const;
+  std::size_t written() const;
+
+private:
+  enum class State : uint8_t
+  {
+    Token,
+    LiteralLength,
+    Literals,
+    OffsetLow,
+    OffsetHigh,
+    MatchLength
+  };
+
+  bool copy_match();
+
+  std::span<std::byte> output_;
+  std::size_t          written_;
+  std::size_t          length_;
+  std::size_t          offset_;
+  uint8_t              token_;
+  State                state_;
+};
+
+} // namespace yasld
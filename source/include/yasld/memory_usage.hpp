@@ -0,0 +1,65 @@
+/**
+ * memory_usage.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace yasld
+{
+
+enum class AllocationType : uint8_t;
+
+struct AllocationStatistics
+{
+  std::size_t bytes;
+  std::size_t allocations;
+};
+
+// Live memory counted per AllocationType, for loader or single module
+class MemoryUsage
+{
+public:
+  // Last AllocationType is Arena
+  constexpr static std::size_t number_of_types = 9;
+
+  MemoryUsage();
+
+  void                        add(AllocationType type, std::size_t size);
+  void                        remove(AllocationType type, std::size_t size);
+  MemoryUsage                &operator+=(const MemoryUsage &other);
+
+  const AllocationStatistics &get(AllocationType type) const;
+  std::size_t                 bytes() const;
+  std::size_t                 allocations() const;
+  // Highest number of live bytes since creation or reset_peak
+  std::size_t                 peak_bytes() const;
+  void                        reset_peak();
+
+private:
+  std::array<AllocationStatistics, number_of_types> statistics_;
+  std::size_t                                       bytes_;
+  std::size_t                                       allocations_;
+  std::size_t                                       peak_bytes_;
+};
+
+} // namespace yasld
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <span>
@@ -30,93 +31,180 @@
 
 #include "yasld/allocator.hpp"
 #include "yasld/arch.hpp"
+#include "yasld/lazy_binding.hpp"
+#include "yasld/memory_usage.hpp"
+#include "yasld/module_index.hpp"
+#include "yasld/module_registry.hpp"
+#include "yasld/placement.hpp"
+#include "yasld/symbol_hash_table.hpp"
 #include "yasld/symbol_table.hpp"
 
 namespace yasld
 {
 
+class Header;
+
 // Base for executable and library
 class Module
 {
 public:
-  virtual ~Module()      = default;
+  // Inline, so module has no key function and typeinfo is emitted for
+  // users compiled with RTTI
+  virtual ~Module()
+  {
+    if (index_ != nullptr)
+    {
+      index_->remove(*this);
+    }
+  }
 
   Module(const Module &) = delete;
-  Module(Module &&)      = default;
+  // Keeps ranges in ModuleIndex pointing to moved module
+  Module(Module &&other);
   Module();
 
+  // Bytes needed for LOT, init, data with bss and imported modules of
+  // module described by header, each region is aligned to max_align_t
+  static std::size_t get_arena_size(const Header &header);
+  // Size rounded up to alignment of arena regions
+  constexpr static std::size_t align_arena(std::size_t size)
+  {
+    constexpr std::size_t alignment = alignof(std::max_align_t);
+    return (size + alignment - 1) & ~(alignment - 1);
+  }
+  // Regions are carved from arena by allocate calls below and released with
+  // it, region which doesn't fit is allocated with own AllocationType
+  bool allocate_arena(std::size_t size);
+  // Arena owned by caller, i.e. block with module object at start
+  void set_arena(std::span<std::byte> arena);
+  // Block with module object allocated by loader, i.e. for dependency
+  void set_allocation(std::size_t size, AllocationType type);
+  // Destroys module allocated by loader and releases its block
+  static void destroy(Module *module);
+
   bool allocate_lot(std::size_t size);
   bool allocate_data(std::size_t data_size, std::size_t bss_size);
   bool allocate_modules(std::size_t number_of_modules);
-
-  bool relocate_init(const std::span<const std::size_t> &init);
+  bool allocate_lazy_bindings(std::size_t size);
+  // Used when text is not executed from memory mapped image
+  bool allocate_text(std::size_t size);
+  bool allocate_text(std::size_t size, const MemoryRegion &region);
+  bool allocate_image(std::size_t size);
+
+  bool allocate_init(std::size_t size);
+  // Relocates entries copied from image to init, in place
+  void relocate_init(std::span<std::size_t> entries);
+  // Last entries of init section belongs to .fini_array
+  bool set_fini_amount(std::size_t amount);
+  // Calls .fini_array in reverse order, only once
+  void finalize();
   void set_text(const std::span<const std::byte> &text);
   void set_exported_symbol_table(const SymbolTable &table);
+  void set_exported_symbol_hash_table(
+    const std::optional<SymbolHashTable> &table);
 
   std::span<std::size_t>            get_lot();
+  std::span<LazyBinding>            get_lazy_bindings();
+  std::span<std::byte>              get_text_memory();
+  std::span<std::byte>              get_image();
   std::span<const std::byte>        get_text() const;
   std::span<std::size_t>            get_init();
+  std::span<const std::size_t>      get_fini() const;
   std::span<std::byte>              get_data();
   std::span<std::byte>              get_bss();
   std::span<const std::byte>        get_data() const;
   std::span<const std::byte>        get_bss() const;
   const std::optional<SymbolTable> &get_exported_symbol_table() const;
   std::optional<std::size_t> find_symbol(const std::string_view &name) const;
+  // hash must be calculated with SymbolHashTable::hash, it is reused for
+  // whole dependency tree
+  std::optional<std::size_t> find_symbol(
+    const std::string_view &name,
+    uint32_t                hash) const;
 
-  // If call from foreign module previous R9 and PC counter inside wrapper must
-  // be saved
-  // Works thanks to limitation that shared libraries cannot contain
-  // cyclic dependency
-  void                       save_caller_state(ForeignCallContext ctx);
-  ForeignCallContext         restore_caller_state();
-
-  using ModuleDeleter = YasldDeleter<Module>;
-  using ModuleHolder  = std::unique_ptr<Module, ModuleDeleter>;
+  // Dependencies are shared between all consumers through ModuleRegistry
   using ModulesContainer =
-    std::vector<ModuleHolder, ModuleAllocator<ModuleHolder>>;
+    std::vector<SharedModule, RegionAllocator<SharedModule, ModuleAllocator>>;
 
   ModulesContainer       &get_modules();
 
   void                    set_name(const std::string_view &name);
   const std::string_view &get_name() const;
 
-  bool is_module_for_program_counter(std::size_t program_counter);
+  // Hash of header and symbol tables, detects reflashed image at the same
+  // address. Calculated only when prelink cache is used
+  void                    set_content_fingerprint(uint32_t fingerprint);
+  uint32_t                get_content_fingerprint() const;
+  // Hash of placement and content of module with its dependencies, used by
+  // prelink fingerprint of consumers instead of walking dependency tree
+  void                    set_tree_fingerprint(uint32_t fingerprint);
+  uint32_t                get_tree_fingerprint() const;
 
-  std::optional<Module *> find_module_for_program_counter(
-    std::size_t program_counter);
-
-  std::optional<Module *> find_active_module_for_program_counter(
-    std::size_t program_counter);
-
-  std::optional<Module *> find_module_with_lot(std::size_t lot_address);
+  // Returns true for this module and its dependencies
+  bool                    has_module(const Module &module) const;
 
+  // Active while any task executes call into module, calls are counted,
+  // since tasks and nested calls may enter module more than once
   bool                    get_active() const;
-  void                    set_active(bool active);
+  void                    enter();
+  void                    leave();
 
-protected:
-  std::optional<Module *> find_module_for_program_counter_impl(
-    std::size_t program_counter,
-    bool        only_active = false);
+  // Set by ModuleIndex when ranges of module are inserted
+  void                    set_index(ModuleIndex *index);
 
-  bool is_module_for_program_counter_impl(
-    std::size_t program_counter,
-    bool        only_active = false);
+  // Memory allocated by loader for this module, regions placed in arena are
+  // accounted with it
+  MemoryUsage             get_memory_usage() const;
+  // Includes dependencies, module shared in dependency tree is counted once
+  MemoryUsage             get_total_memory_usage() const;
 
-  std::vector<std::size_t, OffsetTableAllocator<std::size_t>> lot_;
-  std::vector<std::byte, DataAllocator<std::byte>>            data_memory_;
+protected:
+  const Symbol *find_exported_symbol(
+    const std::string_view &name,
+    uint32_t                hash) const;
+
+  std::span<std::byte> take_arena(std::size_t size);
+
+  // Calls visitor for module and each dependency in preorder
+  template <typename Visitor>
+  void visit_tree(Visitor &visitor) const;
+
+  using LotContainer = std::
+    vector<std::size_t, RegionAllocator<std::size_t, OffsetTableAllocator>>;
+  using DataContainer =
+    std::vector<std::byte, RegionAllocator<std::byte, DataAllocator>>;
+  using InitContainer =
+    std::vector<std::size_t, RegionAllocator<std::size_t, InitAllocator>>;
+  using TextContainer =
+    std::vector<std::byte, RegionAllocator<std::byte, TextAllocator>>;
+
+  // Destroyed last, other containers may be placed in it
+  std::vector<std::byte, ArenaAllocator<std::byte>>           arena_memory_;
+  std::span<std::byte>                                        arena_;
+  LotContainer                                                lot_;
+  DataContainer                                               data_memory_;
+  std::vector<LazyBinding, LazyBindingAllocator<LazyBinding>> lazy_bindings_;
+  // Memory region of text, destroyed after text container placed in it
+  std::unique_ptr<std::byte, RegionDeleter>                   text_region_;
+  TextContainer                                               text_memory_;
+  std::vector<std::byte, ImageAllocator<std::byte>>           image_;
   std::span<const std::byte>                                  text_;
-  std::vector<std::size_t, InitAllocator<std::size_t>>        init_;
+  InitContainer                                               init_;
+  std::size_t                                                 fini_amount_;
   std::span<std::byte>                                        data_;
   std::span<std::byte>                                        bss_;
   std::optional<SymbolTable>                                  exported_symbols_;
-  ForeignCallContext foreign_call_context_;
+  std::optional<SymbolHashTable> exported_symbols_hash_;
   ModulesContainer   imported_modules_;
   std::string_view   name_;
-  // In single threaded only one instance of library is active
-  // for multithreaded it has to be connected to thread info,
-  // thread info may point currently used module, to determine which
-  // tree needs to be searched
-  bool               active_;
+  uint32_t           content_fingerprint_;
+  uint32_t           tree_fingerprint_;
+  ModuleIndex       *index_;
+  std::size_t        allocation_size_;
+  AllocationType     allocation_type_;
+  // Calls in progress of all tasks, modules active for single task are
+  // tracked by its CallContextStack
+  std::size_t        active_calls_;
 };
 
 } // namespace yasld
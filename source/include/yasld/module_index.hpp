@@ -0,0 +1,75 @@
+/**
+ * module_index.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "yasld/allocator.hpp"
+
+namespace yasld
+{
+
+class Module;
+
+// Text, data and bss ranges of loaded modules sorted by start address, so
+// module for program counter is found with binary search instead of walking
+// all dependency trees.
+// Modules loaded from same memory mapped image shares text, so ranges are
+// either equal or disjoint and one address may belong to more modules.
+// LOT base addresses are kept in separate sorted table, since supervisor
+// calls and lazy bindings identifies module by LOT.
+class ModuleIndex
+{
+public:
+  struct Range
+  {
+    std::size_t start;
+    std::size_t end;
+    Module     *module;
+  };
+
+  ModuleIndex()                    = default;
+  ModuleIndex(const ModuleIndex &) = delete;
+
+  // Module removes own ranges on destruction and updates them when moved
+  bool insert(Module &module);
+  void remove(const Module &module);
+  void relocate(const Module &from, Module &to);
+
+  // Returns ranges containing program counter
+  std::span<const Range> find(std::size_t program_counter) const;
+  Module                *find_with_lot(std::size_t lot_address) const;
+  std::size_t            size() const;
+
+private:
+  struct Lot
+  {
+    std::size_t address;
+    Module     *module;
+  };
+
+  std::vector<Range, ModuleAllocator<Range>> ranges_;
+  std::vector<Lot, ModuleAllocator<Lot>>     lots_;
+};
+
+} // namespace yasld
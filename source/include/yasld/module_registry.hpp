@@ -0,0 +1,87 @@
+/**
+ * module_registry.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "yasld/allocator.hpp"
+
+namespace yasld
+{
+
+class Module;
+class ModuleRegistry;
+
+// Drops one reference to module owned by registry
+class SharedModuleReleaser
+{
+public:
+  SharedModuleReleaser();
+  explicit SharedModuleReleaser(ModuleRegistry *registry);
+
+  void operator()(Module *module) const;
+
+private:
+  ModuleRegistry *registry_;
+};
+
+using SharedModule = std::unique_ptr<Module, SharedModuleReleaser>;
+
+// Modules loaded as dependencies are kept in registry, so each image is
+// loaded only once. Consumers share text, LOT, data and bss of single
+// instance, module is finalized and destroyed when last consumer releases it.
+class ModuleRegistry
+{
+public:
+  ModuleRegistry()                       = default;
+  ModuleRegistry(const ModuleRegistry &) = delete;
+
+  // Returns new reference to module loaded from image, if exists. Image is
+  // identified by its address or by ImageSource, names are not kept, since
+  // they may point to image of consumer released before dependency.
+  SharedModule find(const void *image_address);
+
+  // Takes ownership of loaded module, module must be allocated with
+  // AllocationType::Module or at start of AllocationType::Arena block.
+  // On allocation failure returns empty pointer and module stays with caller
+  SharedModule insert(const void *image_address, Module *module);
+
+  std::size_t get_reference_count(const Module *module) const;
+  std::size_t size() const;
+
+private:
+  friend class SharedModuleReleaser;
+
+  void release(Module *module);
+
+  struct Entry
+  {
+    const void *image_address;
+    Module     *module;
+    std::size_t references;
+  };
+
+  std::vector<Entry, ModuleAllocator<Entry>> entries_;
+};
+
+} // namespace yasld
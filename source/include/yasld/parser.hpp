@@ -21,21 +21,22 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 #include <span>
 #include <string_view>
 
 #include "yasld/data_relocation.hpp"
 #include "yasld/dependency_list.hpp"
+#include "yasld/header.hpp"
 #include "yasld/local_relocation.hpp"
 #include "yasld/relocation.hpp"
 #include "yasld/relocation_table.hpp"
+#include "yasld/symbol_hash_table.hpp"
 #include "yasld/symbol_table.hpp"
 
 namespace yasld
 {
 
-class Header;
-
 class Parser
 {
 public:
@@ -43,6 +44,7 @@ public:
 
   const SymbolTable                      get_exported_symbol_table() const;
   const SymbolTable                      get_imported_symbol_table() const;
+  const std::optional<SymbolHashTable>  &get_exported_symbol_hash_table() const;
 
   const RelocationTable<LocalRelocation> get_local_relocations() const;
   const RelocationTable<DataRelocation>  get_data_relocations() const;
@@ -51,13 +53,20 @@ public:
   std::span<const std::byte>             get_data() const;
   std::span<const std::size_t>           get_init() const;
   std::span<const std::byte>             get_text() const;
+  // Address of image used to resolve read only data placed in text
+  std::optional<std::uintptr_t>          get_link_address() const;
 
   const std::string_view                &name() const;
+  // Location of sections as stored in image
+  const SectionDirectory                &section_directory() const;
 
   const DependencyList                  &get_imported_libraries() const;
 
 private:
+  std::uintptr_t address_of(const SectionDirectory::Entry &entry) const;
+
   const Header                          *header_;
+  const SectionDirectory                 directory_;
 
   std::string_view                       name_;
   const DependencyList                   imported_libaries_;
@@ -67,6 +76,7 @@ private:
 
   const SymbolTable                      imported_symbol_table_;
   const SymbolTable                      exported_symbol_table_;
+  std::optional<SymbolHashTable>         exported_symbol_hash_table_;
 
   const uintptr_t                        text_address_;
   const uintptr_t                        init_address_;
@@ -0,0 +1,59 @@
+/**
+ * placement.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "yasld/allocator.hpp"
+
+namespace yasld
+{
+
+// Where text of module is executed from
+enum class TextPlacement : uint8_t
+{
+  // Text is executed from image, i.e. memory mapped flash. Images read from
+  // ImageSource and libraries with direct calls are always copied to RAM
+  ExecuteInPlace,
+  // Text is copied to memory allocated with AllocationType::Text
+  CopyToRam,
+  // Text is copied to memory region registered in loader
+  CopyToRegion
+};
+
+struct Placement
+{
+  TextPlacement    text = TextPlacement::ExecuteInPlace;
+  // Name of memory region for TextPlacement::CopyToRegion
+  std::string_view region;
+};
+
+// Memory for text of modules, i.e. zero wait state SRAM or TCM. Allocator
+// receives AllocationType::Text, memory must be executable
+struct MemoryRegion
+{
+  std::string_view name;
+  AllocatorType    allocate;
+  ReleaseType      release;
+};
+
+} // namespace yasld
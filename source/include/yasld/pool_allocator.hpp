@@ -0,0 +1,254 @@
+/**
+ * pool_allocator.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+
+#include "yasld/allocator.hpp"
+
+namespace yasld
+{
+
+// NumberOfBlocks blocks of BlockSize bytes. Released blocks are kept on
+// intrusive free list and blocks never used are taken from end of storage,
+// so allocation and release take constant time.
+template <std::size_t BlockSize, std::size_t NumberOfBlocks>
+class FixedBlockPool
+{
+public:
+  static_assert(
+    BlockSize % alignof(std::max_align_t) == 0,
+    "Blocks must be aligned to max_align_t");
+  static_assert(NumberOfBlocks > 0, "Pool must contain blocks");
+
+  constexpr static std::size_t block_size       = BlockSize;
+  constexpr static std::size_t number_of_blocks = NumberOfBlocks;
+
+  FixedBlockPool()
+    : free_{ nullptr }
+    , unused_{ 0 }
+    , used_{ 0 }
+    , peak_{ 0 }
+  {
+  }
+
+  // Free list points to blocks of this pool
+  FixedBlockPool(const FixedBlockPool &)            = delete;
+  FixedBlockPool &operator=(const FixedBlockPool &) = delete;
+
+  void *allocate()
+  {
+    void *block = nullptr;
+    if (free_ != nullptr)
+    {
+      block = free_;
+      free_ = free_->next;
+    }
+    else if (unused_ < NumberOfBlocks)
+    {
+      block = memory_.data() + unused_ * BlockSize;
+      ++unused_;
+    }
+    else
+    {
+      return nullptr;
+    }
+    ++used_;
+    peak_ = std::max(peak_, used_);
+    return block;
+  }
+
+  void release(void *block)
+  {
+    free_ = new (block) FreeBlock{ free_ };
+    --used_;
+  }
+
+  bool contains(const void *block) const
+  {
+    const auto address = reinterpret_cast<std::uintptr_t>(block);
+    const auto begin   = reinterpret_cast<std::uintptr_t>(memory_.data());
+    return address >= begin && address < begin + memory_.size();
+  }
+
+  std::size_t used_blocks() const
+  {
+    return used_;
+  }
+
+  // Highest number of used blocks, for tuning of pool sizes
+  std::size_t peak_blocks() const
+  {
+    return peak_;
+  }
+
+private:
+  struct FreeBlock
+  {
+    FreeBlock *next;
+  };
+
+  alignas(std::max_align_t) std::array<std::byte, BlockSize * NumberOfBlocks>
+    memory_;
+  FreeBlock  *free_;
+  std::size_t unused_;
+  std::size_t used_;
+  std::size_t peak_;
+};
+
+// Allocator for loader with separate pool for each size class. Allocation
+// is taken from smallest pool with free block that fits it, so it takes
+// constant time and memory doesn't fragment under load and unload of
+// modules. Allocations that don't fit in any pool are passed to fallback,
+// i.e. malloc, when it is set. Pools must be sorted by block size.
+//
+//   DefaultPoolAllocator pool;
+//   Loader               loader(pool.get_allocator(), pool.get_release());
+template <typename... Pools>
+class PoolAllocator
+{
+public:
+  static_assert(sizeof...(Pools) > 0, "At least one pool is needed");
+
+  constexpr static std::array<std::size_t, sizeof...(Pools)> block_sizes = {
+    Pools::block_size...
+  };
+  static_assert(
+    std::is_sorted(block_sizes.begin(), block_sizes.end()),
+    "Pools must be sorted by block size");
+
+  PoolAllocator()
+    : pools_{}
+    , fallback_allocator_{}
+    , fallback_release_{}
+  {
+  }
+
+  PoolAllocator(
+    const AllocatorType &fallback_allocator,
+    const ReleaseType   &fallback_release)
+    : pools_{}
+    , fallback_allocator_{ fallback_allocator }
+    , fallback_release_{ fallback_release }
+  {
+  }
+
+  // Returned allocator and release keep pointer to this object
+  PoolAllocator(const PoolAllocator &)            = delete;
+  PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+  void *allocate(std::size_t size, AllocationType type)
+  {
+    void *block         = nullptr;
+    auto  allocate_from = [size, &block](auto &pool)
+    {
+      if (block == nullptr && size <= pool.block_size)
+      {
+        block = pool.allocate();
+      }
+    };
+    std::apply(
+      [&allocate_from](auto &...pools)
+      {
+        (allocate_from(pools), ...);
+      },
+      pools_);
+
+    if (block == nullptr && fallback_allocator_)
+    {
+      block = fallback_allocator_(size, type);
+    }
+    return block;
+  }
+
+  void release(void *data)
+  {
+    if (data == nullptr)
+    {
+      return;
+    }
+
+    bool released   = false;
+    auto release_to = [data, &released](auto &pool)
+    {
+      if (!released && pool.contains(data))
+      {
+        pool.release(data);
+        released = true;
+      }
+    };
+    std::apply(
+      [&release_to](auto &...pools)
+      {
+        (release_to(pools), ...);
+      },
+      pools_);
+
+    if (!released && fallback_release_)
+    {
+      fallback_release_(data);
+    }
+  }
+
+  AllocatorType get_allocator()
+  {
+    return [this](std::size_t size, AllocationType type)
+    {
+      return allocate(size, type);
+    };
+  }
+
+  ReleaseType get_release()
+  {
+    return [this](void *data)
+    {
+      release(data);
+    };
+  }
+
+  template <std::size_t Index>
+  const auto &get_pool() const
+  {
+    return std::get<Index>(pools_);
+  }
+
+private:
+  std::tuple<Pools...> pools_;
+  AllocatorType        fallback_allocator_;
+  ReleaseType          fallback_release_;
+};
+
+// Sized for few modules on Cortex-M. Small blocks hold loader bookkeeping
+// and LOTs, middle ones module objects, init and data of small modules, big
+// ones module arenas. Peak blocks of each pool should be checked on target
+// and pools resized for application.
+using DefaultPoolAllocator = PoolAllocator<
+  FixedBlockPool<32, 32>,
+  FixedBlockPool<128, 16>,
+  FixedBlockPool<512, 8>,
+  FixedBlockPool<2048, 4>>;
+
+} // namespace yasld
@@ -0,0 +1,51 @@
+/**
+ * prelink_cache.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace yasld
+{
+
+// Storage for imports resolved during previous load of the module.
+// Addresses are kept in order of symbol table relocations from image.
+// Fingerprint covers environment and placement of all dependencies, entry
+// recorded with other fingerprint must not be used.
+// Runtime may keep entries in persistent memory to skip symbol resolution
+// on next boot.
+class PrelinkCache
+{
+public:
+  virtual ~PrelinkCache() = default;
+
+  virtual std::optional<std::span<const std::size_t>> find(
+    const void *module_address,
+    uint32_t    fingerprint) const = 0;
+
+  virtual void store(
+    const void                        *module_address,
+    uint32_t                           fingerprint,
+    const std::span<const std::size_t> imports) = 0;
+};
+
+} // namespace yasld
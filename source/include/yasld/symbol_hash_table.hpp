@@ -0,0 +1,72 @@
+/**
+ * symbol_hash_table.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "yasld/symbol.hpp"
+
+namespace yasld
+{
+
+// GNU hash style index over exported symbol table generated by mkimage.
+// Symbols in table are sorted by bucket, each bucket points to first
+// symbol in chain, chain entries keeps symbol hash with lowest bit marking
+// end of chain. Bloom filter rejects most of missing names without touching
+// buckets.
+class SymbolHashTable
+{
+public:
+  SymbolHashTable(
+    std::uintptr_t address,
+    std::uintptr_t symbol_table_address,
+    uint16_t       number_of_symbols);
+
+  [[nodiscard]] static uint32_t hash(const std::string_view &name);
+
+  [[nodiscard]] const Symbol   *find(
+    const std::string_view &name,
+    uint32_t                hash) const;
+
+  [[nodiscard]] std::uintptr_t  address() const;
+  [[nodiscard]] std::size_t     size() const;
+
+private:
+  struct Layout
+  {
+    uint32_t number_of_buckets;
+    uint32_t bloom_size;
+    uint32_t bloom_shift;
+  };
+
+  constexpr static uint32_t empty_bucket = 0xffffffff;
+
+  const Layout   *layout_;
+  const uint32_t *bloom_;
+  const uint32_t *buckets_;
+  const uint32_t *chain_;
+  const uint32_t *offsets_;
+  std::uintptr_t  symbol_table_address_;
+  uint16_t        number_of_symbols_;
+};
+
+} // namespace yasld
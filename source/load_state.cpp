@@ -0,0 +1,71 @@
+/**
+ * load_state.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/load_state.hpp"
+
+namespace yasld
+{
+
+SymbolCursor::SymbolCursor(const SymbolTable &table)
+  : begin_{ table.begin() }
+  , current_{ begin_ }
+  , index_{ 0 }
+{
+}
+
+const Symbol &SymbolCursor::seek(uint32_t index)
+{
+  if (index < index_)
+  {
+    current_ = begin_;
+    index_   = 0;
+  }
+  for (; index_ < index; ++index_)
+  {
+    ++current_;
+  }
+  return *current_;
+}
+
+LoadState::LoadState(
+  const void  *image,
+  ImageSource *image_source,
+  Module      *loaded_module)
+  : module_address{ image }
+  , source{ image_source }
+  , module{ loaded_module }
+  , header{ nullptr }
+  , parser{}
+  , stage{ LoadStage::Header }
+  , cursor{ 0 }
+  , dependency{}
+  , symbols{}
+  , decoder{}
+  , lazy_bindings{ 0 }
+  , hash{}
+  , tree_hash{}
+  , fingerprint{}
+  , prelinked_imports{}
+  , resolved_imports{}
+  , lazy{ false }
+{
+}
+
+} // namespace yasld
@@ -20,49 +20,544 @@
 
 #include "yasld/loader.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cstring>
+#include <iterator>
+#include <limits>
 
 #include "yasld/environment.hpp"
+#include "yasld/fingerprint.hpp"
 #include "yasld/header.hpp"
+#include "yasld/image_source.hpp"
+#include "yasld/lazy_binding.hpp"
 #include "yasld/logger.hpp"
 #include "yasld/parser.hpp"
+#include "yasld/prelink_cache.hpp"
 #include "yasld/symbol.hpp"
 
 namespace yasld
 {
 
+namespace
+{
+
+constexpr auto is_task_before = [](const auto &task, std::size_t id)
+{
+  return task.id < id;
+};
+
+// With arena module object is placed at start of block with its regions, so
+// releasing module releases whole block
+template <typename T>
+Module *allocate_module(const Header &header, bool arena)
+{
+  const std::size_t object_size = Module::align_arena(sizeof(T));
+  const std::size_t size =
+    arena ? object_size + Module::get_arena_size(header) : sizeof(T);
+  const AllocationType type =
+    arena ? AllocationType::Arena : AllocationType::Module;
+  std::byte *memory = static_cast<std::byte *>(
+    YasldAllocatorHolder::get().allocate(size, type));
+  if (memory == nullptr)
+  {
+    return nullptr;
+  }
+
+  T *module = new (memory) T;
+  module->set_allocation(size, type);
+  if (arena)
+  {
+    module->set_arena({ memory + object_size, size - object_size });
+  }
+  return module;
+}
+
+std::span<const std::byte> as_bytes(const SymbolTable &table)
+{
+  return { reinterpret_cast<const std::byte *>(table.address()),
+           table.size() };
+}
+
+// Prelinked LOT depends on exported symbols of dependencies and on order of
+// own imports, image may be reflashed at the same address with these changed
+std::array<std::span<const std::byte>, 3> get_content(
+  const Header &header,
+  const Parser &parser)
+{
+  const std::size_t header_size =
+    header.section_directory() != nullptr
+      ? sizeof(Header) + sizeof(SectionDirectory)
+      : sizeof(Header);
+  return { std::span(reinterpret_cast<const std::byte *>(&header), header_size),
+           as_bytes(parser.get_exported_symbol_table()),
+           as_bytes(parser.get_imported_symbol_table()) };
+}
+
+} // namespace
+
 Loader::Loader(const AllocatorType &allocator, const ReleaseType &release)
   : environment_{ nullptr }
+  , prelink_cache_{ nullptr }
+  , lazy_binding_{ false }
+  , module_arena_{ true }
+  , placement_{}
+  , call_contexts_{ call_context_depth }
+  , active_call_contexts_{ &call_contexts_ }
 {
   YasldAllocatorHolder::get().set_allocator(allocator);
   YasldAllocatorHolder::get().set_release(release);
+  allocate_call_contexts();
 }
 
 Loader::Loader()
   : environment_{ nullptr }
+  , prelink_cache_{ nullptr }
+  , lazy_binding_{ false }
+  , module_arena_{ true }
+  , placement_{}
+  , call_contexts_{ call_context_depth }
+  , active_call_contexts_{ &call_contexts_ }
 {
+  allocate_call_contexts();
 }
 
-void Loader::set_environment(const Environment &environment)
+void Loader::allocate_call_contexts()
 {
+  // push fails without memory, so each call into module faults in
+  // supervisor call until stack is allocated
+  if (!call_contexts_.allocate())
+  {
+    log("Loader can't call into modules, no call context stack\n");
+  }
+}
+
+Loader::~Loader()
+{
+  abort_loading();
+  // modules outliving loader would remove themselves from destroyed index
+  // and release dependencies to destroyed registry
+  assert(index_.size() == 0 && "Modules must be dropped before loader");
+  assert(registry_.size() == 0 && "Modules must be dropped before loader");
+}
+
+bool Loader::set_environment(const Environment &environment)
+{
+  if (!environment.is_valid())
+  {
+    log("Environment is invalid, symbol table must be sorted by name\n");
+    return false;
+  }
   environment_ = &environment;
+  warm_environment_fingerprint();
+  return true;
 }
 
-bool Loader::load_module(const void *module_address, Module &module)
+void Loader::set_prelink_cache(PrelinkCache &cache)
 {
-  log("Loading module from address: %p\n", module_address);
+  prelink_cache_ = &cache;
+  warm_environment_fingerprint();
+}
 
-  const Header *header = process_header(module_address);
-  if (!header)
+void Loader::warm_environment_fingerprint() const
+{
+  // environment is hashed once, outside of budgeted loading steps
+  if (environment_ != nullptr && prelink_cache_ != nullptr)
+  {
+    static_cast<void>(environment_->fingerprint());
+  }
+}
+
+bool Loader::set_lazy_binding(bool enabled)
+{
+  if (enabled && !lazy_binding_supported)
+  {
+    log("Lazy binding is not supported on this architecture\n");
+    return false;
+  }
+  lazy_binding_ = enabled;
+  return true;
+}
+
+void Loader::set_module_arena(bool enabled)
+{
+  module_arena_ = enabled;
+}
+
+void Loader::set_placement(const Placement &placement)
+{
+  placement_ = placement;
+}
+
+void Loader::register_placement_resolver(
+  const PlacementResolverType &resolver)
+{
+  placement_resolver_ = resolver;
+}
+
+bool Loader::add_memory_region(const MemoryRegion &region)
+{
+  const std::size_t size = memory_regions_.size();
+  memory_regions_.push_back(region);
+  return memory_regions_.size() == size + 1;
+}
+
+const MemoryUsage &Loader::get_memory_usage() const
+{
+  return YasldAllocatorHolder::get().get_usage();
+}
+
+void Loader::reset_memory_peak()
+{
+  YasldAllocatorHolder::get().get_usage().reset_peak();
+}
+
+std::optional<Loader::ObservedExecutable> Loader::load_executable(
+  const void *module_address)
+{
+  if (!start_loading_executable(module_address))
+  {
+    return std::nullopt;
+  }
+
+  if (step(std::numeric_limits<std::size_t>::max()) != LoadStatus::Done)
+  {
+    return std::nullopt;
+  }
+  return take_executable();
+}
+
+std::optional<Loader::ObservedLibrary> Loader::load_library(
+  const void *module_address)
+{
+  if (!start_loading_library(module_address))
+  {
+    return std::nullopt;
+  }
+
+  if (step(std::numeric_limits<std::size_t>::max()) != LoadStatus::Done)
+  {
+    return std::nullopt;
+  }
+  return take_library();
+}
+
+std::optional<Loader::ObservedExecutable> Loader::load_executable(
+  ImageSource &source)
+{
+  if (!start_loading_executable(source))
+  {
+    return std::nullopt;
+  }
+
+  if (step(std::numeric_limits<std::size_t>::max()) != LoadStatus::Done)
+  {
+    return std::nullopt;
+  }
+  return take_executable();
+}
+
+std::optional<Loader::ObservedLibrary> Loader::load_library(
+  ImageSource &source)
+{
+  if (!start_loading_library(source))
+  {
+    return std::nullopt;
+  }
+
+  if (step(std::numeric_limits<std::size_t>::max()) != LoadStatus::Done)
+  {
+    return std::nullopt;
+  }
+  return take_library();
+}
+
+bool Loader::start_loading_executable(const void *module_address)
+{
+  return start_loading(module_address, nullptr, true);
+}
+
+bool Loader::start_loading_library(const void *module_address)
+{
+  return start_loading(module_address, nullptr, false);
+}
+
+bool Loader::start_loading_executable(ImageSource &source)
+{
+  return start_loading(&source, &source, true);
+}
+
+bool Loader::start_loading_library(ImageSource &source)
+{
+  return start_loading(&source, &source, false);
+}
+
+bool Loader::start_loading(
+  const void  *module_address,
+  ImageSource *source,
+  bool         executable)
+{
+  if (!load_stack_.empty())
+  {
+    log("Other module is being loaded\n");
+    return false;
+  }
+
+  pending_executable_.reset();
+  pending_library_.reset();
+  Module *module = nullptr;
+  if (executable)
+  {
+    module = &*pending_executable_.emplace();
+  }
+  else
+  {
+    module = &*pending_library_.emplace();
+  }
+  return push_load_state(module_address, source, module);
+}
+
+void Loader::unload(ObservedExecutable executable)
+{
+  log("Unloading executable: %s\n", executable->get_name().data());
+  executable->finalize();
+}
+
+void Loader::unload(ObservedLibrary library)
+{
+  log("Unloading library: %s\n", library->get_name().data());
+  library->finalize();
+}
+
+std::optional<Loader::ObservedExecutable> Loader::take_executable()
+{
+  if (!load_stack_.empty() || !pending_executable_)
+  {
+    return std::nullopt;
+  }
+
+  std::optional<ObservedExecutable> executable(
+    std::move(pending_executable_));
+  pending_executable_.reset();
+  return executable;
+}
+
+std::optional<Loader::ObservedLibrary> Loader::take_library()
+{
+  if (!load_stack_.empty() || !pending_library_)
+  {
+    return std::nullopt;
+  }
+
+  std::optional<ObservedLibrary> library(std::move(pending_library_));
+  pending_library_.reset();
+  return library;
+}
+
+Loader::LoadStatus Loader::step(std::size_t budget)
+{
+  while (!load_stack_.empty() && budget != 0)
+  {
+    // loading of dependency pushes new state, so reference is not kept
+    if (!process_load_stage(load_stack_.back(), budget))
+    {
+      abort_loading();
+      return LoadStatus::Failed;
+    }
+
+    if (load_stack_.back().stage == LoadStage::Done && !finish_module())
+    {
+      abort_loading();
+      return LoadStatus::Failed;
+    }
+  }
+
+  if (!load_stack_.empty())
+  {
+    return LoadStatus::InProgress;
+  }
+  return pending_executable_ || pending_library_ ? LoadStatus::Done
+                                                 : LoadStatus::Failed;
+}
+
+bool Loader::push_load_state(
+  const void  *module_address,
+  ImageSource *source,
+  Module      *module)
+{
+  const std::size_t size = load_stack_.size();
+  load_stack_.emplace_back(module_address, source, module);
+  if (load_stack_.size() != size + 1)
+  {
+    log("Load state allocation failure\n");
+    return false;
+  }
+  return true;
+}
+
+void Loader::set_stage(LoadState &state, LoadStage stage)
+{
+  state.stage  = stage;
+  state.cursor = 0;
+}
+
+bool Loader::process_load_stage(LoadState &state, std::size_t &budget)
+{
+  switch (state.stage)
+  {
+  case LoadStage::Header:
+    --budget;
+    return process_module_header(state);
+  case LoadStage::ContentFingerprint:
+    process_content_fingerprint(state, budget);
+    return true;
+  case LoadStage::Init:
+    return process_init(state, budget);
+  case LoadStage::Text:
+    return process_text(state, budget);
+  case LoadStage::Dependencies:
+    return process_dependencies(state, budget);
+  case LoadStage::Data:
+    return process_data(state, budget);
+  case LoadStage::Bss:
+    process_bss(state, budget);
+    return true;
+  case LoadStage::Imports:
+    --budget;
+    return process_imports(state);
+  case LoadStage::PrelinkFingerprint:
+    return process_prelink_fingerprint(state, budget);
+  case LoadStage::PrelinkedImports:
+    process_prelinked_imports(state, budget);
+    return true;
+  case LoadStage::LazyBindings:
+    return count_lazy_bindings(state, budget);
+  case LoadStage::SymbolRelocations:
+    return process_symbol_table_relocations(state, budget);
+  case LoadStage::LocalRelocations:
+    process_local_relocations(state, budget);
+    return true;
+  case LoadStage::DataRelocations:
+    process_data_relocations(state, budget);
+    return true;
+  case LoadStage::Entry:
+    --budget;
+    process_entry(state);
+    return true;
+  case LoadStage::Done:
+    return true;
+  }
+  return false;
+}
+
+bool Loader::finish_module()
+{
+  const void *module_address = load_stack_.back().module_address;
+  Module     *module         = load_stack_.back().module;
+  // module is still on stack, so abort_loading releases it on failure
+  if (!index_.insert(*module))
   {
     return false;
   }
 
-  const Parser      parser(header);
+  if (load_stack_.size() == 1)
+  {
+    load_stack_.pop_back();
+    if (pending_executable_)
+    {
+      if (!(*pending_executable_)->initialize_main())
+      {
+        return false;
+      }
+      executables_.push_back(*pending_executable_);
+    }
+    else
+    {
+      libraries_.push_back(*pending_library_);
+    }
+    return true;
+  }
+
+  LoadState &parent  = load_stack_[load_stack_.size() - 2];
+  auto      &modules = parent.module->get_modules();
+  modules.reserve(modules.size() + 1);
+  if (modules.capacity() < modules.size() + 1)
+  {
+    log("Dependency allocation failure\n");
+    return false;
+  }
+  auto shared = registry_.insert(module_address, module);
+  if (!shared)
+  {
+    return false;
+  }
+  load_stack_.pop_back();
+  modules.push_back(std::move(shared));
+  ++parent.cursor;
+  ++*parent.dependency;
+  return true;
+}
+
+void Loader::abort_loading()
+{
+  // requested module is owned by loader, dependencies are not registered yet
+  while (load_stack_.size() > 1)
+  {
+    Module *module = load_stack_.back().module;
+    load_stack_.pop_back();
+    Module::destroy(module);
+  }
+  load_stack_.clear();
+  pending_executable_.reset();
+  pending_library_.reset();
+}
+
+bool Loader::process_module_header(LoadState &state)
+{
+  log("Loading module from address: %p\n", state.module_address);
+
+  if (state.source != nullptr)
+  {
+    if (!read_module_image(state))
+    {
+      return false;
+    }
+  }
+  else
+  {
+    state.header = process_header(state.module_address);
+  }
+
+  if (!state.header)
+  {
+    return false;
+  }
+
+  const Header &header = *state.header;
+  const Parser &parser = state.parser.emplace(state.header);
+  Module       &module = *state.module;
   const std::size_t lot_size =
-    header->symbol_table_relocations_amount + header->local_relocations_amount;
+    header.symbol_table_relocations_amount + header.local_relocations_amount;
+
+  if (!check_link_address(state))
+  {
+    return false;
+  }
 
   module.set_name(parser.name());
+  module.set_exported_symbol_table(parser.get_exported_symbol_table());
+  module.set_exported_symbol_hash_table(
+    parser.get_exported_symbol_hash_table());
+
+  // dependencies are placed in arena by allocate_dependency
+  if (
+    module_arena_ && &state == &load_stack_.front() &&
+    !module.allocate_arena(Module::get_arena_size(header)))
+  {
+    log("Arena allocation failure\n");
+    return false;
+  }
 
   log("Allocation of LOT with size: %d\n", lot_size);
   if (!module.allocate_lot(lot_size))
@@ -76,198 +571,733 @@ bool Loader::load_module(const void *module_address, Module &module)
     module.get_lot().data(),
     module.get_lot().size());
 
-  module.set_text(parser.get_text());
-  module.relocate_init(parser.get_init());
+  // text is copied in text stage, init entries are relocated against it
+  if (!place_text(state))
+  {
+    log("Text allocation failure\n");
+    return false;
+  }
+
+  // init is copied in init stage, after content fingerprint
+  if (!module.allocate_init(parser.get_init().size()))
+  {
+    log("Init allocation failure\n");
+    return false;
+  }
+
+  if (!module.set_fini_amount(header.fini_array_amount))
+  {
+    return false;
+  }
+
+  if (header.external_libraries_amount)
+  {
+    if (!module.allocate_modules(header.external_libraries_amount))
+    {
+      log("Modules allocation failed\n");
+      return false;
+    }
+    if (!file_resolver_ && !source_resolver_)
+    {
+      log("Module has imported libraries, but file resolver not "
+          "set!\n");
+      return false;
+    }
+  }
+
+  state.dependency = parser.get_imported_libraries().begin();
+  set_stage(
+    state,
+    prelink_cache_ != nullptr ? LoadStage::ContentFingerprint
+                              : LoadStage::Init);
+  return true;
+}
+
+void Loader::process_content_fingerprint(
+  LoadState   &state,
+  std::size_t &budget)
+{
+  const auto  content = get_content(*state.header, *state.parser);
+  std::size_t size    = 0;
+  for (const auto &region : content)
+  {
+    size += region.size();
+  }
+
+  // cursor is offset in regions placed one after another
+  for (; state.cursor < size && budget != 0; --budget)
+  {
+    std::size_t offset = state.cursor;
+    auto        region = content.begin();
+    while (offset >= region->size())
+    {
+      offset -= region->size();
+      ++region;
+    }
+    const auto block = region->subspan(
+      offset, std::min(load_block_size, region->size() - offset));
+    state.hash.add(block);
+    state.cursor += block.size();
+  }
+
+  if (state.cursor == size)
+  {
+    state.module->set_content_fingerprint(state.hash.value());
+    set_stage(state, LoadStage::Init);
+  }
+}
+
+bool Loader::process_init(LoadState &state, std::size_t &budget)
+{
+  constexpr std::size_t block_size = load_block_size / sizeof(std::size_t);
+  const auto            init       = state.module->get_init();
+
+  for (; state.cursor < init.size() && budget != 0; --budget)
+  {
+    const auto block = init.subspan(
+      state.cursor, std::min(block_size, init.size() - state.cursor));
+    if (state.source != nullptr)
+    {
+      const std::size_t offset =
+        state.header->section_directory()->init.offset +
+        state.cursor * sizeof(std::size_t);
+      if (!state.source->read(offset, std::as_writable_bytes(block)))
+      {
+        log("Image read failure\n");
+        return false;
+      }
+    }
+    else
+    {
+      const auto image = state.parser->get_init().subspan(state.cursor);
+      std::copy_n(image.begin(), block.size(), block.begin());
+    }
+    state.module->relocate_init(block);
+    state.cursor += block.size();
+  }
+
+  if (state.cursor == init.size())
+  {
+    set_stage(state, LoadStage::Text);
+  }
+  return true;
+}
+
+bool Loader::check_link_address(const LoadState &state) const
+{
+  if (!state.header->has(Header::Flag::ReadOnlyDataInText))
+  {
+    return true;
+  }
+
+  // read only data in text points to memory mapped image
+  if (state.source != nullptr)
+  {
+    log("Image with read only data in text can't be loaded from source\n");
+    return false;
+  }
+
+  const auto address = state.parser->get_link_address();
+  if (address != reinterpret_cast<std::uintptr_t>(state.header))
+  {
+    log(
+      "Image linked for address 0x%x placed at %p\n",
+      address.value_or(0),
+      state.header);
+    return false;
+  }
+  return true;
+}
+
+bool Loader::place_text(LoadState &state)
+{
+  const Header &header    = *state.header;
+  Module       &module    = *state.module;
+  Placement     placement = placement_;
+  if (placement_resolver_)
+  {
+    placement = placement_resolver_(module.get_name()).value_or(placement);
+  }
+
+  // text of image read from source can't be executed in place, neither
+  // compressed text or text of library with direct calls, since LOT base is
+  // stored in it
+  if (
+    placement.text == TextPlacement::ExecuteInPlace &&
+    state.source == nullptr && !header.has(Header::Flag::DirectCalls) &&
+    !header.has(Header::Flag::CompressedText))
+  {
+    module.set_text(state.parser->get_text());
+    return true;
+  }
+
+  if (placement.text != TextPlacement::CopyToRegion)
+  {
+    return module.allocate_text(header.code_length);
+  }
+
+  const auto region = std::find_if(
+    memory_regions_.begin(),
+    memory_regions_.end(),
+    [&placement](const MemoryRegion &candidate)
+    {
+      return candidate.name == placement.region;
+    });
+  if (region == memory_regions_.end())
+  {
+    log("Memory region %s not found\n", placement.region.data());
+    return false;
+  }
+  log(
+    "Placing text of %s in %s\n",
+    module.get_name().data(),
+    placement.region.data());
+  return module.allocate_text(header.code_length, *region);
+}
+
+bool Loader::read_module_image(LoadState &state)
+{
+  std::array<std::byte, sizeof(Header) + sizeof(SectionDirectory)> prefix;
+  if (!state.source->read(0, prefix))
+  {
+    log("Image read failure\n");
+    return false;
+  }
+
+  const Header *header = process_header(prefix.data());
+  if (!header)
+  {
+    return false;
+  }
+
+  const SectionDirectory *directory = header->section_directory();
+  if (directory == nullptr)
+  {
+    log("Image without section directory can't be read from source\n");
+    return false;
+  }
+
+  // header, directory and tables precede text
+  const std::size_t size = directory->text.offset;
+  log("Reading image tables, size: %d\n", size);
+  if (!state.module->allocate_image(size))
+  {
+    log("Image allocation failure\n");
+    return false;
+  }
+
+  if (!state.source->read(0, state.module->get_image()))
+  {
+    log("Image read failure\n");
+    return false;
+  }
+  state.header = reinterpret_cast<const Header *>(
+    state.module->get_image().data());
+  return true;
+}
+
+bool Loader::copy_section(
+  LoadState                     &state,
+  std::size_t                   &budget,
+  const SectionDirectory::Entry &section,
+  std::span<std::byte>           destination,
+  bool                           compressed)
+{
+  if (!compressed && section.size != destination.size())
+  {
+    log("Section size mismatch\n");
+    return false;
+  }
+
+  if (compressed && state.cursor == 0)
+  {
+    state.decoder.emplace(destination);
+  }
+
+  const auto *image = reinterpret_cast<const std::byte *>(state.header);
+  for (; state.cursor < section.size && budget != 0; --budget)
+  {
+    const std::size_t size =
+      std::min(load_block_size, section.size - state.cursor);
+    // raw blocks are copied to destination, compressed are decoded from
+    // memory mapped image or from buffer
+    std::array<std::byte, load_block_size> buffer;
+    std::span<const std::byte>             block;
+    if (state.source != nullptr)
+    {
+      const auto read = compressed ? std::span(buffer).first(size)
+                                   : destination.subspan(state.cursor, size);
+      if (!state.source->read(section.offset + state.cursor, read))
+      {
+        log("Image read failure\n");
+        return false;
+      }
+      block = read;
+    }
+    else
+    {
+      block = std::span(image + section.offset + state.cursor, size);
+      if (!compressed)
+      {
+        std::memcpy(destination.data() + state.cursor, block.data(), size);
+      }
+    }
+
+    if (compressed && !state.decoder->decode(block))
+    {
+      log("Corrupted compressed section\n");
+      return false;
+    }
+    state.cursor += size;
+  }
+
+  if (
+    compressed && state.cursor == section.size && !state.decoder->finished())
+  {
+    log("Corrupted compressed section\n");
+    return false;
+  }
+  return true;
+}
+
+bool Loader::process_text(LoadState &state, std::size_t &budget)
+{
+  const auto text = state.module->get_text_memory();
+  // text executed in place is not copied
+  if (!text.empty())
+  {
+    const auto &section = state.parser->section_directory().text;
+    if (!copy_section(
+          state,
+          budget,
+          section,
+          text,
+          state.header->has(Header::Flag::CompressedText)))
+    {
+      return false;
+    }
+
+    if (state.cursor != section.size)
+    {
+      return true;
+    }
+  }
+
+  if (!text.empty())
+  {
+    log("Text copied to: %p, size: 0x%x\n", text.data(), text.size());
+  }
+
+  if (state.header->has(Header::Flag::DirectCalls) && !store_lot_base(state))
+  {
+    return false;
+  }
+
+  set_stage(state, LoadStage::Dependencies);
+  return true;
+}
+
+bool Loader::store_lot_base(LoadState &state)
+{
+  Module &module = *state.module;
+  // dependencies are not loaded yet, so only own symbols are searched
+  const auto slot = module.find_symbol(lot_base_symbol);
+  if (!slot)
+  {
+    log("Module with direct calls doesn't define %s\n", lot_base_symbol);
+    return false;
+  }
+
+  const std::size_t lot_base =
+    reinterpret_cast<std::size_t>(module.get_lot().data());
+  log("Storing LOT base 0x%x at: 0x%x\n", lot_base, *slot);
+  std::memcpy(reinterpret_cast<void *>(*slot), &lot_base, sizeof(lot_base));
+  return true;
+}
+
+bool Loader::process_dependencies(LoadState &state, std::size_t &budget)
+{
+  if (state.cursor == state.header->external_libraries_amount)
+  {
+    const Header &header = *state.header;
+    if (!state.module->allocate_data(header.data_length, header.bss_length))
+    {
+      log("Data allocation failure\n");
+      return false;
+    }
+    log(
+      "Copying data from: %p, to: %p, size: 0x%x\n",
+      state.parser->get_data().data(),
+      state.module->get_data().data(),
+      header.data_length + header.bss_length);
+    set_stage(state, LoadStage::Data);
+    return true;
+  }
+
+  --budget;
+  const auto  &dependency = **state.dependency;
+  ImageSource *source     = nullptr;
+  std::optional<const void *> address;
+  if (file_resolver_)
+  {
+    address = file_resolver_(dependency.name());
+  }
+  if (!address && source_resolver_)
+  {
+    source = source_resolver_(dependency.name());
+    if (source != nullptr)
+    {
+      address = source;
+    }
+  }
+  if (!address)
+  {
+    log("Can't find dependency: %s\n", dependency.name().data());
+    return false;
+  }
+
+  auto shared = registry_.find(*address);
+  if (shared)
+  {
+    state.module->get_modules().push_back(std::move(shared));
+    ++state.cursor;
+    ++*state.dependency;
+    return true;
+  }
+
+  // finish_module moves to next dependency when this one is loaded
+  Module *module = allocate_dependency(*address, source, dependency.name());
+  if (module == nullptr)
+  {
+    return false;
+  }
+
+  if (!push_load_state(*address, source, module))
+  {
+    Module::destroy(module);
+    return false;
+  }
+  return true;
+}
+
+Module *Loader::allocate_dependency(
+  const void             *module_address,
+  ImageSource            *source,
+  const std::string_view &name)
+{
+  std::array<std::byte, sizeof(Header)> buffer;
+  if (source != nullptr)
+  {
+    if (!source->read(0, buffer))
+    {
+      log("Image read failure for: %s\n", name.data());
+      return nullptr;
+    }
+    module_address = buffer.data();
+  }
+
+  const yasld::Header *header =
+    reinterpret_cast<const yasld::Header *>(module_address);
+  if (std::string_view(header->cookie, 4) != "YAFF")
+  {
+    log("Module %s is not YAFF file\n", name.data());
+    return nullptr;
+  }
+
+  Module *module = nullptr;
+  if (header->type == Header::Type::Executable)
+  {
+    module = allocate_module<Executable>(*header, module_arena_);
+  }
+  else if (header->type == Header::Type::Library)
+  {
+    module = allocate_module<Library>(*header, module_arena_);
+  }
+  else
+  {
+    log("Unknown module type for: %s\n", name.data());
+    return nullptr;
+  }
+
+  if (module == nullptr)
+  {
+    log("Module allocation failed for: %s\n", name.data());
+  }
+  return module;
+}
+
+const Header *Loader::process_header(const void *module_address) const
+{
+  const Header *header = static_cast<const Header *>(module_address);
+  if (std::string_view(header->cookie, 4) != "YAFF")
+  {
+    log("It is not YASIFF file, aborting...\n");
+    return nullptr;
+  }
+  if (header->yasiff_version > Header::latest_version)
+  {
+    log("Unsupported YASIFF version: %d\n", header->yasiff_version);
+    return nullptr;
+  }
+  // each architecture executes code of older ones, i.e. armv6-m images are
+  // executed on armv7-m and armv8-m.main cores
+  if (
+    header->arch == Header::Architecture::Unknown ||
+    static_cast<uint16_t>(header->arch) > static_cast<uint16_t>(architecture))
+  {
+    log(
+      "Image for %s can't be executed on %s\n",
+      to_string(header->arch).data(),
+      to_string(architecture).data());
+    return nullptr;
+  }
+  return header;
+}
+
+bool Loader::process_data(LoadState &state, std::size_t &budget)
+{
+  const auto &section = state.parser->section_directory().data;
+  if (!copy_section(
+        state,
+        budget,
+        section,
+        state.module->get_data(),
+        state.header->has(Header::Flag::CompressedData)))
+  {
+    return false;
+  }
+
+  if (state.cursor == section.size)
+  {
+    log(
+      "Initializing .bss at: %p, size: 0x%x\n",
+      state.module->get_bss().data(),
+      state.module->get_bss().size_bytes());
+    set_stage(state, LoadStage::Bss);
+  }
+  return true;
+}
+
+void Loader::process_bss(LoadState &state, std::size_t &budget)
+{
+  const auto bss = state.module->get_bss();
 
-  // import modules
-  if (header->external_libraries_amount)
+  for (; state.cursor < bss.size() && budget != 0; --budget)
   {
-    if (!module.allocate_modules(header->external_libraries_amount))
-    {
-      log("Modules allocation failed\n");
-      return false;
-    }
-    if (!file_resolver_)
-    {
-      log("Module has imported libraries, but file resolver not "
-          "set!\n");
-      return false;
-    }
-
-    auto &modules = module.get_modules();
-    for (const auto &dependency : parser.get_imported_libraries())
-    {
-      const auto address = file_resolver_(dependency.name());
-      if (!address)
-      {
-        return false;
-      }
-      const yasld::Header *dependent_header =
-        reinterpret_cast<const yasld::Header *>(*address);
-      if (std::string_view(dependent_header->cookie, 4) != "YAFF")
-      {
-        log("Module %s is not YAFF file\n", dependency.name().data());
-        return false;
-      }
-      if (dependent_header->type == Header::Type::Executable)
-      {
-        modules.emplace_back(
-          static_cast<Module *>(YasldAllocatorHolder::get().get_allocator()(
-            sizeof(Executable), AllocationType::Module)),
-          YasldDeleter<Module>());
-        new (modules.back().get()) Executable;
-      }
-      else if (dependent_header->type == Header::Type::Library)
-      {
-        modules.emplace_back(
-          static_cast<Module *>(YasldAllocatorHolder::get().get_allocator()(
-            sizeof(Library), AllocationType::Module)),
-          YasldDeleter<Module>());
-        new (modules.back().get()) Library;
-      }
-      else
-      {
-        log("Unknown module type for: %s\n", dependency.name().data());
-        return false;
-      }
-
-      if (!load_module(*address, *modules.back().get()))
-      {
-        return false;
-      }
-    }
+    const std::size_t size =
+      std::min(load_block_size, bss.size() - state.cursor);
+    std::fill_n(bss.begin() + state.cursor, size, std::byte(0));
+    state.cursor += size;
   }
 
-  if (!process_data(*header, parser, module))
+  if (state.cursor == bss.size())
   {
-    log("Data processing failed\n");
-    return false;
+    set_stage(state, LoadStage::Imports);
   }
+}
 
-  module.set_exported_symbol_table(parser.get_exported_symbol_table());
+namespace
+{
+
+bool is_function(const Symbol &symbol)
+{
+  return symbol.section() == Section::code;
+}
+
+// Returns thunk address to be stored in LOT
+std::size_t initialize_lazy_binding(
+  LazyBinding  &binding,
+  std::size_t  *lot,
+  const Symbol &symbol,
+  uint32_t      lot_index)
+{
+  std::copy(
+    std::begin(lazy_binding_thunk),
+    std::end(lazy_binding_thunk),
+    binding.thunk);
+  binding.self = &binding;
+  binding.resolver =
+    reinterpret_cast<std::size_t>(&yasld_lazy_binding_resolver);
+  binding.lot       = lot;
+  binding.symbol    = &symbol;
+  binding.lot_index = lot_index;
+  return reinterpret_cast<std::size_t>(binding.thunk) |
+         lazy_binding_thunk_flags;
+}
+
+} // namespace
+
+bool Loader::process_imports(LoadState &state)
+{
+  Module &module = *state.module;
+
+  log(
+    "Processing symbol table relocations: %d\n",
+    state.parser->get_symbol_table_relocations().span().size());
 
-  if (!process_symbol_table_relocations(parser, module))
+  if (prelink_cache_ == nullptr)
   {
-    log("Symbol table processing failed\n");
-    return false;
+    return start_symbol_resolution(state);
   }
-  process_local_relocations(parser, module);
-  process_data_relocations(parser, module);
 
-  if (header->entry != 0xffffffff && header->type == Header::Type::Executable)
+  // own text and data are not part of fingerprint, only local relocations
+  // depend on them and these are always processed
+  state.hash = Fingerprint{};
+  state.hash.add(reinterpret_cast<std::uintptr_t>(state.module_address))
+    .add(module.get_content_fingerprint());
+  if (environment_)
   {
-    std::size_t base_address = 0;
-    if (header->entry < module.get_text().size_bytes())
-    {
-      base_address = reinterpret_cast<std::size_t>(module.get_text().data());
-    }
-    else if (
-      header->entry <
-      module.get_text().size_bytes() + module.get_init().size_bytes())
-    {
-      base_address = reinterpret_cast<std::size_t>(module.get_init().data());
-    }
-    else if (
-      header->entry < module.get_text().size_bytes() +
-                        module.get_init().size_bytes() +
-                        module.get_data().size_bytes())
-    {
-      base_address = reinterpret_cast<std::size_t>(module.get_data().data());
-    }
-    else
+    // hashed when environment or cache is set
+    const auto environment_fingerprint = environment_->fingerprint();
+    if (!environment_fingerprint)
     {
-      base_address = reinterpret_cast<std::size_t>(module.get_bss().data());
+      return start_symbol_resolution(state);
     }
-
-    static_cast<Executable *>(&module)->set_entry(base_address + header->entry);
+    state.hash.add(*environment_fingerprint);
   }
 
+  // consumers add placement of dependency through tree fingerprint
+  state.tree_hash = Fingerprint{};
+  state.tree_hash
+    .add(reinterpret_cast<std::uintptr_t>(module.get_text().data()))
+    .add(reinterpret_cast<std::uintptr_t>(module.get_data().data()))
+    .add(module.get_content_fingerprint());
+  set_stage(state, LoadStage::PrelinkFingerprint);
   return true;
 }
 
-std::optional<Loader::ObservedExecutable> Loader::load_executable(
-  const void *module_address)
+bool Loader::process_prelink_fingerprint(LoadState &state, std::size_t &budget)
 {
-  ObservedExecutable executable;
-  if (!load_module(module_address, *executable))
+  Module     &module  = *state.module;
+  const auto &modules = module.get_modules();
+
+  // dependencies are loaded, so their trees are already hashed
+  for (; state.cursor < modules.size() && budget != 0;
+       ++state.cursor, --budget)
   {
-    return std::nullopt;
+    const uint32_t dependency = modules[state.cursor]->get_tree_fingerprint();
+    state.hash.add(dependency);
+    state.tree_hash.add(dependency);
   }
 
-  if (!executable->initialize_main())
+  if (state.cursor != modules.size())
   {
-    return std::nullopt;
+    return true;
   }
 
-  executables_.push_back(executable);
-  return executable;
+  module.set_tree_fingerprint(state.tree_hash.value());
+  state.fingerprint = state.hash.value();
+
+  const auto relocations = state.parser->get_symbol_table_relocations().span();
+  const auto imports =
+    prelink_cache_->find(state.module_address, *state.fingerprint);
+  if (imports && imports->size() == relocations.size())
+  {
+    log("Using prelinked imports, fingerprint: 0x%x\n", *state.fingerprint);
+    state.prelinked_imports = *imports;
+    set_stage(state, LoadStage::PrelinkedImports);
+    return true;
+  }
+  return start_symbol_resolution(state);
 }
 
-std::optional<Loader::ObservedLibrary> Loader::load_library(
-  const void *module_address)
+void Loader::process_prelinked_imports(LoadState &state, std::size_t &budget)
 {
-  ObservedLibrary library;
-  if (!load_module(module_address, *library))
+  const auto relocations = state.parser->get_symbol_table_relocations().span();
+
+  for (; state.cursor < relocations.size() && budget != 0;
+       ++state.cursor, --budget)
   {
-    return std::nullopt;
+    state.module->get_lot()[relocations[state.cursor].lot_index()] =
+      state.prelinked_imports[state.cursor];
   }
 
-  libraries_.push_back(library);
-  return library;
+  if (state.cursor == relocations.size())
+  {
+    set_stage(state, LoadStage::LocalRelocations);
+  }
 }
 
-const Header *Loader::process_header(const void *module_address) const
+bool Loader::start_symbol_resolution(LoadState &state)
 {
-  const Header *header = static_cast<const Header *>(module_address);
-  if (std::string_view(header->cookie, 4) != "YAFF")
+  const auto relocations = state.parser->get_symbol_table_relocations().span();
+
+  state.lazy =
+    lazy_binding_ && state.header->has(Header::Flag::ImportedFunctions);
+  state.symbols.emplace(state.parser->get_imported_symbol_table());
+
+  // thunks are valid only for this instance, so LOT can't be reused
+  if (state.fingerprint && !state.lazy)
   {
-    log("It is not YASIFF file, aborting...\n");
-    return nullptr;
+    state.resolved_imports.resize(relocations.size());
+    if (state.resolved_imports.size() != relocations.size())
+    {
+      log("Prelink buffer allocation failure\n");
+      state.fingerprint.reset();
+    }
   }
-  return header;
+
+  set_stage(
+    state,
+    state.lazy ? LoadStage::LazyBindings : LoadStage::SymbolRelocations);
+  return true;
 }
 
-bool Loader::process_data(
-  const Header &header,
-  const Parser &parser,
-  Module       &module)
+bool Loader::count_lazy_bindings(LoadState &state, std::size_t &budget)
 {
-  const auto data_initializer = parser.get_data();
+  const auto relocations = state.parser->get_symbol_table_relocations().span();
 
-  if (!module.allocate_data(header.data_length, header.bss_length))
+  for (; state.cursor < relocations.size() && budget != 0;
+       ++state.cursor, --budget)
   {
-    log("Data allocation failure\n");
-    return false;
+    const Symbol &symbol =
+      state.symbols->seek(relocations[state.cursor].symbol_index());
+    state.lazy_bindings += is_function(symbol) ? 1 : 0;
   }
 
-  log(
-    "Copying data from: %p, to: %p, size: 0x%x\n",
-    data_initializer.data(),
-    module.get_data().data(),
-    header.data_length + header.bss_length);
-
-  std::memcpy(
-    module.get_data().data(), data_initializer.data(), header.data_length);
+  if (state.cursor != relocations.size())
+  {
+    return true;
+  }
 
-  log(
-    "Initializing .bss at: %p, size: 0x%x\n",
-    module.get_bss().data(),
-    module.get_bss().size_bytes());
-  std::fill(module.get_bss().begin(), module.get_bss().end(), std::byte(0));
+  log("Allocation of lazy bindings: %d\n", state.lazy_bindings);
+  if (!state.module->allocate_lazy_bindings(state.lazy_bindings))
+  {
+    log("Lazy bindings allocation failure\n");
+    return false;
+  }
+  state.lazy_bindings = 0;
+  set_stage(state, LoadStage::SymbolRelocations);
   return true;
 }
 
 bool Loader::process_symbol_table_relocations(
-  const Parser &parser,
-  Module       &module)
+  LoadState   &state,
+  std::size_t &budget)
 {
-  const auto relocations = parser.get_symbol_table_relocations().span();
-  log("Processing symbol table relocations: %d\n", relocations.size());
-  const auto symbols = parser.get_imported_symbol_table();
-  for (const auto &rel : relocations)
+  const auto relocations = state.parser->get_symbol_table_relocations().span();
+  Module    &module      = *state.module;
+
+  for (; state.cursor < relocations.size() && budget != 0;
+       ++state.cursor, --budget)
   {
-    const auto &symbol  = symbols[rel.symbol_index()];
-    const auto  address = find_symbol(module, symbol.name());
+    const auto   &rel    = relocations[state.cursor];
+    const Symbol &symbol = state.symbols->seek(rel.symbol_index());
+    if (state.lazy && is_function(symbol))
+    {
+      log(
+        "LOT[%d]: lazy binding of %s\n",
+        rel.lot_index(),
+        symbol.name().data());
+      module.get_lot()[rel.lot_index()] = initialize_lazy_binding(
+        module.get_lazy_bindings()[state.lazy_bindings++],
+        module.get_lot().data(),
+        symbol,
+        rel.lot_index());
+      continue;
+    }
+
+    const auto address = find_symbol(module, symbol.name());
     if (!address)
     {
       log("Can't find symbol: %s\n", symbol.name().data());
@@ -275,19 +1305,42 @@ bool Loader::process_symbol_table_relocations(
     }
     log("LOT[%d]: 0x%x\n", rel.lot_index(), *address);
     module.get_lot()[rel.lot_index()] = *address;
+    if (state.fingerprint && !state.lazy)
+    {
+      state.resolved_imports[state.cursor] = *address;
+    }
+  }
+
+  if (state.cursor != relocations.size())
+  {
+    return true;
   }
 
+  if (state.fingerprint && !state.lazy)
+  {
+    log("Storing prelinked imports, fingerprint: 0x%x\n", *state.fingerprint);
+    prelink_cache_->store(
+      state.module_address, *state.fingerprint, state.resolved_imports);
+  }
+  set_stage(state, LoadStage::LocalRelocations);
   return true;
 }
 
-void Loader::process_local_relocations(const Parser &parser, Module &module)
+void Loader::process_local_relocations(LoadState &state, std::size_t &budget)
 {
-  const auto relocations = parser.get_local_relocations().span();
+  const auto relocations = state.parser->get_local_relocations().span();
+  Module    &module      = *state.module;
+
+  if (state.cursor == 0)
+  {
+    log("Processing local relocations: %d\n", relocations.size());
+  }
 
-  log("Processing local relocations: %d\n", relocations.size());
-  for (const auto &rel : relocations)
+  for (; state.cursor < relocations.size() && budget != 0;
+       ++state.cursor, --budget)
   {
-    std::size_t relocated_start_address =
+    const auto       &rel = relocations[state.cursor];
+    const std::size_t relocated_start_address =
       get_base_address(rel.section(), module);
     const std::size_t relocated = relocated_start_address + rel.offset();
     log(
@@ -298,33 +1351,27 @@ void Loader::process_local_relocations(const Parser &parser, Module &module)
       to_string(rel.section()).data());
     module.get_lot()[rel.lot_index()] = relocated;
   }
-}
 
-std::size_t Loader::get_base_address(Section section, Module &module)
-{
-  switch (section)
+  if (state.cursor == relocations.size())
   {
-  case Section::code:
-    return reinterpret_cast<std::size_t>(module.get_text().data());
-  case Section::data:
-    return reinterpret_cast<std::size_t>(module.get_data().data());
-  case Section::init:
-    return reinterpret_cast<std::size_t>(module.get_init().data());
-  case Section::unknown:
-    // report error
-    return 0;
+    set_stage(state, LoadStage::DataRelocations);
   }
-  // report error
-  return 0;
 }
 
-void Loader::process_data_relocations(const Parser &parser, Module &module)
+void Loader::process_data_relocations(LoadState &state, std::size_t &budget)
 {
-  const auto relocations = parser.get_data_relocations().span();
+  const auto relocations = state.parser->get_data_relocations().span();
+  Module    &module      = *state.module;
 
-  log("Processing data relocations: %d\n", relocations.size());
-  for (const auto &rel : relocations)
+  if (state.cursor == 0)
   {
+    log("Processing data relocations: %d\n", relocations.size());
+  }
+
+  for (; state.cursor < relocations.size() && budget != 0;
+       ++state.cursor, --budget)
+  {
+    const auto       &rel = relocations[state.cursor];
     const std::size_t address_to_change =
       reinterpret_cast<std::size_t>(module.get_data().data()) + rel.to();
     std::size_t *target = reinterpret_cast<std::size_t *>(address_to_change);
@@ -342,6 +1389,87 @@ void Loader::process_data_relocations(const Parser &parser, Module &module)
 
     *target = address_from;
   }
+
+  if (state.cursor == relocations.size())
+  {
+    set_stage(state, LoadStage::Entry);
+  }
+}
+
+void Loader::process_entry(LoadState &state)
+{
+  const Header &header = *state.header;
+  Module       &module = *state.module;
+  set_stage(state, LoadStage::Done);
+
+  if (header.entry == 0xffffffff || header.type != Header::Type::Executable)
+  {
+    return;
+  }
+
+  std::size_t base_address = 0;
+  if (header.entry < module.get_text().size_bytes())
+  {
+    base_address = reinterpret_cast<std::size_t>(module.get_text().data());
+  }
+  else if (
+    header.entry <
+    module.get_text().size_bytes() + module.get_init().size_bytes())
+  {
+    base_address = reinterpret_cast<std::size_t>(module.get_init().data());
+  }
+  else if (
+    header.entry < module.get_text().size_bytes() +
+                     module.get_init().size_bytes() +
+                     module.get_data().size_bytes())
+  {
+    base_address = reinterpret_cast<std::size_t>(module.get_data().data());
+  }
+  else
+  {
+    base_address = reinterpret_cast<std::size_t>(module.get_bss().data());
+  }
+
+  static_cast<Executable *>(&module)->set_entry(base_address + header.entry);
+}
+
+std::optional<std::size_t> Loader::resolve_lazy_binding(LazyBinding &binding)
+{
+  Module *module =
+    find_module_with_lot(reinterpret_cast<std::size_t>(binding.lot));
+  if (module == nullptr)
+  {
+    log("Can't find module with LOT: %p\n", binding.lot);
+    return std::nullopt;
+  }
+
+  const auto address = find_symbol(*module, binding.symbol->name());
+  if (!address)
+  {
+    log("Can't find symbol: %s\n", binding.symbol->name().data());
+    return std::nullopt;
+  }
+  log("LOT[%d]: 0x%x bound lazily\n", binding.lot_index, *address);
+  binding.lot[binding.lot_index] = *address;
+  return address;
+}
+
+std::size_t Loader::get_base_address(Section section, Module &module)
+{
+  switch (section)
+  {
+  case Section::code:
+    return reinterpret_cast<std::size_t>(module.get_text().data());
+  case Section::data:
+    return reinterpret_cast<std::size_t>(module.get_data().data());
+  case Section::init:
+    return reinterpret_cast<std::size_t>(module.get_init().data());
+  case Section::unknown:
+    // report error
+    return 0;
+  }
+  // report error
+  return 0;
 }
 
 std::optional<std::size_t> Loader::find_symbol(
@@ -356,7 +1484,7 @@ std::optional<std::size_t> Loader::find_symbol(
     const auto symbol = environment_->find_symbol(name);
     if (symbol)
     {
-      return symbol->address;
+      return reinterpret_cast<std::size_t>(symbol->address);
     }
   }
 
@@ -372,80 +1500,176 @@ std::optional<std::size_t> Loader::find_symbol(
 
 Module *Loader::find_active_module(std::size_t program_counter)
 {
-  for (auto &e : executables_)
+  for (const auto &range : index_.find(program_counter))
   {
-    auto ptr = e->find_active_module_for_program_counter(program_counter);
-    if (ptr)
+    if (active_call_contexts_->contains(*range.module))
     {
-      return *ptr;
+      return range.module;
     }
   }
+  return nullptr;
+}
 
-  for (auto &l : libraries_)
+CallContextStack &Loader::get_call_context_stack()
+{
+  return *active_call_contexts_;
+}
+
+void Loader::set_call_context_stack(CallContextStack &stack)
+{
+  running_task_.reset();
+  active_call_contexts_ = &stack;
+}
+
+std::optional<std::size_t> Loader::enter_module(
+  std::size_t               program_counter,
+  std::size_t               caller_lot,
+  const ForeignCallContext &context)
+{
+  Module *module = find_module_for_pc_and_lot(program_counter, caller_lot);
+  if (module == nullptr)
   {
-    auto ptr = l->find_active_module_for_program_counter(program_counter);
-    if (ptr)
-    {
-      return *ptr;
-    }
+    log("Can't find module at 0x%x\n", program_counter);
+    return std::nullopt;
   }
 
-  return nullptr;
+  // Entries are pushed for each call, so nested calls into the same module
+  // restore callers in reverse order
+  if (!active_call_contexts_->push(*module, context))
+  {
+    return std::nullopt;
+  }
+  return reinterpret_cast<std::size_t>(module->get_lot().data());
 }
 
-Module *Loader::find_module_with_lot(std::size_t lot_address)
+std::optional<ForeignCallContext> Loader::exit_module()
 {
-  for (auto &e : executables_)
+  // Exit always belongs to most recent entry of running task, module is
+  // taken from stack instead of searching it by program counter
+  const auto entry = active_call_contexts_->pop();
+  if (!entry)
   {
-    auto ptr = e->find_module_with_lot(lot_address);
-    if (ptr)
-    {
-      return *ptr;
-    }
+    log("Exit from module without saved caller, system state is unknown\n");
+    return std::nullopt;
   }
-  for (auto &l : libraries_)
+  return entry->context;
+}
+
+bool Loader::add_task(TaskId task_id)
+{
+  if (find_task(task_id) != nullptr)
   {
-    auto ptr = l->find_module_with_lot(lot_address);
-    if (ptr)
-    {
-      return *ptr;
-    }
+    return true;
   }
-  return nullptr;
+
+  tasks_.reserve(tasks_.size() + 1);
+  if (tasks_.capacity() < tasks_.size() + 1)
+  {
+    log("Task allocation failure\n");
+    return false;
+  }
+  CallContextStack call_contexts(call_context_depth);
+  if (!call_contexts.allocate())
+  {
+    return false;
+  }
+  const auto it =
+    std::lower_bound(tasks_.begin(), tasks_.end(), task_id, is_task_before);
+  tasks_.insert(
+    it,
+    Task{ .id = task_id, .call_contexts = std::move(call_contexts) });
+  if (running_task_)
+  {
+    on_task_switch(*running_task_);
+  }
+  return true;
+}
+
+void Loader::remove_task(TaskId task_id)
+{
+  Task *task = find_task(task_id);
+  if (task == nullptr)
+  {
+    return;
+  }
+  task->call_contexts.clear();
+  tasks_.erase(tasks_.begin() + (task - tasks_.data()));
+  if (running_task_)
+  {
+    on_task_switch(*running_task_);
+  }
+}
+
+bool Loader::on_task_switch(TaskId task_id)
+{
+  running_task_ = task_id;
+  Task *task    = find_task(task_id);
+  if (task == nullptr)
+  {
+    active_call_contexts_ = &call_contexts_;
+    return false;
+  }
+  active_call_contexts_ = &task->call_contexts;
+  return true;
+}
+
+Loader::Task *Loader::find_task(TaskId task_id)
+{
+  const auto it =
+    std::lower_bound(tasks_.begin(), tasks_.end(), task_id, is_task_before);
+  if (it == tasks_.end() || it->id != task_id)
+  {
+    return nullptr;
+  }
+  return &*it;
+}
+
+Module *Loader::find_module_with_lot(std::size_t lot_address)
+{
+  return index_.find_with_lot(lot_address);
 }
 
 Module *Loader::find_module_for_pc_and_lot(
   std::size_t program_counter,
   std::size_t lot_address)
 {
+  const auto ranges = index_.find(program_counter);
+  if (ranges.size() <= 1)
+  {
+    return ranges.empty() ? nullptr : ranges.front().module;
+  }
+
+  // text shared by modules loaded from same image, caller decides which one
   Module *parent = find_module_with_lot(lot_address);
-  // if has no parent it was called from runtime system
-  if (parent == nullptr)
+  for (const auto &range : ranges)
   {
-    for (auto &module : executables_)
+    // if has no parent it was called from runtime system
+    if (parent == nullptr ? is_top_level_module(range.module)
+                          : parent->has_module(*range.module))
     {
-      if (module->is_module_for_program_counter(program_counter))
-      {
-        return &(*module);
-      }
+      return range.module;
     }
-    for (auto &module : libraries_)
+  }
+  return nullptr;
+}
+
+bool Loader::is_top_level_module(const Module *module)
+{
+  for (auto &executable : executables_)
+  {
+    if (&(*executable) == module)
     {
-      if (module->is_module_for_program_counter(program_counter))
-      {
-        return &(*module);
-      }
+      return true;
     }
-    return nullptr;
   }
-
-  auto module = parent->find_module_for_program_counter(program_counter);
-  if (module)
+  for (auto &library : libraries_)
   {
-    return *module;
+    if (&(*library) == module)
+    {
+      return true;
+    }
   }
-
-  return nullptr;
+  return false;
 }
 
 void Loader::register_file_resolver(const FileResolverType &resolver)
@@ -453,4 +1677,9 @@ void Loader::register_file_resolver(const FileResolverType &resolver)
   file_resolver_ = resolver;
 }
 
+void Loader::register_source_resolver(const SourceResolverType &resolver)
+{
+  source_resolver_ = resolver;
+}
+
 } // namespace yasld
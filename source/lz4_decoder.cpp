@@ -0,0 +1,163 @@
+/**
+ * lz4_decoder.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/lz4_decoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace yasld
+{
+
+namespace
+{
+
+constexpr uint8_t     length_mask      = 0x0f;
+constexpr uint8_t     length_extension = 0xff;
+constexpr std::size_t min_match        = 4;
+
+} // namespace
+
+Lz4Decoder::Lz4Decoder(std::span<std::byte> output)
+  : output_{ output }
+  , written_{ 0 }
+  , length_{ 0 }
+  , offset_{ 0 }
+  , token_{ 0 }
+  , state_{ State::Token }
+{
+}
+
+bool Lz4Decoder::decode(std::span<const std::byte> input)
+{
+  std::size_t position = 0;
+  while (position < input.size())
+  {
+    switch (state_)
+    {
+    case State::Token:
+    {
+      token_  = static_cast<uint8_t>(input[position++]);
+      length_ = token_ >> 4;
+      if (length_ == length_mask)
+      {
+        state_ = State::LiteralLength;
+      }
+      else
+      {
+        state_ = length_ == 0 ? State::OffsetLow : State::Literals;
+      }
+      break;
+    }
+    case State::LiteralLength:
+    {
+      const auto byte = static_cast<uint8_t>(input[position++]);
+      length_ += byte;
+      if (byte != length_extension)
+      {
+        state_ = State::Literals;
+      }
+      break;
+    }
+    case State::Literals:
+    {
+      const std::size_t size = std::min(length_, input.size() - position);
+      if (size > output_.size() - written_)
+      {
+        return false;
+      }
+      std::memcpy(output_.data() + written_, input.data() + position, size);
+      written_ += size;
+      position += size;
+      length_ -= size;
+      if (length_ == 0)
+      {
+        state_ = State::OffsetLow;
+      }
+      break;
+    }
+    case State::OffsetLow:
+    {
+      offset_ = static_cast<uint8_t>(input[position++]);
+      state_  = State::OffsetHigh;
+      break;
+    }
+    case State::OffsetHigh:
+    {
+      offset_ |= static_cast<std::size_t>(input[position++]) << 8;
+      length_ = (token_ & length_mask) + min_match;
+      if ((token_ & length_mask) == length_mask)
+      {
+        state_ = State::MatchLength;
+      }
+      else if (!copy_match())
+      {
+        return false;
+      }
+      break;
+    }
+    case State::MatchLength:
+    {
+      const auto byte = static_cast<uint8_t>(input[position++]);
+      length_ += byte;
+      if (byte != length_extension && !copy_match())
+      {
+        return false;
+      }
+      break;
+    }
+    }
+  }
+  return true;
+}
+
+bool Lz4Decoder::finished() const
+{
+  // last sequence contains only literals
+  return written_ == output_.size() && state_ == State::OffsetLow;
+}
+
+std::size_t Lz4Decoder::written() const
+{
+  return written_;
+}
+
+bool Lz4Decoder::copy_match()
+{
+  if (
+    offset_ == 0 || offset_ > written_ ||
+    length_ > output_.size() - written_)
+  {
+    return false;
+  }
+
+  // match may overlap with bytes written by itself, so it is copied forward
+  std::byte *destination = output_.data() + written_;
+  std::byte *source      = destination - offset_;
+  for (std::size_t i = 0; i < length_; ++i)
+  {
+    destination[i] = source[i];
+  }
+  written_ += length_;
+  state_ = State::Token;
+  return true;
+}
+
+} // namespace yasld
@@ -0,0 +1,100 @@
+/**
+ * memory_usage.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/memory_usage.hpp"
+
+#include <algorithm>
+
+#include "yasld/allocator.hpp"
+
+namespace yasld
+{
+
+static_assert(
+  static_cast<std::size_t>(AllocationType::Arena) + 1 ==
+    MemoryUsage::number_of_types,
+  "Each AllocationType must have statistics");
+
+MemoryUsage::MemoryUsage()
+  : statistics_{}
+  , bytes_{ 0 }
+  , allocations_{ 0 }
+  , peak_bytes_{ 0 }
+{
+}
+
+void MemoryUsage::add(AllocationType type, std::size_t size)
+{
+  auto &statistics = statistics_[static_cast<std::size_t>(type)];
+  statistics.bytes += size;
+  ++statistics.allocations;
+  bytes_ += size;
+  ++allocations_;
+  peak_bytes_ = std::max(peak_bytes_, bytes_);
+}
+
+void MemoryUsage::remove(AllocationType type, std::size_t size)
+{
+  auto &statistics = statistics_[static_cast<std::size_t>(type)];
+  statistics.bytes -= size;
+  --statistics.allocations;
+  bytes_ -= size;
+  --allocations_;
+}
+
+MemoryUsage &MemoryUsage::operator+=(const MemoryUsage &other)
+{
+  for (std::size_t i = 0; i < statistics_.size(); ++i)
+  {
+    statistics_[i].bytes += other.statistics_[i].bytes;
+    statistics_[i].allocations += other.statistics_[i].allocations;
+  }
+  bytes_ += other.bytes_;
+  allocations_ += other.allocations_;
+  peak_bytes_ = std::max(peak_bytes_, bytes_);
+  return *this;
+}
+
+const AllocationStatistics &MemoryUsage::get(AllocationType type) const
+{
+  return statistics_[static_cast<std::size_t>(type)];
+}
+
+std::size_t MemoryUsage::bytes() const
+{
+  return bytes_;
+}
+
+std::size_t MemoryUsage::allocations() const
+{
+  return allocations_;
+}
+
+std::size_t MemoryUsage::peak_bytes() const
+{
+  return peak_bytes_;
+}
+
+void MemoryUsage::reset_peak()
+{
+  peak_bytes_ = bytes_;
+}
+
+} // namespace yasld
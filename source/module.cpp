@@ -20,22 +20,103 @@
 
 #include "yasld/module.hpp"
 
+#include <algorithm>
+
+#include "yasld/header.hpp"
 #include "yasld/logger.hpp"
 #include "yasld/symbol.hpp"
 
+extern "C"
+{
+  int call_entry(std::size_t address, const void *lot);
+} // extern "C"
+
 namespace yasld
 {
 
+namespace
+{
+
+template <typename Container>
+void add_allocation(
+  MemoryUsage     &usage,
+  AllocationType   type,
+  const Container &container)
+{
+  if (container.capacity() == 0)
+  {
+    return;
+  }
+  if constexpr (requires { container.get_allocator().contains(nullptr); })
+  {
+    // region is part of arena or memory region outside of loader
+    if (container.get_allocator().contains(container.data()))
+    {
+      return;
+    }
+  }
+  usage.add(
+    type, container.capacity() * sizeof(typename Container::value_type));
+}
+
+} // namespace
+
 Module::Module()
-  : lot_{}
+  : arena_memory_{}
+  , arena_{}
+  , lot_{}
+  , lazy_bindings_{}
+  , text_region_{}
+  , text_memory_{}
+  , image_{}
   , text_{}
   , init_{}
+  , fini_amount_{ 0 }
   , data_{}
   , bss_{}
   , exported_symbols_{}
+  , exported_symbols_hash_{}
   , imported_modules_{}
-  , active_{ false }
+  , content_fingerprint_{ 0 }
+  , tree_fingerprint_{ 0 }
+  , index_{ nullptr }
+  , allocation_size_{ 0 }
+  , allocation_type_{ AllocationType::Module }
+  , active_calls_{ 0 }
+{
+}
+
+Module::Module(Module &&other)
+  : arena_memory_{ std::move(other.arena_memory_) }
+  , arena_{ other.arena_ }
+  , lot_{ std::move(other.lot_) }
+  , data_memory_{ std::move(other.data_memory_) }
+  , lazy_bindings_{ std::move(other.lazy_bindings_) }
+  , text_region_{ std::move(other.text_region_) }
+  , text_memory_{ std::move(other.text_memory_) }
+  , image_{ std::move(other.image_) }
+  , text_{ other.text_ }
+  , init_{ std::move(other.init_) }
+  , fini_amount_{ other.fini_amount_ }
+  , data_{ other.data_ }
+  , bss_{ other.bss_ }
+  , exported_symbols_{ std::move(other.exported_symbols_) }
+  , exported_symbols_hash_{ std::move(other.exported_symbols_hash_) }
+  , imported_modules_{ std::move(other.imported_modules_) }
+  , name_{ other.name_ }
+  , content_fingerprint_{ other.content_fingerprint_ }
+  , tree_fingerprint_{ other.tree_fingerprint_ }
+  , index_{ other.index_ }
+  , allocation_size_{ other.allocation_size_ }
+  , allocation_type_{ other.allocation_type_ }
+  , active_calls_{ other.active_calls_ }
 {
+  other.index_           = nullptr;
+  other.allocation_size_ = 0;
+  if (index_ != nullptr)
+  {
+    index_->relocate(other, *this);
+  }
 }
 
 void Module::set_text(const std::span<const std::byte> &text)
@@ -48,11 +129,32 @@ void Module::set_exported_symbol_table(const SymbolTable &table)
   exported_symbols_ = table;
 }
 
+void Module::set_exported_symbol_hash_table(
+  const std::optional<SymbolHashTable> &table)
+{
+  exported_symbols_hash_ = table;
+}
+
 std::span<std::size_t> Module::get_lot()
 {
   return { lot_ };
 }
 
+std::span<LazyBinding> Module::get_lazy_bindings()
+{
+  return lazy_bindings_;
+}
+
+std::span<std::byte> Module::get_text_memory()
+{
+  return text_memory_;
+}
+
+std::span<std::byte> Module::get_image()
+{
+  return image_;
+}
+
 std::span<const std::byte> Module::get_text() const
 {
   return text_;
@@ -63,6 +165,16 @@ std::span<std::size_t> Module::get_init()
   return init_;
 }
 
+std::span<const std::size_t> Module::get_fini() const
+{
+  // moved from module has no init section
+  if (fini_amount_ > init_.size())
+  {
+    return {};
+  }
+  return std::span<const std::size_t>(init_).last(fini_amount_);
+}
+
 std::span<std::byte> Module::get_data()
 {
   return data_;
@@ -81,39 +193,59 @@ const std::optional<SymbolTable> &Module::get_exported_symbol_table() const
 std::optional<std::size_t> Module::find_symbol(
   const std::string_view &name) const
 {
-  for (const auto &symbol : *exported_symbols_)
+  return find_symbol(name, SymbolHashTable::hash(name));
+}
+
+std::optional<std::size_t> Module::find_symbol(
+  const std::string_view &name,
+  uint32_t                hash) const
+{
+  const Symbol *symbol = find_exported_symbol(name, hash);
+  if (symbol != nullptr)
   {
-    if (symbol.name() == name)
-    {
-      const std::size_t base_address =
-        symbol.section() == Section::code
-          ? reinterpret_cast<std::size_t>(text_.data())
-          : reinterpret_cast<std::size_t>(data_.data());
-      const std::size_t address = base_address + symbol.offset();
-      log("Found symbol '%s' at: 0x%lx\n", symbol.name().data(), address);
-      return address;
-    }
+    const std::size_t base_address =
+      symbol->section() == Section::code
+        ? reinterpret_cast<std::size_t>(text_.data())
+        : reinterpret_cast<std::size_t>(data_.data());
+    const std::size_t address = base_address + symbol->offset();
+    log("Found symbol '%s' at: 0x%lx\n", symbol->name().data(), address);
+    return address;
   }
 
   for (const auto &module : imported_modules_)
   {
-    auto symbol = module->find_symbol(name);
-    if (symbol)
+    auto address = module->find_symbol(name, hash);
+    if (address)
     {
-      return symbol;
+      return address;
     }
   }
   return std::nullopt;
 }
 
-void Module::save_caller_state(ForeignCallContext ctx)
+const Symbol *Module::find_exported_symbol(
+  const std::string_view &name,
+  uint32_t                hash) const
 {
-  foreign_call_context_ = ctx;
-}
+  if (exported_symbols_hash_)
+  {
+    return exported_symbols_hash_->find(name, hash);
+  }
 
-ForeignCallContext Module::restore_caller_state()
-{
-  return foreign_call_context_;
+  if (!exported_symbols_)
+  {
+    return nullptr;
+  }
+
+  // images without hash index falls back to linear search
+  for (const auto &symbol : *exported_symbols_)
+  {
+    if (symbol.name() == name)
+    {
+      return &symbol;
+    }
+  }
+  return nullptr;
 }
 
 std::span<const std::byte> Module::get_data() const
@@ -126,14 +258,108 @@ std::span<const std::byte> Module::get_bss() const
   return bss_;
 }
 
+std::size_t Module::get_arena_size(const Header &header)
+{
+  const std::size_t lot_size =
+    header.symbol_table_relocations_amount + header.local_relocations_amount;
+  const std::size_t init_size =
+    header.init_length / sizeof(std::size_t) * sizeof(std::size_t);
+  return align_arena(lot_size * sizeof(std::size_t)) +
+         align_arena(init_size) +
+         align_arena(header.data_length + header.bss_length) +
+         align_arena(
+           header.external_libraries_amount * sizeof(SharedModule));
+}
+
+bool Module::allocate_arena(std::size_t size)
+{
+  arena_memory_.resize(size);
+  arena_ = arena_memory_;
+  return size == arena_memory_.size();
+}
+
+void Module::set_arena(std::span<std::byte> arena)
+{
+  arena_ = arena;
+}
+
+void Module::set_allocation(std::size_t size, AllocationType type)
+{
+  allocation_size_ = size;
+  allocation_type_ = type;
+}
+
+void Module::destroy(Module *module)
+{
+  const std::size_t    size = module->allocation_size_;
+  const AllocationType type = module->allocation_type_;
+  module->~Module();
+  YasldAllocatorHolder::get().release(module, size, type);
+}
+
+std::span<std::byte> Module::take_arena(std::size_t size)
+{
+  const std::size_t aligned = align_arena(size);
+  if (aligned > arena_.size())
+  {
+    return {};
+  }
+  const auto region = arena_.first(size);
+  arena_            = arena_.subspan(aligned);
+  return region;
+}
+
 bool Module::allocate_lot(std::size_t lot_size)
 {
+  lot_ = LotContainer(LotContainer::allocator_type(
+    take_arena(lot_size * sizeof(std::size_t))));
   lot_.resize(lot_size);
   return lot_size == lot_.size();
 }
 
+bool Module::allocate_lazy_bindings(std::size_t size)
+{
+  lazy_bindings_.resize(size);
+  return size == lazy_bindings_.size();
+}
+
+bool Module::allocate_text(std::size_t size)
+{
+  text_memory_.resize(size);
+  text_ = text_memory_;
+  return size == text_memory_.size();
+}
+
+bool Module::allocate_text(std::size_t size, const MemoryRegion &region)
+{
+  if (!region.allocate)
+  {
+    return false;
+  }
+
+  text_region_ = std::unique_ptr<std::byte, RegionDeleter>(
+    static_cast<std::byte *>(region.allocate(size, AllocationType::Text)),
+    RegionDeleter(region.release));
+  if (text_region_ == nullptr)
+  {
+    return false;
+  }
+
+  text_memory_ =
+    TextContainer(TextContainer::allocator_type({ text_region_.get(), size }));
+  return allocate_text(size);
+}
+
+bool Module::allocate_image(std::size_t size)
+{
+  image_.resize(size);
+  return size == image_.size();
+}
+
 bool Module::allocate_data(std::size_t data_size, std::size_t bss_size)
 {
+  data_memory_ = DataContainer(
+    DataContainer::allocator_type(take_arena(data_size + bss_size)));
   data_memory_.resize(data_size + bss_size);
   if (data_memory_.size() != data_size + bss_size)
   {
@@ -149,14 +375,22 @@ bool Module::allocate_data(std::size_t data_size, std::size_t bss_size)
 
 bool Module::allocate_modules(std::size_t number_of_modules)
 {
+  imported_modules_ = ModulesContainer(ModulesContainer::allocator_type(
+    take_arena(number_of_modules * sizeof(SharedModule))));
   imported_modules_.reserve(number_of_modules);
   return imported_modules_.capacity() == number_of_modules;
 }
 
-bool Module::relocate_init(const std::span<const std::size_t> &init)
+bool Module::allocate_init(std::size_t size)
+{
+  init_ = InitContainer(
+    InitContainer::allocator_type(take_arena(size * sizeof(std::size_t))));
+  init_.resize(size);
+  return size == init_.size();
+}
+
+void Module::relocate_init(std::span<std::size_t> entries)
 {
-  init_.resize(init.size());
-  std::copy(init.begin(), init.end(), init_.begin());
   // init entries contains jumps to original addresses, let's relocate them
   log("Init relocated values:\n");
   std::size_t text_end = text_.size_bytes();
@@ -164,7 +398,7 @@ bool Module::relocate_init(const std::span<const std::size_t> &init)
   std::size_t data_end = data_.size_bytes();
   std::size_t bss_end  = data_.size_bytes();
 
-  for (auto &e : init_)
+  for (auto &e : entries)
   {
     log("  %x -> ", e);
     if (e < text_end)
@@ -185,10 +419,30 @@ bool Module::relocate_init(const std::span<const std::size_t> &init)
     }
     log("%x\n", e);
   }
+}
 
+bool Module::set_fini_amount(std::size_t amount)
+{
+  if (amount > init_.size())
+  {
+    log("Fini array exceeds init section: %d\n", amount);
+    return false;
+  }
+  fini_amount_ = amount;
   return true;
 }
 
+void Module::finalize()
+{
+  const auto fini = get_fini();
+  for (auto it = fini.rbegin(); it != fini.rend(); ++it)
+  {
+    log("Calling fini at: 0x%x\n", *it);
+    call_entry(*it, lot_.data());
+  }
+  fini_amount_ = 0;
+}
+
 Module::ModulesContainer &Module::get_modules()
 {
   return imported_modules_;
@@ -203,126 +457,120 @@ const std::string_view &Module::get_name() const
   return name_;
 }
 
-std::optional<Module *> Module::find_active_module_for_program_counter(
-  std::size_t program_counter)
+void Module::set_content_fingerprint(uint32_t fingerprint)
 {
-  return find_module_for_program_counter_impl(program_counter, true);
+  content_fingerprint_ = fingerprint;
 }
 
-std::optional<Module *> Module::find_module_for_program_counter(
-  std::size_t program_counter)
+uint32_t Module::get_content_fingerprint() const
 {
-  return find_module_for_program_counter_impl(program_counter, false);
+  return content_fingerprint_;
 }
 
-bool Module::is_module_for_program_counter(std::size_t program_counter)
+void Module::set_tree_fingerprint(uint32_t fingerprint)
 {
-  return is_module_for_program_counter_impl(program_counter, false);
+  tree_fingerprint_ = fingerprint;
 }
 
-bool Module::is_module_for_program_counter_impl(
-  std::size_t program_counter,
-  bool        only_active)
+uint32_t Module::get_tree_fingerprint() const
 {
-  // since circular dependency can't exists childs can be skipped if match
-  // occured
-  {
-    const std::size_t text_start = reinterpret_cast<std::size_t>(text_.data());
-    const std::size_t text_end   = text_start + text_.size();
-    if (program_counter >= text_start && program_counter < text_end)
-    {
-      if (active_ || !only_active)
-      {
-        return true;
-      }
-      else
-      {
-        return false;
-      }
-    }
-  }
-  {
-    const std::size_t data_start = reinterpret_cast<std::size_t>(data_.data());
-    const std::size_t data_end   = data_start + data_.size();
-    if (program_counter >= data_start && program_counter < data_end)
-    {
-      if (active_ || !only_active)
-      {
-        return true;
-      }
-      else
-      {
-        return false;
-      }
-    }
-  }
-  {
-    const std::size_t bss_start = reinterpret_cast<std::size_t>(bss_.data());
-    const std::size_t bss_end   = bss_start + bss_.size();
-    if (program_counter >= bss_start && program_counter < bss_end)
-    {
-      if (active_ || !only_active)
-      {
-        return true;
-      }
-      else
-      {
-        return false;
-      }
-    }
-  }
-  return false;
+  return tree_fingerprint_;
 }
 
-std::optional<Module *> Module::find_module_for_program_counter_impl(
-  std::size_t program_counter,
-  bool        only_active)
+bool Module::has_module(const Module &module) const
 {
-  // since circular dependency can't exists childs can be skipped if match
-  // occured
-  if (is_module_for_program_counter_impl(program_counter, only_active))
+  if (&module == this)
   {
-    return this;
+    return true;
   }
 
-  for (auto &module : imported_modules_)
-  {
-    auto m = module->find_module_for_program_counter_impl(
-      program_counter, only_active);
-    if (m)
+  return std::any_of(
+    imported_modules_.begin(),
+    imported_modules_.end(),
+    [&module](const SharedModule &dependency)
     {
-      return *m;
-    }
-  }
-  return std::nullopt;
+      return dependency->has_module(module);
+    });
 }
 
-std::optional<Module *> Module::find_module_with_lot(std::size_t lot_address)
+bool Module::get_active() const
 {
-  if (lot_address == reinterpret_cast<std::size_t>(lot_.data()))
+  return active_calls_ != 0;
+}
+
+void Module::enter()
+{
+  ++active_calls_;
+}
+
+void Module::leave()
+{
+  if (active_calls_ != 0)
   {
-    return this;
+    --active_calls_;
   }
+}
+
+void Module::set_index(ModuleIndex *index)
+{
+  index_ = index;
+}
 
-  for (auto &module : imported_modules_)
+template <typename Visitor>
+void Module::visit_tree(Visitor &visitor) const
+{
+  visitor(*this);
+  for (const auto &module : imported_modules_)
   {
-    auto m = module->find_module_with_lot(lot_address);
-    if (m)
-    {
-      return *m;
-    }
+    module->visit_tree(visitor);
   }
-  return std::nullopt;
 }
 
-bool Module::get_active() const
+MemoryUsage Module::get_memory_usage() const
 {
-  return active_;
+  MemoryUsage usage;
+  if (allocation_size_ != 0)
+  {
+    usage.add(allocation_type_, allocation_size_);
+  }
+  add_allocation(usage, AllocationType::Arena, arena_memory_);
+  add_allocation(usage, AllocationType::OffsetTable, lot_);
+  add_allocation(usage, AllocationType::Data, data_memory_);
+  add_allocation(usage, AllocationType::LazyBinding, lazy_bindings_);
+  add_allocation(usage, AllocationType::Text, text_memory_);
+  add_allocation(usage, AllocationType::Image, image_);
+  add_allocation(usage, AllocationType::Init, init_);
+  add_allocation(usage, AllocationType::Module, imported_modules_);
+  return usage;
 }
 
-void Module::set_active(bool active)
+MemoryUsage Module::get_total_memory_usage() const
 {
-  active_ = active;
+  // dependency trees are small, so first occurrence of module is searched
+  // instead of keeping set of visited modules
+  MemoryUsage usage;
+  std::size_t position = 0;
+  auto        count    = [this, &usage, &position](const Module &module)
+  {
+    std::size_t first = 0;
+    std::size_t index = 0;
+    auto        find  = [&module, &first, &index](const Module &candidate)
+    {
+      if (&candidate == &module && first == 0)
+      {
+        first = index + 1;
+      }
+      ++index;
+    };
+    visit_tree(find);
+    if (first == position + 1)
+    {
+      usage += module.get_memory_usage();
+    }
+    ++position;
+  };
+  visit_tree(count);
+  return usage;
 }
 
 } // namespace yasld
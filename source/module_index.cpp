@@ -0,0 +1,172 @@
+/**
+ * module_index.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/module_index.hpp"
+
+#include <algorithm>
+
+#include "yasld/logger.hpp"
+#include "yasld/module.hpp"
+
+namespace yasld
+{
+
+namespace
+{
+
+bool is_range_before(const ModuleIndex::Range &range, std::size_t address)
+{
+  return range.start < address;
+}
+
+constexpr auto is_lot_before = [](const auto &lot, std::size_t address)
+{
+  return lot.address < address;
+};
+
+} // namespace
+
+bool ModuleIndex::insert(Module &module)
+{
+  const auto  text = reinterpret_cast<std::size_t>(module.get_text().data());
+  const auto  data = reinterpret_cast<std::size_t>(module.get_data().data());
+  const auto  bss  = reinterpret_cast<std::size_t>(module.get_bss().data());
+  const Range ranges[] = {
+    { text, text + module.get_text().size(), &module },
+    { data, data + module.get_data().size(), &module },
+    { bss, bss + module.get_bss().size(), &module },
+  };
+
+  const Lot lot = { reinterpret_cast<std::size_t>(module.get_lot().data()),
+                    &module };
+
+  // inserts below can't fail when memory is reserved
+  ranges_.reserve(ranges_.size() + std::size(ranges));
+  lots_.reserve(lots_.size() + 1);
+  if (
+    ranges_.capacity() < ranges_.size() + std::size(ranges) ||
+    lots_.capacity() < lots_.size() + 1)
+  {
+    log("Module index allocation failure\n");
+    return false;
+  }
+
+  for (const auto &range : ranges)
+  {
+    if (range.start == range.end)
+    {
+      continue;
+    }
+    ranges_.insert(
+      std::lower_bound(
+        ranges_.begin(), ranges_.end(), range.start, is_range_before),
+      range);
+  }
+
+  // module without imports and local relocations has no LOT
+  if (lot.address != 0)
+  {
+    lots_.insert(
+      std::lower_bound(lots_.begin(), lots_.end(), lot.address, is_lot_before),
+      lot);
+  }
+  module.set_index(this);
+  return true;
+}
+
+void ModuleIndex::remove(const Module &module)
+{
+  std::erase_if(
+    ranges_,
+    [&module](const Range &range)
+    {
+      return range.module == &module;
+    });
+  std::erase_if(
+    lots_,
+    [&module](const Lot &lot)
+    {
+      return lot.module == &module;
+    });
+}
+
+void ModuleIndex::relocate(const Module &from, Module &to)
+{
+  for (auto &range : ranges_)
+  {
+    if (range.module == &from)
+    {
+      range.module = &to;
+    }
+  }
+  for (auto &lot : lots_)
+  {
+    if (lot.module == &from)
+    {
+      lot.module = &to;
+    }
+  }
+}
+
+std::span<const ModuleIndex::Range> ModuleIndex::find(
+  std::size_t program_counter) const
+{
+  auto last = std::upper_bound(
+    ranges_.begin(),
+    ranges_.end(),
+    program_counter,
+    [](std::size_t address, const Range &range)
+    {
+      return address < range.start;
+    });
+
+  if (last == ranges_.begin() || program_counter >= std::prev(last)->end)
+  {
+    return {};
+  }
+
+  // equal ranges are neighbours
+  const std::size_t start = std::prev(last)->start;
+  auto              first = std::prev(last);
+  while (first != ranges_.begin() && std::prev(first)->start == start)
+  {
+    --first;
+  }
+  return { first, last };
+}
+
+Module *ModuleIndex::find_with_lot(std::size_t lot_address) const
+{
+  const auto lot =
+    std::lower_bound(lots_.begin(), lots_.end(), lot_address, is_lot_before);
+
+  if (lot == lots_.end() || lot->address != lot_address)
+  {
+    return nullptr;
+  }
+  return lot->module;
+}
+
+std::size_t ModuleIndex::size() const
+{
+  return ranges_.size();
+}
+
+} // namespace yasld
@@ -0,0 +1,128 @@
+/**
+ * module_registry.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/module_registry.hpp"
+
+#include <algorithm>
+
+#include "yasld/logger.hpp"
+#include "yasld/module.hpp"
+
+namespace yasld
+{
+
+SharedModuleReleaser::SharedModuleReleaser()
+  : registry_{ nullptr }
+{
+}
+
+SharedModuleReleaser::SharedModuleReleaser(ModuleRegistry *registry)
+  : registry_{ registry }
+{
+}
+
+void SharedModuleReleaser::operator()(Module *module) const
+{
+  if (registry_ != nullptr)
+  {
+    registry_->release(module);
+  }
+}
+
+SharedModule ModuleRegistry::find(const void *image_address)
+{
+  for (auto &entry : entries_)
+  {
+    if (entry.image_address == image_address)
+    {
+      ++entry.references;
+      log(
+        "Module '%s' already loaded, references: %d\n",
+        entry.module->get_name().data(),
+        entry.references);
+      return SharedModule(entry.module, SharedModuleReleaser(this));
+    }
+  }
+  return SharedModule(nullptr, SharedModuleReleaser(this));
+}
+
+SharedModule ModuleRegistry::insert(const void *image_address, Module *module)
+{
+  entries_.reserve(entries_.size() + 1);
+  if (entries_.capacity() < entries_.size() + 1 || entries_.data() == nullptr)
+  {
+    log("Module registry allocation failure\n");
+    return SharedModule(nullptr, SharedModuleReleaser(this));
+  }
+  entries_.push_back(Entry{
+    .image_address = image_address,
+    .module        = module,
+    .references    = 1,
+  });
+  return SharedModule(module, SharedModuleReleaser(this));
+}
+
+std::size_t ModuleRegistry::get_reference_count(const Module *module) const
+{
+  for (const auto &entry : entries_)
+  {
+    if (entry.module == module)
+    {
+      return entry.references;
+    }
+  }
+  return 0;
+}
+
+std::size_t ModuleRegistry::size() const
+{
+  return entries_.size();
+}
+
+void ModuleRegistry::release(Module *module)
+{
+  auto entry = std::find_if(
+    entries_.begin(),
+    entries_.end(),
+    [module](const Entry &e)
+    {
+      return e.module == module;
+    });
+
+  if (entry == entries_.end())
+  {
+    return;
+  }
+
+  if (--entry->references != 0)
+  {
+    return;
+  }
+
+  // name points to header of module, which is still alive
+  log("Releasing module '%s'\n", module->get_name().data());
+  // entry must be removed before destruction, module releases own
+  // dependencies which modifies registry
+  entries_.erase(entry);
+  module->finalize();
+  Module::destroy(module);
+}
+
+} // namespace yasld
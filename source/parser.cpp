@@ -20,6 +20,8 @@
 
 #include "yasld/parser.hpp"
 
+#include <cstring>
+
 #include "yasld/align.hpp"
 #include "yasld/header.hpp"
 #include "yasld/logger.hpp"
@@ -27,39 +29,138 @@
 namespace yasld
 {
 
+namespace
+{
+
+// Fills entry and returns address where next section starts
+std::uintptr_t set_entry(
+  SectionDirectory::Entry &entry,
+  std::uintptr_t           base,
+  std::uintptr_t           address,
+  std::size_t              size)
+{
+  entry.offset = static_cast<uint32_t>(address - base);
+  entry.size   = static_cast<uint32_t>(size);
+  return address + size;
+}
+
+// YASIFF v1 images have no section directory, each section starts where
+// previous one ends, so directory is rebuilt by walking all tables
+SectionDirectory build_section_directory(const Header *header)
+{
+  SectionDirectory     directory{};
+  const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(header);
+
+  std::uintptr_t         address = base + sizeof(Header);
+  const std::string_view name(reinterpret_cast<const char *>(address));
+  set_entry(directory.name, base, address, name.size() + 1);
+
+  // v1 images are aligned from the end of name without terminator
+  address = align<std::uintptr_t>(address + name.size(), header->alignment);
+  address = set_entry(
+    directory.imported_libraries,
+    base,
+    address,
+    DependencyList(
+      address, header->external_libraries_amount, header->alignment)
+      .size());
+  address = set_entry(
+    directory.symbol_table_relocations,
+    base,
+    address,
+    header->symbol_table_relocations_amount * sizeof(Relocation));
+  address = set_entry(
+    directory.local_relocations,
+    base,
+    address,
+    header->local_relocations_amount * sizeof(LocalRelocation));
+  address = set_entry(
+    directory.data_relocations,
+    base,
+    address,
+    header->data_relocations_amount * sizeof(DataRelocation));
+  address = set_entry(
+    directory.imported_symbols,
+    base,
+    address,
+    SymbolTable(address, header->imported_symbols_amount, header->alignment)
+      .size());
+  const std::uintptr_t exported_symbols_address = address;
+  address = set_entry(
+    directory.exported_symbols,
+    base,
+    address,
+    SymbolTable(address, header->exported_symbols_amount, header->alignment)
+      .size());
+
+  std::size_t hash_size = 0;
+  if (header->has(Header::Flag::ExportedSymbolsHash))
+  {
+    hash_size = SymbolHashTable(
+                  address,
+                  exported_symbols_address,
+                  header->exported_symbols_amount)
+                  .size();
+  }
+  address =
+    set_entry(directory.exported_symbols_hash, base, address, hash_size);
+
+  address = align<std::uintptr_t>(address, 16);
+  address = set_entry(directory.text, base, address, header->code_length);
+  address = set_entry(directory.init, base, address, header->init_length);
+  set_entry(directory.data, base, address, header->data_length);
+  return directory;
+}
+
+SectionDirectory read_section_directory(const Header *header)
+{
+  const SectionDirectory *directory = header->section_directory();
+  if (directory != nullptr)
+  {
+    return *directory;
+  }
+  return build_section_directory(header);
+}
+
+} // namespace
+
 Parser::Parser(const Header *header)
   : header_{ header }
-  , name_{ reinterpret_cast<const char *>(header) + sizeof(Header) }
-  , imported_libaries_{ align<std::uintptr_t>(
-                          reinterpret_cast<std::uintptr_t>(header) +
-                            sizeof(Header) + name_.size(),
-                          header->alignment),
+  , directory_{ read_section_directory(header) }
+  , name_{ reinterpret_cast<const char *>(address_of(directory_.name)),
+           directory_.name.size - 1 }
+  , imported_libaries_{ address_of(directory_.imported_libraries),
                         header->external_libraries_amount,
-                        header->alignment }
-  , symbol_table_relocation_table_{ imported_libaries_.address() +
-                                      imported_libaries_.size(),
+                        header->alignment,
+                        directory_.imported_libraries.size }
+  , symbol_table_relocation_table_{ address_of(
+                                      directory_.symbol_table_relocations),
                                     header->symbol_table_relocations_amount }
-  , local_relocation_table_{ symbol_table_relocation_table_.address() +
-                               symbol_table_relocation_table_.size(),
+  , local_relocation_table_{ address_of(directory_.local_relocations),
                              header->local_relocations_amount }
-  , data_relocation_table_{ local_relocation_table_.address() +
-                              local_relocation_table_.size(),
+  , data_relocation_table_{ address_of(directory_.data_relocations),
                             header->data_relocations_amount }
-  , imported_symbol_table_{ data_relocation_table_.address() +
-                              data_relocation_table_.size(),
+  , imported_symbol_table_{ address_of(directory_.imported_symbols),
                             header->imported_symbols_amount,
-                            header->alignment }
-  , exported_symbol_table_{ imported_symbol_table_.address() +
-                              imported_symbol_table_.size(),
+                            header->alignment,
+                            directory_.imported_symbols.size }
+  , exported_symbol_table_{ address_of(directory_.exported_symbols),
                             header->exported_symbols_amount,
-                            header->alignment }
-  , text_address_{ align<uintptr_t>(
-      exported_symbol_table_.address() + exported_symbol_table_.size(),
-      16) }
-  , init_address_{ text_address_ + header->code_length }
-  , data_address_{ init_address_ + header->init_length }
-
+                            header->alignment,
+                            directory_.exported_symbols.size }
+  , exported_symbol_hash_table_{}
+  , text_address_{ address_of(directory_.text) }
+  , init_address_{ address_of(directory_.init) }
+  , data_address_{ address_of(directory_.data) }
 {
+  if (header->has(Header::Flag::ExportedSymbolsHash))
+  {
+    exported_symbol_hash_table_.emplace(
+      address_of(directory_.exported_symbols_hash),
+      exported_symbol_table_.address(),
+      header->exported_symbols_amount);
+  }
+
 #if defined(LOGGER_ENABLED) && (LOGGER_ENABLED == 1)
   if (header->entry != 0xffffffff)
   {
@@ -87,6 +188,13 @@ Parser::Parser(const Header *header)
     "Exported symbol table at : 0x%lx, size: 0x%lx\n",
     exported_symbol_table_.address(),
     exported_symbol_table_.size());
+  if (exported_symbol_hash_table_)
+  {
+    log(
+      "Exported symbol hash table at : 0x%lx, size: 0x%lx\n",
+      exported_symbol_hash_table_->address(),
+      exported_symbol_hash_table_->size());
+  }
   log(
     "Text section at : 0x%lx, size: 0x%lx\n",
     text_address_,
@@ -114,6 +222,11 @@ Parser::Parser(const Header *header)
 #endif
 }
 
+std::uintptr_t Parser::address_of(const SectionDirectory::Entry &entry) const
+{
+  return reinterpret_cast<std::uintptr_t>(header_) + entry.offset;
+}
+
 const SymbolTable Parser::get_exported_symbol_table() const
 {
   return exported_symbol_table_;
@@ -124,6 +237,12 @@ const SymbolTable Parser::get_imported_symbol_table() const
   return imported_symbol_table_;
 }
 
+const std::optional<SymbolHashTable> &Parser::get_exported_symbol_hash_table()
+  const
+{
+  return exported_symbol_hash_table_;
+}
+
 const RelocationTable<LocalRelocation> Parser::get_local_relocations() const
 {
   return local_relocation_table_;
@@ -158,6 +277,29 @@ std::span<const std::byte> Parser::get_text() const
     reinterpret_cast<const std::byte *>(text_address_), header_->code_length);
 }
 
+std::optional<std::uintptr_t> Parser::get_link_address() const
+{
+  if (
+    !header_->has(Header::Flag::ReadOnlyDataInText) ||
+    header_->has(Header::Flag::CompressedText) ||
+    header_->code_length < sizeof(std::uintptr_t))
+  {
+    return std::nullopt;
+  }
+
+  std::uintptr_t address = 0;
+  std::memcpy(
+    &address,
+    get_text().last(sizeof(std::uintptr_t)).data(),
+    sizeof(std::uintptr_t));
+  return address;
+}
+
+const SectionDirectory &Parser::section_directory() const
+{
+  return directory_;
+}
+
 const std::string_view &Parser::name() const
 {
   return name_;
@@ -0,0 +1,104 @@
+/**
+ * symbol_hash_table.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/symbol_hash_table.hpp"
+
+namespace yasld
+{
+
+SymbolHashTable::SymbolHashTable(
+  std::uintptr_t address,
+  std::uintptr_t symbol_table_address,
+  uint16_t       number_of_symbols)
+  : layout_{ reinterpret_cast<const Layout *>(address) }
+  , bloom_{ reinterpret_cast<const uint32_t *>(layout_ + 1) }
+  , buckets_{ bloom_ + layout_->bloom_size }
+  , chain_{ buckets_ + layout_->number_of_buckets }
+  , offsets_{ chain_ + number_of_symbols }
+  , symbol_table_address_{ symbol_table_address }
+  , number_of_symbols_{ number_of_symbols }
+{
+}
+
+uint32_t SymbolHashTable::hash(const std::string_view &name)
+{
+  // same as dl_new_hash from GNU toolchain, must be in sync with mkimage
+  uint32_t h = 5381;
+  for (const char c : name)
+  {
+    h = h * 33 + static_cast<uint8_t>(c);
+  }
+  return h;
+}
+
+const Symbol *SymbolHashTable::find(
+  const std::string_view &name,
+  uint32_t                hash) const
+{
+  const uint32_t word = bloom_[(hash / 32) & (layout_->bloom_size - 1)];
+  const uint32_t mask =
+    (1u << (hash % 32)) | (1u << ((hash >> layout_->bloom_shift) % 32));
+
+  if ((word & mask) != mask)
+  {
+    return nullptr;
+  }
+
+  uint32_t index = buckets_[hash % layout_->number_of_buckets];
+  if (index == empty_bucket)
+  {
+    return nullptr;
+  }
+
+  for (; index < number_of_symbols_; ++index)
+  {
+    const uint32_t entry = chain_[index];
+    if ((entry | 1) == (hash | 1))
+    {
+      const Symbol *symbol = reinterpret_cast<const Symbol *>(
+        symbol_table_address_ + offsets_[index]);
+      if (symbol->name() == name)
+      {
+        return symbol;
+      }
+    }
+
+    if (entry & 1)
+    {
+      break;
+    }
+  }
+  return nullptr;
+}
+
+std::uintptr_t SymbolHashTable::address() const
+{
+  return reinterpret_cast<std::uintptr_t>(layout_);
+}
+
+std::size_t SymbolHashTable::size() const
+{
+  return sizeof(Layout) +
+         (layout_->bloom_size + layout_->number_of_buckets +
+          2 * static_cast<std::size_t>(number_of_symbols_)) *
+           sizeof(uint32_t);
+}
+
+} // namespace yasld
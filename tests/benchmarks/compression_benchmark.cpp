@@ -0,0 +1,265 @@
+/**
+ * compression_benchmark.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+// Loads image with text and data of real module raw and LZ4 compressed.
+// Sections are taken from ELF given as first argument, by default
+// tests/mkimage_tests/executable_example.elf. Loading from memory is
+// measured on host, storage isn't emulated. Read time is calculated from
+// bytes read from source and bandwidth given as second argument, so result
+// depends on assumed storage and on target decoding speed, which must be
+// measured on target.
+
+#include <elf.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "yasld/image_source.hpp"
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+
+namespace
+{
+
+// Counts bytes read by loader, these must be transferred from storage
+class CountingSource : public yasld::ImageSource
+{
+public:
+  explicit CountingSource(const yasld::test::Image &image)
+    : memory_{ std::as_bytes(std::span(image)) }
+    , read_bytes_{ 0 }
+  {
+  }
+
+  bool read(std::size_t offset, std::span<std::byte> buffer) override
+  {
+    if (offset + buffer.size() > memory_.size())
+    {
+      return false;
+    }
+    std::memcpy(buffer.data(), memory_.data() + offset, buffer.size());
+    read_bytes_ += buffer.size();
+    return true;
+  }
+
+  std::size_t size() const override
+  {
+    return memory_.size();
+  }
+
+  std::size_t read_bytes() const
+  {
+    return read_bytes_;
+  }
+
+private:
+  std::span<const std::byte> memory_;
+  std::size_t                read_bytes_;
+};
+
+struct Sections
+{
+  std::vector<uint8_t> text;
+  std::vector<uint8_t> data;
+};
+
+std::optional<Sections> read_sections(const char *path)
+{
+  std::ifstream file(path, std::ios::binary);
+  const std::vector<uint8_t> elf(
+    (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (elf.size() < sizeof(Elf32_Ehdr))
+  {
+    return std::nullopt;
+  }
+
+  Elf32_Ehdr header;
+  std::memcpy(&header, elf.data(), sizeof(header));
+  if (
+    std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 ||
+    header.e_ident[EI_CLASS] != ELFCLASS32 ||
+    header.e_shoff + header.e_shnum * sizeof(Elf32_Shdr) > elf.size() ||
+    header.e_shstrndx >= header.e_shnum)
+  {
+    return std::nullopt;
+  }
+
+  const auto section_header = [&elf, &header](std::size_t index)
+  {
+    Elf32_Shdr section;
+    std::memcpy(
+      &section,
+      elf.data() + header.e_shoff + index * sizeof(Elf32_Shdr),
+      sizeof(section));
+    return section;
+  };
+
+  const Elf32_Shdr names = section_header(header.e_shstrndx);
+  Sections         sections;
+  for (std::size_t i = 0; i < header.e_shnum; ++i)
+  {
+    const Elf32_Shdr section = section_header(i);
+    if (
+      section.sh_type != SHT_PROGBITS || section.sh_name >= names.sh_size ||
+      section.sh_offset + section.sh_size > elf.size())
+    {
+      continue;
+    }
+    const std::string_view name(
+      reinterpret_cast<const char *>(elf.data()) + names.sh_offset +
+      section.sh_name);
+    const auto begin = elf.begin() + section.sh_offset;
+    const auto end   = begin + section.sh_size;
+    if (name == ".text")
+    {
+      sections.text.assign(begin, end);
+    }
+    else if (name == ".data")
+    {
+      sections.data.assign(begin, end);
+    }
+  }
+  if (sections.text.empty())
+  {
+    return std::nullopt;
+  }
+  return sections;
+}
+
+yasld::test::Image create_image(const Sections &sections, bool compressed)
+{
+  return yasld::test::ImageBuilder("benchmark", yasld::Header::Type::Executable)
+    .add_export("main", 0)
+    .set_sections(sections.text, sections.data)
+    .compress_sections(compressed, compressed)
+    .build();
+}
+
+std::size_t stored_size(const yasld::test::Image &image)
+{
+  const auto &directory =
+    *reinterpret_cast<const yasld::Header *>(image.data())
+       ->section_directory();
+  return directory.text.size + directory.data.size;
+}
+
+struct Result
+{
+  double      load_us;
+  std::size_t read_bytes;
+};
+
+std::optional<Result> measure(
+  yasld::Loader            &loader,
+  const yasld::test::Image &image)
+{
+  constexpr int repetitions = 100;
+
+  CountingSource source(image);
+  const auto     start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repetitions; ++i)
+  {
+    auto executable = loader.load_executable(source);
+    if (!executable)
+    {
+      return std::nullopt;
+    }
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count() /
+                       repetitions;
+  return Result{ .load_us    = static_cast<double>(elapsed) / 1000.0,
+                 .read_bytes = source.read_bytes() / repetitions };
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  const char  *path      = argc > 1 ? argv[1] : YASLD_EXAMPLE_ELF;
+  // bytes per second, default is in range of SPI flash read by byte or SD
+  // card in SPI mode
+  const double bandwidth = argc > 2 ? std::atof(argv[2]) : 5e6;
+  if (bandwidth <= 0.0)
+  {
+    std::printf("Bandwidth must be positive\n");
+    return -1;
+  }
+
+  const auto sections = read_sections(path);
+  if (!sections)
+  {
+    std::printf("Can't read .text and .data from %s\n", path);
+    return -1;
+  }
+
+  yasld::Loader loader(
+    [](std::size_t size, yasld::AllocationType)
+    {
+      return std::malloc(size);
+    },
+    [](void *ptr)
+    {
+      std::free(ptr);
+    });
+
+  std::printf(
+    "Sections of %s: text %zu B, data %zu B\n",
+    path,
+    sections->text.size(),
+    sections->data.size());
+  std::printf(
+    "Storage bandwidth: %.0f B/s, read time is calculated, load time is "
+    "measured on host\n",
+    bandwidth);
+  std::printf(
+    "| image      | stored [B] | read [B] | load [us] | read [us] | "
+    "sum [us] |\n");
+  for (const bool compressed : { false, true })
+  {
+    const auto image  = create_image(*sections, compressed);
+    const auto result = measure(loader, image);
+    if (!result)
+    {
+      std::printf("Loading failed\n");
+      return -1;
+    }
+    const double read_us =
+      static_cast<double>(result->read_bytes) / bandwidth * 1e6;
+    std::printf(
+      "| %-10s | %10zu | %8zu | %9.1f | %9.1f | %8.1f |\n",
+      compressed ? "compressed" : "raw",
+      stored_size(image),
+      result->read_bytes,
+      result->load_us,
+      read_us,
+      result->load_us + read_us);
+  }
+  return 0;
+}
@@ -0,0 +1,266 @@
+/**
+ * load_unload_benchmark.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+// Loads and unloads executables sharing library for thousands of cycles.
+// Modules are allocated from first fit heap, like on target without MMU,
+// so growth of used memory or number of free blocks shows leaks and
+// fragmentation caused by loader.
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <list>
+#include <optional>
+#include <string_view>
+
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+
+namespace
+{
+
+class FirstFitHeap
+{
+public:
+  FirstFitHeap()
+    : blocks_{ Block{ 0, heap_size, true } }
+  {
+  }
+
+  void *allocate(std::size_t size)
+  {
+    size = (size + alignment - 1) & ~(alignment - 1);
+    for (auto block = blocks_.begin(); block != blocks_.end(); ++block)
+    {
+      if (!block->free || block->size < size)
+      {
+        continue;
+      }
+      if (block->size > size)
+      {
+        blocks_.insert(
+          std::next(block),
+          Block{ block->offset + size, block->size - size, true });
+        block->size = size;
+      }
+      block->free = false;
+      used_ += size;
+      ++allocations_;
+      return memory_.data() + block->offset;
+    }
+    return nullptr;
+  }
+
+  void release(void *ptr)
+  {
+    if (ptr == nullptr)
+    {
+      return;
+    }
+    const auto offset =
+      static_cast<std::size_t>(static_cast<std::byte *>(ptr) - memory_.data());
+    for (auto block = blocks_.begin(); block != blocks_.end(); ++block)
+    {
+      if (block->offset != offset)
+      {
+        continue;
+      }
+      block->free = true;
+      used_ -= block->size;
+      auto next = std::next(block);
+      if (next != blocks_.end() && next->free)
+      {
+        block->size += next->size;
+        blocks_.erase(next);
+      }
+      if (block != blocks_.begin() && std::prev(block)->free)
+      {
+        std::prev(block)->size += block->size;
+        blocks_.erase(block);
+      }
+      return;
+    }
+  }
+
+  std::size_t used() const
+  {
+    return used_;
+  }
+
+  std::size_t allocations() const
+  {
+    return allocations_;
+  }
+
+  std::size_t free_blocks() const
+  {
+    std::size_t blocks = 0;
+    for (const auto &block : blocks_)
+    {
+      blocks += block.free ? 1 : 0;
+    }
+    return blocks;
+  }
+
+  std::size_t largest_free_block() const
+  {
+    std::size_t largest = 0;
+    for (const auto &block : blocks_)
+    {
+      if (block.free && block.size > largest)
+      {
+        largest = block.size;
+      }
+    }
+    return largest;
+  }
+
+private:
+  constexpr static std::size_t alignment = alignof(std::max_align_t);
+  constexpr static std::size_t heap_size = 256 * 1024;
+
+  struct Block
+  {
+    std::size_t offset;
+    std::size_t size;
+    bool        free;
+  };
+
+  alignas(alignment) std::array<std::byte, heap_size> memory_;
+  std::list<Block> blocks_;
+  std::size_t      used_        = 0;
+  std::size_t      allocations_ = 0;
+};
+
+FirstFitHeap heap;
+
+yasld::test::Image create_executable(const std::string &name)
+{
+  return yasld::test::ImageBuilder(name, yasld::Header::Type::Executable)
+    .add_dependency("libshared")
+    .add_import("shared_function")
+    .add_export("main", 0)
+    .set_text_size(512)
+    .set_data_size(256, 512)
+    .add_fini(4)
+    .build();
+}
+
+} // namespace
+
+int main()
+{
+  constexpr int cycles       = 10000;
+  constexpr int report_every = 1000;
+
+  yasld::Loader loader(
+    [](std::size_t size, yasld::AllocationType)
+    {
+      return heap.allocate(size);
+    },
+    [](void *ptr)
+    {
+      heap.release(ptr);
+    });
+
+  const auto library =
+    yasld::test::ImageBuilder("libshared", yasld::Header::Type::Library)
+      .add_export("shared_function", 8)
+      .set_data_size(128, 1024)
+      .add_fini(8)
+      .build();
+  const auto first  = create_executable("first");
+  const auto second = create_executable("second");
+
+  loader.register_file_resolver(
+    [&library](const std::string_view &name) -> std::optional<const void *>
+    {
+      if (name == "libshared")
+      {
+        return library.data();
+      }
+      return std::nullopt;
+    });
+
+  std::printf("| cycles | used [B] | free blocks | largest free [B] | "
+              "allocations per cycle | cycle [us] |\n");
+
+  std::size_t used        = 0;
+  std::size_t free_blocks = 0;
+  std::size_t allocations = heap.allocations();
+  auto        start       = std::chrono::steady_clock::now();
+  for (int cycle = 1; cycle <= cycles; ++cycle)
+  {
+    // interleaved lifetimes, so shared library outlives first consumer
+    auto a = loader.load_executable(first.data());
+    auto b = loader.load_executable(second.data());
+    if (!a || !b)
+    {
+      std::printf("Loading failed in cycle %d\n", cycle);
+      return -1;
+    }
+    loader.unload(std::move(*a));
+    auto c = loader.load_library(library.data());
+    if (!c)
+    {
+      std::printf("Loading failed in cycle %d\n", cycle);
+      return -1;
+    }
+    loader.unload(std::move(*b));
+    loader.unload(std::move(*c));
+    a.reset();
+    b.reset();
+    c.reset();
+
+    if (cycle == 1)
+    {
+      // loader keeps buffers for registry and load stack
+      used        = heap.used();
+      free_blocks = heap.free_blocks();
+    }
+
+    if (cycle % report_every == 0)
+    {
+      const auto elapsed =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count() /
+        report_every;
+      std::printf(
+        "| %6d | %8zu | %11zu | %16zu | %21zu | %10.1f |\n",
+        cycle,
+        heap.used(),
+        heap.free_blocks(),
+        heap.largest_free_block(),
+        (heap.allocations() - allocations) / report_every,
+        static_cast<double>(elapsed) / 1000.0);
+      if (heap.used() != used || heap.free_blocks() > free_blocks)
+      {
+        std::printf("Heap grows after %d cycles\n", cycle);
+        return -1;
+      }
+      allocations = heap.allocations();
+      start       = std::chrono::steady_clock::now();
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * module_lookup_benchmark.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+// Measures module lookups done by supervisor call handlers on every wrapped
+// call, with growing number of loaded modules. Executables call shared
+// library, which is also loaded standalone from the same image, so library
+// text belongs to two modules and caller must be found by LOT. Cost per
+// lookup should stay flat when lookups don't walk module trees.
+// Whole call path is measured with host entry and exit hooks, which do the
+// same work as supervisor calls on target.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "yasld/host_call.hpp"
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+
+int main()
+{
+  constexpr std::size_t modules[]   = { 2, 4, 8, 16, 32, 64 };
+  constexpr int         repetitions = 100000;
+
+  yasld::Loader         loader(
+    [](std::size_t size, yasld::AllocationType)
+    {
+      return std::malloc(size);
+    },
+    [](void *ptr)
+    {
+      std::free(ptr);
+    });
+
+  const auto library =
+    yasld::test::ImageBuilder("libshared", yasld::Header::Type::Library)
+      .add_export("shared_function", 8)
+      .set_data_size(64, 64)
+      .build();
+  const auto image =
+    yasld::test::ImageBuilder("executable", yasld::Header::Type::Executable)
+      .add_dependency("libshared")
+      .add_import("shared_function")
+      .add_export("main", 0)
+      .set_data_size(64, 64)
+      .build();
+
+  loader.register_file_resolver(
+    [&library](const std::string_view &name) -> std::optional<const void *>
+    {
+      if (name == "libshared")
+      {
+        return library.data();
+      }
+      return std::nullopt;
+    });
+
+  auto standalone = loader.load_library(library.data());
+  if (!standalone)
+  {
+    std::printf("Loading of library failed\n");
+    return -1;
+  }
+
+  std::printf(
+    "| modules | entry lookup [ns] | lot lookup [ns] | entry and exit [ns] "
+    "|\n");
+  for (const auto number_of_modules : modules)
+  {
+    std::vector<yasld::Loader::ObservedExecutable> executables;
+    std::vector<std::size_t>                       lots;
+    executables.reserve(number_of_modules);
+    for (std::size_t i = 0; i < number_of_modules; ++i)
+    {
+      auto executable = loader.load_executable(image.data());
+      if (!executable)
+      {
+        std::printf("Loading failed for %zu modules\n", number_of_modules);
+        return -1;
+      }
+      executables.push_back(std::move(*executable));
+    }
+    for (auto &executable : executables)
+    {
+      lots.push_back(
+        reinterpret_cast<std::size_t>(executable->get_lot().data()));
+    }
+    const std::size_t program_counter =
+      reinterpret_cast<std::size_t>((*standalone)->get_text().data()) + 8;
+
+    std::size_t found = 0;
+    auto        start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+      const auto lot = lots[static_cast<std::size_t>(i) % lots.size()];
+      found += loader.find_module_for_pc_and_lot(program_counter, lot) !=
+               nullptr;
+    }
+    const auto entry = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+      const auto lot = lots[static_cast<std::size_t>(i) % lots.size()];
+      found += loader.find_module_with_lot(lot) != nullptr;
+    }
+    const auto lot = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+      yasld::set_current_lot(lots[static_cast<std::size_t>(i) % lots.size()]);
+      found += yasld::enter_module_call(loader, program_counter) &&
+               yasld::exit_module_call(loader);
+    }
+    const auto call = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+    if (found != 3 * repetitions)
+    {
+      std::printf("Lookup failed for %zu modules\n", number_of_modules);
+      return -1;
+    }
+
+    std::printf(
+      "| %7zu | %17.1f | %15.1f | %19.1f |\n",
+      number_of_modules,
+      static_cast<double>(entry) / repetitions,
+      static_cast<double>(lot) / repetitions,
+      static_cast<double>(call) / repetitions);
+  }
+  return 0;
+}
@@ -0,0 +1,268 @@
+/**
+ * pool_allocator_benchmark.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+// Compares pool allocator with malloc on allocations made by loader. Trace
+// of allocations and releases is recorded from load and unload of modules
+// with interleaved lifetimes, then replayed on each allocator, so only
+// allocator cost is measured. Tail of single operation times shows
+// determinism of allocator.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "yasld/loader.hpp"
+#include "yasld/pool_allocator.hpp"
+
+#include "image_builder.hpp"
+
+namespace
+{
+
+struct Event
+{
+  // allocation has size, release doesn't
+  std::size_t           size;
+  std::size_t           id;
+  yasld::AllocationType type;
+};
+
+std::vector<Event>                      trace;
+std::unordered_map<void *, std::size_t> live;
+std::size_t                             next_id = 0;
+
+// Pools sized for trace on 64-bit host, where module objects and pointers
+// are bigger than on target
+using HostPoolAllocator = yasld::PoolAllocator<
+  yasld::FixedBlockPool<64, 64>,
+  yasld::FixedBlockPool<256, 32>,
+  yasld::FixedBlockPool<1024, 16>,
+  yasld::FixedBlockPool<4096, 16>>;
+
+yasld::test::Image create_executable(const std::string &name, uint32_t size)
+{
+  return yasld::test::ImageBuilder(name, yasld::Header::Type::Executable)
+    .add_dependency("libshared")
+    .add_import("shared_function")
+    .add_export("main", 0)
+    .set_data_size(size, size)
+    .add_fini(4)
+    .build();
+}
+
+bool record_trace()
+{
+  yasld::Loader loader(
+    [](std::size_t size, yasld::AllocationType type)
+    {
+      void *memory = std::malloc(size);
+      live[memory] = next_id;
+      trace.push_back({ size, next_id++, type });
+      return memory;
+    },
+    [](void *ptr)
+    {
+      const auto it = live.find(ptr);
+      if (it != live.end())
+      {
+        trace.push_back({ 0, it->second, yasld::AllocationType::Module });
+        live.erase(it);
+      }
+      std::free(ptr);
+    });
+
+  const auto library =
+    yasld::test::ImageBuilder("libshared", yasld::Header::Type::Library)
+      .add_export("shared_function", 8)
+      .set_data_size(128, 512)
+      .build();
+  loader.register_file_resolver(
+    [&library](const std::string_view &name) -> std::optional<const void *>
+    {
+      if (name == "libshared")
+      {
+        return library.data();
+      }
+      return std::nullopt;
+    });
+
+  std::vector<yasld::test::Image> images;
+  for (uint32_t i = 0; i < 7; ++i)
+  {
+    images.push_back(create_executable("app" + std::to_string(i), 16u << i));
+  }
+
+  // pseudo random, but same for each run
+  uint32_t state = 12345;
+  auto     next  = [&state]()
+  {
+    state = state * 1103515245 + 12345;
+    return (state >> 16) & 0x7fff;
+  };
+
+  // up to 4 executables are running, each slot is loaded or unloaded
+  std::array<std::optional<yasld::Loader::ObservedExecutable>, 4> running;
+  for (int i = 0; i < 2000; ++i)
+  {
+    auto &slot = running[next() % running.size()];
+    if (slot)
+    {
+      loader.unload(std::move(*slot));
+      slot.reset();
+      continue;
+    }
+    auto executable =
+      loader.load_executable(images[next() % images.size()].data());
+    if (!executable)
+    {
+      return false;
+    }
+    slot.emplace(std::move(*executable));
+  }
+  for (auto &slot : running)
+  {
+    if (slot)
+    {
+      loader.unload(std::move(*slot));
+    }
+  }
+  return true;
+}
+
+struct Result
+{
+  double average;
+  double percentile;
+};
+
+template <typename Allocate, typename Release>
+void run(
+  const Allocate      &allocate,
+  const Release       &release,
+  std::vector<void *> &memory,
+  const Event         &event)
+{
+  if (event.size != 0)
+  {
+    memory[event.id] = allocate(event.size, event.type);
+  }
+  else
+  {
+    release(memory[event.id]);
+  }
+}
+
+template <typename Allocate, typename Release>
+Result replay(const Allocate &allocate, const Release &release)
+{
+  constexpr int repetitions = 100;
+
+  std::vector<void *> memory(next_id, nullptr);
+  const auto          start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repetitions; ++i)
+  {
+    for (const auto &event : trace)
+    {
+      run(allocate, release, memory, event);
+    }
+  }
+  const auto total = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  // single operations include clock overhead, percentile skips preemption
+  std::vector<std::int64_t> times;
+  for (const auto &event : trace)
+  {
+    const auto operation_start = std::chrono::steady_clock::now();
+    run(allocate, release, memory, event);
+    times.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - operation_start)
+                      .count());
+  }
+  std::sort(times.begin(), times.end());
+  return { static_cast<double>(total) /
+             static_cast<double>(trace.size() * repetitions),
+           static_cast<double>(times[times.size() * 999 / 1000]) };
+}
+
+} // namespace
+
+int main()
+{
+  if (!record_trace())
+  {
+    std::printf("Recording of trace failed\n");
+    return -1;
+  }
+
+  int               fallbacks = 0;
+  HostPoolAllocator pool(
+    [&fallbacks](std::size_t size, yasld::AllocationType)
+    {
+      ++fallbacks;
+      return std::malloc(size);
+    },
+    [](void *ptr)
+    {
+      std::free(ptr);
+    });
+
+  const Result heap = replay(
+    [](std::size_t size, yasld::AllocationType)
+    {
+      return std::malloc(size);
+    },
+    [](void *ptr)
+    {
+      std::free(ptr);
+    });
+  const Result pools = replay(
+    [&pool](std::size_t size, yasld::AllocationType type)
+    {
+      return pool.allocate(size, type);
+    },
+    [&pool](void *ptr)
+    {
+      pool.release(ptr);
+    });
+
+  std::printf("Trace of %zu operations\n", trace.size());
+  std::printf("| allocator | average [ns] | 99.9th percentile [ns] |\n");
+  std::printf(
+    "| malloc    | %12.1f | %22.1f |\n", heap.average, heap.percentile);
+  std::printf(
+    "| pool      | %12.1f | %22.1f |\n", pools.average, pools.percentile);
+  std::printf("Allocations passed to fallback: %d\n", fallbacks);
+  std::printf(
+    "Peak blocks of pools: %zu %zu %zu %zu\n",
+    pool.get_pool<0>().peak_blocks(),
+    pool.get_pool<1>().peak_blocks(),
+    pool.get_pool<2>().peak_blocks(),
+    pool.get_pool<3>().peak_blocks());
+  return 0;
+}
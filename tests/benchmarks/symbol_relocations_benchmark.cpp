@@ -0,0 +1,131 @@
+/**
+ * symbol_relocations_benchmark.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+// Measures load time of executable with growing number of imported symbols.
+// Symbols are provided by hashed environment, so time spent in lookup is
+// constant and per import cost should stay flat when loader is linear.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "yasld/environment.hpp"
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+
+namespace
+{
+
+class HashedEnvironment : public yasld::Environment
+{
+public:
+  explicit HashedEnvironment(std::size_t number_of_symbols)
+  {
+    names_.reserve(number_of_symbols);
+    entries_.reserve(number_of_symbols);
+    for (std::size_t i = 0; i < number_of_symbols; ++i)
+    {
+      names_.push_back("symbol_" + std::to_string(i));
+      void *address = &names_;
+      entries_.emplace_back(names_.back(), address);
+    }
+    for (const auto &entry : entries_)
+    {
+      index_.emplace(entry.name, &entry);
+    }
+  }
+
+  const yasld::SymbolEntry *find_symbol(
+    const std::string_view &name) const override
+  {
+    const auto it = index_.find(name);
+    return it != index_.end() ? it->second : nullptr;
+  }
+
+private:
+  std::vector<std::string>                                         names_;
+  std::vector<yasld::SymbolEntry>                                  entries_;
+  std::unordered_map<std::string_view, const yasld::SymbolEntry *> index_;
+};
+
+yasld::test::Image create_image(std::size_t number_of_imports)
+{
+  yasld::test::ImageBuilder builder(
+    "benchmark", yasld::Header::Type::Executable);
+  for (std::size_t i = 0; i < number_of_imports; ++i)
+  {
+    builder.add_import("symbol_" + std::to_string(i));
+  }
+  builder.add_export("main", 0);
+  return builder.build();
+}
+
+} // namespace
+
+int main()
+{
+  constexpr std::size_t imports[]   = { 10, 100, 500, 1000, 2000, 5000 };
+  constexpr int         repetitions = 20;
+
+  yasld::Loader         loader(
+    [](std::size_t size, yasld::AllocationType)
+    {
+      return std::malloc(size);
+    },
+    [](void *ptr)
+    {
+      std::free(ptr);
+    });
+
+  std::printf("| imports | load time [us] | per import [ns] |\n");
+  for (const auto number_of_imports : imports)
+  {
+    const auto        image = create_image(number_of_imports);
+    HashedEnvironment environment(number_of_imports);
+    loader.set_environment(environment);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+      auto executable = loader.load_executable(image.data());
+      if (!executable)
+      {
+        std::printf("Loading failed for %zu imports\n", number_of_imports);
+        return -1;
+      }
+    }
+    const auto elapsed =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start)
+        .count() /
+      repetitions;
+
+    std::printf(
+      "| %7zu | %14.1f | %15.1f |\n",
+      number_of_imports,
+      static_cast<double>(elapsed) / 1000.0,
+      static_cast<double>(elapsed) / static_cast<double>(number_of_imports));
+  }
+  return 0;
+}
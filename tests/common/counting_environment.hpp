@@ -0,0 +1,69 @@
+/**
+ * counting_environment.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "yasld/environment.hpp"
+
+namespace yasld::test
+{
+
+// Environment over unsorted symbols which counts lookups, so tests may check
+// when imports are resolved. Fingerprint is set by test.
+class CountingEnvironment : public Environment
+{
+public:
+  explicit CountingEnvironment(std::vector<SymbolEntry> entries)
+    : entries_{ std::move(entries) }
+  {
+  }
+
+  const SymbolEntry *find_symbol(const std::string_view &name) const override
+  {
+    ++lookups;
+    for (const auto &symbol : entries_)
+    {
+      if (symbol.name == name)
+      {
+        return &symbol;
+      }
+    }
+    return nullptr;
+  }
+
+  std::optional<uint32_t> fingerprint() const override
+  {
+    return fingerprint_;
+  }
+
+  mutable int             lookups      = 0;
+  std::optional<uint32_t> fingerprint_ = std::nullopt;
+
+private:
+  std::vector<SymbolEntry> entries_;
+};
+
+} // namespace yasld::test
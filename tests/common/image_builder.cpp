@@ -0,0 +1,375 @@
+/**
+ * image_builder.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "image_builder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "yasld/section.hpp"
+
+#include "lz4_encoder.hpp"
+
+namespace yasld::test
+{
+
+namespace
+{
+
+constexpr uint8_t alignment = 4;
+
+#if defined(__x86_64__) || defined(__i386__)
+constexpr uint8_t return_instruction[] = { 0xc3 };
+#elif defined(__aarch64__)
+constexpr uint8_t return_instruction[] = { 0xc0, 0x03, 0x5f, 0xd6 };
+#else
+#error "Return instruction is not defined for host architecture"
+#endif
+
+template <typename T>
+void append(std::vector<uint8_t> &image, const T &value)
+{
+  const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+  image.insert(image.end(), bytes, bytes + sizeof(T));
+}
+
+void append_aligned(
+  std::vector<uint8_t> &image,
+  const std::string    &text,
+  std::size_t           to)
+{
+  image.insert(image.end(), text.begin(), text.end());
+  image.push_back(0);
+  while (image.size() % to != 0)
+  {
+    image.push_back(0);
+  }
+}
+
+} // namespace
+
+ImageBuilder::ImageBuilder(const std::string &name, Header::Type type)
+  : name_{ name }
+  , type_{ type }
+  , dependencies_{}
+  , imports_{}
+  , imported_functions_{}
+  , exports_{}
+  , export_offsets_{}
+  , fini_{}
+  , text_size_{ 16 }
+  , data_size_{ 0 }
+  , text_contents_{}
+  , data_contents_{}
+  , bss_size_{ 0 }
+  , version_{ Header::latest_version }
+  , arch_{ Header::Architecture::Armv6_m }
+  , direct_calls_{ false }
+  , link_displacement_{}
+  , compress_text_{ false }
+  , compress_data_{ false }
+{
+}
+
+ImageBuilder &ImageBuilder::add_dependency(const std::string &name)
+{
+  dependencies_.push_back(name);
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::add_import(const std::string &name)
+{
+  imports_.push_back(name);
+  imported_functions_.push_back(false);
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::add_imported_function(const std::string &name)
+{
+  imports_.push_back(name);
+  imported_functions_.push_back(true);
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::add_export(
+  const std::string &name,
+  uint32_t           text_offset)
+{
+  exports_.push_back(name);
+  export_offsets_.push_back(text_offset);
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::set_version(uint8_t version)
+{
+  version_ = version;
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::set_architecture(Header::Architecture arch)
+{
+  arch_ = arch;
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::set_text_size(uint32_t size)
+{
+  text_size_ = size;
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::set_data_size(uint32_t data_size, uint32_t bss_size)
+{
+  data_size_ = data_size;
+  bss_size_  = bss_size;
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::set_sections(
+  const std::vector<uint8_t> &text,
+  const std::vector<uint8_t> &data)
+{
+  text_contents_ = text;
+  data_contents_ = data;
+  text_size_     = static_cast<uint32_t>(text.size());
+  data_size_     = static_cast<uint32_t>(data.size());
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::add_fini(uint32_t text_offset)
+{
+  fini_.push_back(text_offset);
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::set_lot_base_slot(uint32_t text_offset)
+{
+  direct_calls_ = true;
+  return add_export("__yasld_lot_base", text_offset);
+}
+
+ImageBuilder &ImageBuilder::set_read_only_data_in_text(
+  std::ptrdiff_t displacement)
+{
+  link_displacement_ = displacement;
+  return *this;
+}
+
+ImageBuilder &ImageBuilder::compress_sections(bool text, bool data)
+{
+  compress_text_ = text;
+  compress_data_ = data;
+  return *this;
+}
+
+Image ImageBuilder::build() const
+{
+  const bool has_imported_functions =
+    std::find(imported_functions_.begin(), imported_functions_.end(), true) !=
+    imported_functions_.end();
+  uint8_t flags = 0;
+  if (has_imported_functions)
+  {
+    flags |= static_cast<uint8_t>(Header::Flag::ImportedFunctions);
+  }
+  if (direct_calls_)
+  {
+    flags |= static_cast<uint8_t>(Header::Flag::DirectCalls);
+  }
+  if (link_displacement_)
+  {
+    flags |= static_cast<uint8_t>(Header::Flag::ReadOnlyDataInText);
+  }
+  if (compress_text_)
+  {
+    flags |= static_cast<uint8_t>(Header::Flag::CompressedText);
+  }
+  if (compress_data_)
+  {
+    flags |= static_cast<uint8_t>(Header::Flag::CompressedData);
+  }
+
+  std::vector<uint8_t> image;
+  image.insert(image.end(), { 'Y', 'A', 'F', 'F' });
+  append(image, type_);
+  append(image, arch_);
+  append(image, version_);
+  append(image, text_size_);
+  append(image, static_cast<uint32_t>(fini_.size() * sizeof(std::size_t)));
+  append(image, data_size_);
+  append(image, bss_size_);
+  append(image, static_cast<uint32_t>(0xffffffff));
+  append(image, static_cast<uint16_t>(dependencies_.size()));
+  append(image, alignment);
+  append(image, flags);
+  append(image, static_cast<uint16_t>(0));
+  append(image, static_cast<uint16_t>(0));
+  append(image, static_cast<uint16_t>(imports_.size()));
+  append(image, static_cast<uint16_t>(0));
+  append(image, static_cast<uint16_t>(0));
+  append(image, static_cast<uint16_t>(fini_.size()));
+  append(image, static_cast<uint16_t>(exports_.size()));
+  append(image, static_cast<uint16_t>(imports_.size()));
+
+  const bool has_directory = version_ >= Header::version_with_directory;
+
+  const std::size_t directory_offset = image.size();
+  if (has_directory)
+  {
+    image.resize(image.size() + sizeof(SectionDirectory), 0);
+  }
+
+  std::vector<SectionDirectory::Entry> directory;
+
+  const auto start_section = [&image, &directory]()
+  {
+    directory.push_back({ static_cast<uint32_t>(image.size()), 0 });
+  };
+  const auto end_section = [&image, &directory]()
+  {
+    directory.back().size =
+      static_cast<uint32_t>(image.size() - directory.back().offset);
+  };
+
+  start_section();
+  append_aligned(image, name_, alignment);
+  directory.back().size = static_cast<uint32_t>(name_.size() + 1);
+
+  start_section();
+  for (const auto &dependency : dependencies_)
+  {
+    append_aligned(image, dependency, alignment);
+  }
+  end_section();
+
+  start_section();
+  for (uint32_t i = 0; i < imports_.size(); ++i)
+  {
+    append(image, i);
+    append(image, i);
+  }
+  end_section();
+
+  // local and data relocations are not generated
+  start_section();
+  start_section();
+
+  start_section();
+  for (std::size_t i = 0; i < imports_.size(); ++i)
+  {
+    const bool unknown = has_imported_functions && !imported_functions_[i];
+    append(
+      image,
+      static_cast<uint32_t>(unknown ? Section::unknown : Section::code));
+    append_aligned(image, imports_[i], alignment);
+  }
+  end_section();
+
+  start_section();
+  for (std::size_t i = 0; i < exports_.size(); ++i)
+  {
+    append(image, static_cast<uint32_t>(export_offsets_[i] << 2));
+    append_aligned(image, exports_[i], alignment);
+  }
+  end_section();
+
+  // no exported symbols hash
+  start_section();
+
+  image.resize((image.size() + 15) & ~static_cast<std::size_t>(15), 0);
+  // text and data are filled with pattern, so copies can be verified
+  std::vector<uint8_t> text(text_size_);
+  for (uint32_t i = 0; i < text_size_; ++i)
+  {
+    text[i] = static_cast<uint8_t>(i);
+  }
+  if (text_contents_)
+  {
+    text = *text_contents_;
+  }
+  for (const auto offset : fini_)
+  {
+    std::copy(
+      std::begin(return_instruction),
+      std::end(return_instruction),
+      text.begin() + offset);
+  }
+  if (compress_text_)
+  {
+    text = lz4_compress(text);
+  }
+  std::vector<uint8_t> data(data_size_);
+  for (uint32_t i = 0; i < data_size_; ++i)
+  {
+    data[i] = static_cast<uint8_t>(~i);
+  }
+  if (data_contents_)
+  {
+    data = *data_contents_;
+  }
+  if (compress_data_)
+  {
+    data = lz4_compress(data);
+  }
+
+  const std::size_t text_offset = image.size();
+  start_section();
+  image.insert(image.end(), text.begin(), text.end());
+  end_section();
+  start_section();
+  // init entries have size of pointer on target
+  for (const auto offset : fini_)
+  {
+    append(image, static_cast<std::size_t>(offset));
+  }
+  end_section();
+  start_section();
+  image.insert(image.end(), data.begin(), data.end());
+  end_section();
+  image.resize((image.size() + 15) & ~static_cast<std::size_t>(15), 0);
+
+  if (has_directory)
+  {
+    std::memcpy(
+      image.data() + directory_offset,
+      directory.data(),
+      directory.size() * sizeof(SectionDirectory::Entry));
+  }
+
+  Image aligned(image.size() / sizeof(ImageBlock));
+  std::memcpy(aligned.data(), image.data(), image.size());
+  if (link_displacement_)
+  {
+    // address is known when image is placed in executable memory
+    const std::uintptr_t address =
+      reinterpret_cast<std::uintptr_t>(aligned.data()) + *link_displacement_;
+    std::memcpy(
+      reinterpret_cast<std::byte *>(aligned.data()) + text_offset + text_size_ -
+        sizeof(address),
+      &address,
+      sizeof(address));
+  }
+  __builtin___clear_cache(
+    reinterpret_cast<char *>(aligned.data()),
+    reinterpret_cast<char *>(aligned.data() + aligned.size()));
+  return aligned;
+}
+
+} // namespace yasld::test
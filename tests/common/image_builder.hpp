@@ -0,0 +1,137 @@
+/**
+ * image_builder.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "yasld/header.hpp"
+
+namespace yasld::test
+{
+
+struct alignas(16) ImageBlock
+{
+  uint8_t bytes[16];
+};
+
+// Host call_entry calls native code, so images are placed in executable
+// memory and .fini_array entries point to return instruction
+template <typename T>
+struct ExecutableAllocator
+{
+  using value_type = T;
+
+  ExecutableAllocator() = default;
+
+  template <typename U>
+  ExecutableAllocator(const ExecutableAllocator<U> &)
+  {
+  }
+
+  T *allocate(std::size_t n)
+  {
+    void *memory = mmap(
+      nullptr,
+      n * sizeof(T),
+      PROT_READ | PROT_WRITE | PROT_EXEC,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+    if (memory == MAP_FAILED)
+    {
+      throw std::bad_alloc();
+    }
+    return static_cast<T *>(memory);
+  }
+
+  void deallocate(T *p, std::size_t n)
+  {
+    munmap(p, n * sizeof(T));
+  }
+
+  bool operator==(const ExecutableAllocator &) const = default;
+};
+
+using Image = std::vector<ImageBlock, ExecutableAllocator<ImageBlock>>;
+
+// Builds synthetic YASIFF images in memory, so loader can be exercised on
+// host without cross toolchain and mkimage
+class ImageBuilder
+{
+public:
+  ImageBuilder(const std::string &name, Header::Type type);
+
+  ImageBuilder &add_dependency(const std::string &name);
+  ImageBuilder &add_import(const std::string &name);
+  // Marks imported functions in image, like mkimage does
+  ImageBuilder &add_imported_function(const std::string &name);
+  ImageBuilder &add_export(const std::string &name, uint32_t text_offset);
+  ImageBuilder &set_version(uint8_t version);
+  ImageBuilder &set_architecture(Header::Architecture arch);
+  ImageBuilder &set_text_size(uint32_t size);
+  ImageBuilder &set_data_size(uint32_t data_size, uint32_t bss_size);
+  // Stores given contents instead of pattern, i.e. sections of real module
+  ImageBuilder &set_sections(
+    const std::vector<uint8_t> &text,
+    const std::vector<uint8_t> &data);
+  // Adds .fini_array entry pointing to text, return instruction of host is
+  // placed there
+  ImageBuilder &add_fini(uint32_t text_offset);
+  // Exports LOT base slot of direct call wrappers
+  ImageBuilder &set_lot_base_slot(uint32_t text_offset);
+  // Stores link address of read only data in last word of text, address of
+  // built image moved by displacement
+  ImageBuilder &set_read_only_data_in_text(std::ptrdiff_t displacement = 0);
+  // Stores text and data as LZ4 blocks
+  ImageBuilder &compress_sections(bool text, bool data);
+
+  // Returned buffer is aligned to 16 bytes like images placed in flash
+  Image build() const;
+
+private:
+  std::string                         name_;
+  Header::Type                        type_;
+  std::vector<std::string>            dependencies_;
+  std::vector<std::string>            imports_;
+  std::vector<bool>                   imported_functions_;
+  std::vector<std::string>            exports_;
+  std::vector<uint32_t>               export_offsets_;
+  std::vector<uint32_t>               fini_;
+  uint32_t                            text_size_;
+  uint32_t                            data_size_;
+  std::optional<std::vector<uint8_t>> text_contents_;
+  std::optional<std::vector<uint8_t>> data_contents_;
+  uint32_t                            bss_size_;
+  uint8_t                             version_;
+  Header::Architecture                arch_;
+  bool                                direct_calls_;
+  std::optional<std::ptrdiff_t>       link_displacement_;
+  bool                                compress_text_;
+  bool                                compress_data_;
+};
+
+} // namespace yasld::test
@@ -0,0 +1,86 @@
+/**
+ * loader_fixture.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+
+namespace yasld::test
+{
+
+// Loader with dependencies resolved from images added by test, memory is
+// taken from malloc unless test passes own allocator. Tests of loader
+// features derive from it and keep only images and checks they need.
+class LoaderFixture : public ::testing::Test
+{
+public:
+  LoaderFixture()
+    : LoaderFixture(
+        [](std::size_t size, AllocationType)
+        {
+          return std::malloc(size);
+        },
+        [](void *ptr)
+        {
+          std::free(ptr);
+        })
+  {
+  }
+
+  LoaderFixture(const AllocatorType &allocator, const ReleaseType &release)
+    : loader_{ allocator, release }
+    , images_{}
+  {
+    loader_.register_file_resolver(
+      [this](const std::string_view &name) -> std::optional<const void *>
+      {
+        const auto image = images_.find(name);
+        if (image == images_.end())
+        {
+          return std::nullopt;
+        }
+        return image->second.data();
+      });
+  }
+
+protected:
+  // Image is resolved by name when module depends on it
+  const Image &add_image(const std::string &name, Image image)
+  {
+    return images_.insert_or_assign(name, std::move(image)).first->second;
+  }
+
+  Loader                                    loader_;
+  std::map<std::string, Image, std::less<>> images_;
+};
+
+} // namespace yasld::test
@@ -0,0 +1,123 @@
+/**
+ * lz4_encoder.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "lz4_encoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace yasld::test
+{
+
+namespace
+{
+
+constexpr std::size_t min_match        = 4;
+// LZ4 block ends with at least 5 literals and last match starts at least
+// 12 bytes before end
+constexpr std::size_t last_literals    = 5;
+constexpr std::size_t match_find_limit = 12;
+constexpr std::size_t max_offset       = 0xffff;
+
+void write_length(std::vector<uint8_t> &output, std::size_t length)
+{
+  length -= 15;
+  for (; length >= 255; length -= 255)
+  {
+    output.push_back(255);
+  }
+  output.push_back(static_cast<uint8_t>(length));
+}
+
+void write_sequence(
+  std::vector<uint8_t>    &output,
+  std::span<const uint8_t> literals,
+  std::size_t              offset,
+  std::size_t              match_length)
+{
+  const std::size_t literal_length = literals.size();
+  const std::size_t match_code =
+    match_length == 0 ? 0 : match_length - min_match;
+  output.push_back(static_cast<uint8_t>(
+    (std::min<std::size_t>(literal_length, 15) << 4) |
+    std::min<std::size_t>(match_code, 15)));
+  if (literal_length >= 15)
+  {
+    write_length(output, literal_length);
+  }
+  output.insert(output.end(), literals.begin(), literals.end());
+  if (match_length == 0)
+  {
+    return;
+  }
+  output.push_back(static_cast<uint8_t>(offset));
+  output.push_back(static_cast<uint8_t>(offset >> 8));
+  if (match_code >= 15)
+  {
+    write_length(output, match_code);
+  }
+}
+
+} // namespace
+
+std::vector<uint8_t> lz4_compress(std::span<const uint8_t> data)
+{
+  std::vector<uint8_t>                      output;
+  std::unordered_map<uint32_t, std::size_t> positions;
+  std::size_t                               anchor   = 0;
+  std::size_t                               position = 0;
+
+  while (position + match_find_limit < data.size())
+  {
+    uint32_t key = 0;
+    std::memcpy(&key, data.data() + position, sizeof(key));
+    const auto candidate = positions.find(key);
+    if (
+      candidate == positions.end() ||
+      position - candidate->second > max_offset)
+    {
+      positions[key] = position;
+      ++position;
+      continue;
+    }
+    const std::size_t match = candidate->second;
+    candidate->second       = position;
+
+    std::size_t       length     = min_match;
+    const std::size_t max_length = data.size() - last_literals - position;
+    while (length < max_length &&
+           data[match + length] == data[position + length])
+    {
+      ++length;
+    }
+    write_sequence(
+      output,
+      data.subspan(anchor, position - anchor),
+      position - match,
+      length);
+    position += length;
+    anchor = position;
+  }
+  write_sequence(output, data.subspan(anchor), 0, 0);
+  return output;
+}
+
+} // namespace yasld::test
@@ -0,0 +1,73 @@
+/**
+ * memory_source.hpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+
+#include "yasld/image_source.hpp"
+
+#include "image_builder.hpp"
+
+namespace yasld::test
+{
+
+// Image source over memory, counts reads, so tests may check how source is
+// accessed
+class MemorySource : public ImageSource
+{
+public:
+  explicit MemorySource(std::span<const std::byte> memory)
+    : memory_{ memory }
+  {
+  }
+
+  explicit MemorySource(const Image &image)
+    : MemorySource(std::as_bytes(std::span(image)))
+  {
+  }
+
+  bool read(std::size_t offset, std::span<std::byte> buffer) override
+  {
+    ++reads;
+    if (offset + buffer.size() > memory_.size())
+    {
+      return false;
+    }
+    std::memcpy(buffer.data(), memory_.data() + offset, buffer.size());
+    bytes += buffer.size();
+    return true;
+  }
+
+  std::size_t size() const override
+  {
+    return memory_.size();
+  }
+
+  int         reads = 0;
+  std::size_t bytes = 0;
+
+private:
+  std::span<const std::byte> memory_;
+};
+
+} // namespace yasld::test
@@ -14,6 +14,57 @@ import unittest
 
 import struct
 
+HEADER_FORMAT = "<4sBHBIIIIIHBBHHHHHHHH"
+HEADER_FIELDS = [
+    "cookie",
+    "module_type",
+    "arch",
+    "yasiff_version",
+    "code_length",
+    "init_length",
+    "data_length",
+    "bss_length",
+    "entry",
+    "external_libraries",
+    "alignment",
+    "flags",
+    "version_major",
+    "version_minor",
+    "symbol_table_relocations",
+    "local_relocations",
+    "data_relocations",
+    "fini_arrays",
+    "exported_symbols",
+    "imported_symbols",
+]
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+
+SECTION_NAMES = [
+    "name",
+    "imported_libraries",
+    "symbol_table_relocations",
+    "local_relocations",
+    "data_relocations",
+    "imported_symbols",
+    "exported_symbols",
+    "exported_symbols_hash",
+    "text",
+    "init",
+    "data",
+]
+SECTION_DIRECTORY_SIZE = len(SECTION_NAMES) * 8
+
+
+def parse_header(image):
+    return dict(zip(HEADER_FIELDS, struct.unpack_from(HEADER_FORMAT, image, 0)))
+
+
+def parse_section_directory(image):
+    entries = struct.unpack_from("<" + "II" * len(SECTION_NAMES), image, HEADER_SIZE)
+    return {
+        name: (entries[2 * i], entries[2 * i + 1]) for i, name in enumerate(SECTION_NAMES)
+    }
+
 
 class TestMkImage(unittest.TestCase):
     def test_validate_section(self):
@@ -21,8 +72,10 @@ class TestMkImage(unittest.TestCase):
             "verbose": True,
             "quiet": False,
             "dryrun": True,
-            "input": "executable_example.elf",
+            "input": str(Path(__file__).parent / "executable_example.elf"),
             "log": None,
+            "arch": "armv6-m",
+            "compress": [],
         }
 
         args = SimpleNamespace(**args)
@@ -86,56 +139,100 @@ class TestMkImage(unittest.TestCase):
         self.assertEqual(data, 0x278)
 
         self.assertEqual(len(app.exported_symbol_table), 1)
-        self.assertEqual(len(app.external_symbol_table), 0)
+        self.assertEqual(len(app.imported_symbol_table), 0)
 
         self.assertEqual(app.exported_symbol_table[0]["section"], SectionCode.Code)
         self.assertEqual(app.exported_symbol_table[0]["value"], 0x369)
         self.assertEqual(app.exported_symbol_table[0]["name"], "main")
 
-        data = struct.unpack_from("<4s", app.image, 0)[0]
-        self.assertEqual(data, bytes("YAFF", "utf-8"))
-        module_type = struct.unpack_from("<B", app.image, 4)[0]
-        self.assertEqual(module_type, 1)
-        arch_type = struct.unpack_from("<H", app.image, 5)[0]
-        self.assertEqual(arch_type, 1)
-        yasiff_version = struct.unpack_from("<B", app.image, 7)[0]
-        self.assertEqual(yasiff_version, 1)
-
-        code_length = struct.unpack_from("<I", app.image, 8)[0]
-        self.assertEqual(code_length, app.text_section["size"])
-        data_length = struct.unpack_from("<I", app.image, 12)[0]
-        self.assertEqual(data_length, app.data_section["size"])
-
-        bss_length = struct.unpack_from("<I", app.image, 16)[0]
-        self.assertEqual(bss_length, app.bss_section["size"])
-
-        external_libs = struct.unpack_from("<H", app.image, 20)[0]
-        self.assertEqual(external_libs, 0)
-
-        alignment = struct.unpack_from("<B", app.image, 22)[0]
-        self.assertEqual(alignment, 4)
-
-        _ = struct.unpack_from("<B", app.image, 23)[0]
-
-        version_major = struct.unpack_from("<H", app.image, 24)[0]
-        self.assertEqual(version_major, 0)
-
-        version_minor = struct.unpack_from("<H", app.image, 26)[0]
-        self.assertEqual(version_minor, 0)
-
-        external_rels = struct.unpack_from("<H", app.image, 28)[0]
-        self.assertEqual(external_rels, 0)
-        local_rels = struct.unpack_from("<H", app.image, 30)[0]
-        self.assertEqual(local_rels, 219)
-        data_rels = struct.unpack_from("<H", app.image, 32)[0]
-        self.assertEqual(data_rels, 18)
-        exported_rels = struct.unpack_from("<H", app.image, 34)[0]
-        self.assertEqual(exported_rels, 0)
-
-        exported_symbols = struct.unpack_from("<H", app.image, 36)[0]
-        self.assertEqual(exported_symbols, 1)
-        external_symbols = struct.unpack_from("<H", app.image, 38)[0]
-        self.assertEqual(external_symbols, 0)
+        header = parse_header(app.image)
+        self.assertEqual(header["cookie"], bytes("YAFF", "utf-8"))
+        self.assertEqual(header["module_type"], 1)
+        self.assertEqual(header["arch"], 1)
+        self.assertEqual(header["yasiff_version"], 2)
+
+        self.assertEqual(header["code_length"], app.text_section["size"])
+        self.assertEqual(header["init_length"], 0)
+        self.assertEqual(header["data_length"], app.data_section["size"])
+        self.assertEqual(header["bss_length"], app.bss_section["size"])
+        self.assertEqual(header["external_libraries"], 0)
+        self.assertEqual(header["alignment"], 4)
+        self.assertEqual(header["flags"], 0x03)
+        self.assertEqual(header["version_major"], 0)
+        self.assertEqual(header["version_minor"], 0)
+
+        self.assertEqual(header["symbol_table_relocations"], 0)
+        self.assertEqual(header["local_relocations"], 219)
+        self.assertEqual(header["data_relocations"], 18)
+        self.assertEqual(header["fini_arrays"], 0)
+
+        self.assertEqual(header["exported_symbols"], 1)
+        self.assertEqual(header["imported_symbols"], 0)
+
+        # directory follows header and describes every section placed after it
+        directory = parse_section_directory(app.image)
+        self.assertEqual(directory["name"], (HEADER_SIZE + SECTION_DIRECTORY_SIZE, 19))
+        previous_end = HEADER_SIZE + SECTION_DIRECTORY_SIZE
+        for name in SECTION_NAMES:
+            offset, size = directory[name]
+            self.assertGreaterEqual(offset, previous_end, name)
+            self.assertLessEqual(offset + size, len(app.image), name)
+            previous_end = offset + size
+
+        self.assertEqual(
+            app.image[directory["name"][0] :][: directory["name"][1]],
+            b"executable_example\0",
+        )
+        self.assertEqual(directory["imported_libraries"][1], 0)
+        self.assertEqual(directory["symbol_table_relocations"][1], 0)
+        self.assertEqual(directory["local_relocations"][1], 219 * 8)
+        self.assertEqual(directory["data_relocations"][1], 18 * 8)
+        self.assertEqual(directory["imported_symbols"][1], 0)
+        # symbol value followed by "main\0" padded to word
+        self.assertEqual(directory["exported_symbols"][1], 12)
+        # hash header, one bloom word, bucket, chain entry and symbol offset
+        self.assertEqual(directory["exported_symbols_hash"][1], 28)
+
+        text_offset, text_size = directory["text"]
+        self.assertEqual(text_offset % 16, 0)
+        self.assertEqual(text_size, app.text_section["size"])
+        self.assertEqual(app.image[text_offset : text_offset + text_size], app.text)
+        self.assertEqual(directory["init"][1], 0)
+        data_offset, data_size = directory["data"]
+        self.assertEqual(data_size, app.data_section["size"])
+        self.assertEqual(app.image[data_offset : data_offset + data_size], app.data)
+        self.assertEqual(data_offset + data_size, len(app.image))
+
+    def test_architecture_matches_arch_argument(self):
+        for arch, code in [("armv6-m", 1), ("armv7-m", 2), ("armv8-m.main", 3)]:
+            with self.subTest(arch=arch):
+                app = Application(
+                    SimpleNamespace(
+                        verbose=False,
+                        quiet=True,
+                        dryrun=True,
+                        input=str(Path(__file__).parent / "executable_example.elf"),
+                        log=None,
+                        arch=arch,
+                        compress=[],
+                    )
+                )
+                app.execute()
+                self.assertEqual(parse_header(app.image)["arch"], code)
+
+    def test_architecture_defaults_to_armv6m(self):
+        app = Application(
+            SimpleNamespace(
+                verbose=False,
+                quiet=True,
+                dryrun=True,
+                input=str(Path(__file__).parent / "executable_example.elf"),
+                log=None,
+                compress=[],
+            )
+        )
+        app.execute()
+        self.assertEqual(parse_header(app.image)["arch"], 1)
 
 
 if __name__ == "__main__":
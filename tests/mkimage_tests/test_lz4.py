@@ -0,0 +1,118 @@
+#!/usr/bin/python3
+
+import sys
+from pathlib import Path
+
+scripts_path = Path(__file__).parent.parent.parent / "mkimage"
+sys.path.append(str(scripts_path.absolute()))
+
+from types import SimpleNamespace
+
+from mkimage import Application, HeaderFlags
+
+import lz4
+
+import unittest
+
+from test_generate_image import parse_header, parse_section_directory
+
+example_elf = Path(__file__).parent / "executable_example.elf"
+
+
+def sequences(block):
+    # yields (position in decoded data, literals length, match length)
+    position = 0
+    decoded = 0
+    while position < len(block):
+        token = block[position]
+        position += 1
+        literals, position = lz4._read_length(block, position, token >> 4)
+        position += literals
+        if position == len(block):
+            yield decoded, literals, 0
+            return
+        position += 2
+        match, position = lz4._read_length(block, position, token & 0x0F)
+        match += lz4.MIN_MATCH
+        yield decoded, literals, match
+        decoded += literals + match
+
+
+def pseudo_random(size, seed):
+    data = bytearray()
+    for _ in range(size):
+        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+        data.append(seed >> 16 & 0xFF)
+    return bytes(data)
+
+
+class TestLz4(unittest.TestCase):
+    def inputs(self):
+        with open(example_elf, "rb") as file:
+            elf = file.read()
+        return [
+            b"",
+            b"yasld",
+            bytes([0xAA] * 600),
+            bytes(i % 37 for i in range(1000)),
+            bytes((i * 7 + i // 3) & 0xFF for i in range(300)) + bytes(20) * 40,
+            elf,
+        ]
+
+    def test_round_trip(self):
+        for data in self.inputs():
+            with self.subTest(size=len(data)):
+                self.assertEqual(lz4.decompress(lz4.compress(data)), data)
+
+    def test_follow_block_end_conditions(self):
+        for data in self.inputs():
+            with self.subTest(size=len(data)):
+                parsed = list(sequences(lz4.compress(data)))
+                self.assertEqual(parsed[-1][2], 0)
+                if len(data) >= lz4.LAST_LITERALS:
+                    self.assertGreaterEqual(parsed[-1][1], lz4.LAST_LITERALS)
+                for decoded, literals, match in parsed[:-1]:
+                    self.assertLessEqual(
+                        decoded + literals, len(data) - lz4.MATCH_FIND_LIMIT
+                    )
+
+    def test_compress_matches(self):
+        data = bytes(i % 37 for i in range(1000))
+        self.assertLess(len(lz4.compress(data)), len(data) // 4)
+
+    def test_not_use_match_further_than_maximal_offset(self):
+        block = pseudo_random(512, 1)
+        filler = pseudo_random(lz4.MAX_OFFSET, 2)
+        data = block + filler + block
+        self.assertEqual(lz4.decompress(lz4.compress(data)), data)
+        for decoded, literals, match in sequences(lz4.compress(data)):
+            self.assertFalse(match and decoded + literals >= len(block) + len(filler))
+
+    def test_compressed_image_sections_decode_to_sections(self):
+        app = Application(
+            SimpleNamespace(
+                verbose=False,
+                quiet=True,
+                dryrun=True,
+                input=str(example_elf),
+                log=None,
+                compress=["text", "data"],
+            )
+        )
+        app.execute()
+        header = parse_header(app.image)
+        directory = parse_section_directory(app.image)
+        self.assertTrue(header["flags"] & HeaderFlags.CompressedText)
+        self.assertTrue(header["flags"] & HeaderFlags.CompressedData)
+
+        offset, size = directory["text"]
+        self.assertLess(size, header["code_length"])
+        self.assertEqual(lz4.decompress(app.image[offset : offset + size]), app.text)
+
+        offset, size = directory["data"]
+        self.assertLess(size, header["data_length"])
+        self.assertEqual(lz4.decompress(app.image[offset : offset + size]), app.data)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,270 @@
+#!/usr/bin/python3
+
+import sys
+from pathlib import Path
+
+scripts_path = Path(__file__).parent.parent.parent / "mkimage"
+sys.path.append(str(scripts_path.absolute()))
+
+from types import SimpleNamespace
+from unittest import mock
+
+import mkimage
+from mkimage import Application
+from symbol_hash import BLOOM_SHIFT, EMPTY_BUCKET, symbol_hash
+
+import unittest
+
+import struct
+
+from test_generate_image import parse_header, parse_section_directory
+
+TEXT_INDEX = 1
+DATA_INDEX = 2
+BSS_INDEX = 3
+
+EXPORTED = ["library_function_{}".format(i) for i in range(20)] + [
+    "a",
+    "sum",
+    "process",
+    "_ZN1a1b1c11process_strERKSt17basic_string_viewIcSt11char_traitsIcEES7_",
+]
+IMPORTED = ["puts", "printf", "strlen", "abort"]
+
+
+def symbol(name, value, section_index):
+    return {
+        "type": "STT_FUNC",
+        "binding": "STB_GLOBAL",
+        "name": name,
+        "value": value,
+        "size": 4,
+        "section_index": section_index,
+        "visibility": "STV_DEFAULT",
+    }
+
+
+def section(name, address, size, index):
+    return {
+        "name": name,
+        "address": address,
+        "type": "SHT_PROGBITS",
+        "size": size,
+        "data": bytes(size),
+        "index": index,
+    }
+
+
+def got_relocation(offset, name):
+    return {
+        "offset": offset,
+        "info": 0,
+        "info_type": "R_ARM_GOT_BREL",
+        "symbol": 0,
+        "symbol_name": name,
+        "symbol_value": 0,
+        "section_index": TEXT_INDEX,
+    }
+
+
+# ELF parser replacement with shared library exporting EXPORTED symbols and
+# importing IMPORTED ones, relocations use imports in reversed order
+def create_elf():
+    text_size = 4 * len(EXPORTED) + 64
+    symbols = {}
+    for i, name in enumerate(EXPORTED):
+        symbols[name] = symbol(name, 4 * i + 1, TEXT_INDEX)
+    for name in IMPORTED:
+        symbols[name] = symbol(name, 0, "SHN_UNDEF")
+
+    relocations = []
+    for i, name in enumerate(reversed(IMPORTED)):
+        relocations.append(got_relocation(4 * len(EXPORTED) + 4 * i, name))
+    # second use of import shares LOT entry
+    relocations.append(got_relocation(text_size - 4, IMPORTED[-1]))
+
+    sections = {
+        ".text": section(".text", 0, text_size, TEXT_INDEX),
+        ".data": section(".data", text_size, 8, DATA_INDEX),
+        ".bss": section(".bss", text_size + 8, 16, BSS_INDEX),
+    }
+    names = {s["index"]: s["name"] for s in sections.values()}
+
+    return SimpleNamespace(
+        symbols=symbols,
+        sections=sections,
+        relocations=relocations,
+        executable=False,
+        entry=0,
+        get_section_name=names.get,
+    )
+
+
+def build_library():
+    app = Application(
+        SimpleNamespace(
+            verbose=False,
+            quiet=True,
+            dryrun=True,
+            input="synthetic_library.elf",
+            log=None,
+            type="shared_library",
+        )
+    )
+    with mock.patch.object(mkimage, "ElfParser", return_value=create_elf()):
+        app.execute()
+    return app
+
+
+def section_data(image, directory, name):
+    offset, size = directory[name]
+    return image[offset : offset + size]
+
+
+def parse_symbol_table(table):
+    # returns (offset of entry, value, name) for each symbol
+    symbols = []
+    offset = 0
+    while offset < len(table):
+        value = struct.unpack_from("<I", table, offset)[0]
+        end = table.index(0, offset + 4)
+        symbols.append((offset, value, table[offset + 4 : end].decode("ascii")))
+        offset = (end + 4) & ~3
+    return symbols
+
+
+def parse_hash_table(table, number_of_symbols):
+    number_of_buckets, bloom_size, bloom_shift = struct.unpack_from("<III", table)
+    words = struct.unpack_from(
+        "<{}I".format(bloom_size + number_of_buckets + 2 * number_of_symbols),
+        table,
+        12,
+    )
+    chain_start = bloom_size + number_of_buckets
+    return SimpleNamespace(
+        number_of_buckets=number_of_buckets,
+        bloom_size=bloom_size,
+        bloom_shift=bloom_shift,
+        bloom=words[:bloom_size],
+        buckets=words[bloom_size:chain_start],
+        chain=words[chain_start : chain_start + number_of_symbols],
+        offsets=words[chain_start + number_of_symbols :],
+    )
+
+
+# same lookup as SymbolHashTable::find
+def find(table, symbols, name):
+    h = symbol_hash(name)
+    word = table.bloom[(h // 32) & (table.bloom_size - 1)]
+    mask = (1 << (h % 32)) | (1 << ((h >> table.bloom_shift) % 32))
+    if word & mask != mask:
+        return None
+    index = table.buckets[h % table.number_of_buckets]
+    if index == EMPTY_BUCKET:
+        return None
+    entries = {offset: entry_name for offset, _, entry_name in symbols}
+    while index < len(symbols):
+        if table.chain[index] | 1 == h | 1 and entries[table.offsets[index]] == name:
+            return index
+        if table.chain[index] & 1:
+            break
+        index += 1
+    return None
+
+
+class TestSymbolTables(unittest.TestCase):
+    def setUp(self):
+        self.app = build_library()
+        self.header = parse_header(self.app.image)
+        self.directory = parse_section_directory(self.app.image)
+
+    def test_hash_name_as_dl_new_hash(self):
+        self.assertEqual(symbol_hash(""), 5381)
+        self.assertEqual(symbol_hash("a"), 5381 * 33 + ord("a"))
+        self.assertEqual(symbol_hash("printf"), 0x156B2BB8)
+
+    def test_build_exported_symbols_hash(self):
+        self.assertEqual(self.header["module_type"], 2)
+        self.assertTrue(self.header["flags"] & mkimage.HeaderFlags.ExportedSymbolsHash)
+        self.assertEqual(self.header["exported_symbols"], len(EXPORTED))
+
+        symbols = parse_symbol_table(
+            section_data(self.app.image, self.directory, "exported_symbols")
+        )
+        self.assertEqual(sorted(name for _, _, name in symbols), sorted(EXPORTED))
+
+        hash_section = section_data(
+            self.app.image, self.directory, "exported_symbols_hash"
+        )
+        table = parse_hash_table(hash_section, len(symbols))
+        self.assertEqual(table.number_of_buckets, len(EXPORTED) // 2)
+        self.assertEqual(table.bloom_size, 4)
+        self.assertEqual(table.bloom_shift, BLOOM_SHIFT)
+        self.assertEqual(
+            len(hash_section),
+            12 + 4 * (table.bloom_size + table.number_of_buckets + 2 * len(symbols)),
+        )
+
+        # symbols from one bucket are adjacent and buckets are ordered
+        buckets = [symbol_hash(name) % table.number_of_buckets for _, _, name in symbols]
+        self.assertEqual(buckets, sorted(buckets))
+
+        for bucket in range(table.number_of_buckets):
+            expected = buckets.index(bucket) if bucket in buckets else EMPTY_BUCKET
+            self.assertEqual(table.buckets[bucket], expected)
+
+        for index, (offset, _, name) in enumerate(symbols):
+            h = symbol_hash(name)
+            is_last = index + 1 == len(symbols) or buckets[index + 1] != buckets[index]
+            self.assertEqual(table.chain[index], (h & ~1) | is_last)
+            self.assertEqual(table.offsets[index], offset)
+
+            word = table.bloom[(h // 32) & (table.bloom_size - 1)]
+            self.assertTrue(word & (1 << (h % 32)))
+            self.assertTrue(word & (1 << ((h >> BLOOM_SHIFT) % 32)))
+
+    def test_find_exported_symbols_through_hash(self):
+        symbols = parse_symbol_table(
+            section_data(self.app.image, self.directory, "exported_symbols")
+        )
+        table = parse_hash_table(
+            section_data(self.app.image, self.directory, "exported_symbols_hash"),
+            len(symbols),
+        )
+        for index, (_, value, name) in enumerate(symbols):
+            self.assertEqual(find(table, symbols, name), index)
+            self.assertEqual(value >> 2, 4 * EXPORTED.index(name) + 1)
+
+        for name in IMPORTED + ["library_function_20", "sum_", ""]:
+            self.assertIsNone(find(table, symbols, name))
+
+    def test_sort_symbol_table_relocations_by_symbol_index(self):
+        self.assertEqual(self.header["imported_symbols"], len(IMPORTED))
+        self.assertEqual(self.header["symbol_table_relocations"], len(IMPORTED))
+
+        imported = parse_symbol_table(
+            section_data(self.app.image, self.directory, "imported_symbols")
+        )
+        self.assertEqual([name for _, _, name in imported], IMPORTED)
+
+        table = section_data(self.app.image, self.directory, "symbol_table_relocations")
+        relocations = list(struct.iter_unpack("<II", table))
+        self.assertEqual(len(relocations), len(IMPORTED))
+
+        # LOT indexes are assigned in order of use, reversed to symbol table
+        symbol_indexes = [symbol_index for _, symbol_index in relocations]
+        self.assertEqual(symbol_indexes, sorted(symbol_indexes))
+        self.assertEqual(symbol_indexes, list(range(len(IMPORTED))))
+        lot_indexes = [lot_index for lot_index, _ in relocations]
+        self.assertEqual(lot_indexes, sorted(lot_indexes, reverse=True))
+
+        # each relocation still binds LOT entry used by code to its symbol
+        for lot_index, symbol_index in relocations:
+            offset = 4 * len(EXPORTED) + 4 * (len(IMPORTED) - 1 - symbol_index)
+            self.assertEqual(
+                struct.unpack_from("<I", self.app.text, offset)[0], 4 * lot_index
+            )
+
+
+if __name__ == "__main__":
+    unittest.main()
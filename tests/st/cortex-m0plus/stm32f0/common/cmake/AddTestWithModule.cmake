@@ -73,6 +73,9 @@ macro(add_test_with_module)
   target_sources(${TEST_NAME} PRIVATE ${TEST_SOURCES})
 
   target_link_libraries(${TEST_NAME} PRIVATE ${TEST_LIBRARIES} yasld yasld_arch)
+  # libopencm3 names supervisor call vector sv_call_handler
+  target_link_options(${TEST_NAME} PRIVATE -Wl,--undefined=SVC_Handler
+                      -Wl,--defsym=sv_call_handler=SVC_Handler)
 
   if(NOT DEFINED TEST_LAYOUT)
     add_custom_command(
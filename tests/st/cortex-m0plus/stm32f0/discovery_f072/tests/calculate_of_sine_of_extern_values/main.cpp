@@ -56,16 +56,23 @@ int main(int argc, char *argv[])
       free(ptr);
     });
 
-  const yasld::StaticEnvironment environment{
-    yasld::SymbolEntry{"printf",                    &printf               },
-    yasld::SymbolEntry{ "__aeabi_f2d",              &__aeabi_f2d          },
-    yasld::SymbolEntry{ "_Z19get_values_for_testv", &provide_data_for_test},
-    yasld::SymbolEntry{ "__aeabi_fadd",             &__aeabi_fadd         },
-    yasld::SymbolEntry{ "__aeabi_f2iz",             &__aeabi_f2iz         },
-    yasld::SymbolEntry{ "sinf",                     &sinf                 },
-    yasld::SymbolEntry{ "__aeabi_fmul",             &__aeabi_fmul         },
+  const yasld::SymbolEntry symbols[] = {
+    yasld::SymbolEntry{ "_Z19get_values_for_testv", &provide_data_for_test },
+    yasld::SymbolEntry{ "__aeabi_f2d", &__aeabi_f2d },
+    yasld::SymbolEntry{ "__aeabi_f2iz", &__aeabi_f2iz },
+    yasld::SymbolEntry{ "__aeabi_fadd", &__aeabi_fadd },
+    yasld::SymbolEntry{ "__aeabi_fmul", &__aeabi_fmul },
+    yasld::SymbolEntry{ "printf", &printf },
+    yasld::SymbolEntry{ "sinf", &sinf },
   };
-  loader.set_environment(environment);
+  const yasld::StaticEnvironment environment{ symbols };
+  if (!loader.set_environment(environment))
+  {
+    printf("[host] Environment rejected\n");
+    while (true)
+    {
+    }
+  }
 
   void *module     = reinterpret_cast<void *>(0x08013000);
   auto  executable = loader.load_executable(module);
@@ -32,27 +32,8 @@
 #include "yasld/arch.hpp"
 #include "yasld/supervisor_call.hpp"
 
-yasld::Loader *l;
-
 extern "C"
 {
-  void __attribute__((noinline))
-  sv_call_handler(std::size_t svc_id, std::size_t *args)
-  {
-    switch (svc_id)
-    {
-    case 10:
-    {
-      process_entry_supervisor_call(l, args);
-    }
-    break;
-    case 11:
-    {
-      process_exit_supervisor_call(l, args);
-    }
-    break;
-    };
-  }
   signed __aeabi_idiv(signed numerator, signed denominator);
 }
 
@@ -63,12 +44,13 @@ int main(int argc, char *argv[])
   board_init();
   puts("[host] STM32F0 Discovery Board started!");
 
-  const yasld::StaticEnvironment environment{
-    yasld::SymbolEntry{"printf",        &printf      },
-    yasld::SymbolEntry{ "puts",         &puts        },
-    yasld::SymbolEntry{ "strlen",       &strlen      },
-    yasld::SymbolEntry{ "__aeabi_idiv", &__aeabi_idiv}
+  const yasld::SymbolEntry symbols[] = {
+    yasld::SymbolEntry{ "__aeabi_idiv", &__aeabi_idiv },
+    yasld::SymbolEntry{ "printf", &printf },
+    yasld::SymbolEntry{ "puts", &puts },
+    yasld::SymbolEntry{ "strlen", &strlen },
   };
+  const yasld::StaticEnvironment environment{ symbols };
 
   yasld::Loader loader(
     [](std::size_t size, yasld::AllocationType)
@@ -79,9 +61,15 @@ int main(int argc, char *argv[])
     {
       free(ptr);
     });
-  l = &loader;
+  yasld::set_supervisor_call_loader(loader);
 
-  loader.set_environment(environment);
+  if (!loader.set_environment(environment))
+  {
+    printf("[host] Environment rejected\n");
+    while (true)
+    {
+    }
+  }
 
   void *module  = reinterpret_cast<void *>(0x08013000);
   auto  library = loader.load_library(module);
@@ -32,9 +32,10 @@ int main(int argc, char *argv[])
   board_init();
   puts("[host] STM32F0 Discovery Board started!");
 
-  const yasld::StaticEnvironment environment{
-    yasld::SymbolEntry{"printf", &printf}
+  const yasld::SymbolEntry symbols[] = {
+    yasld::SymbolEntry{ "printf", &printf },
   };
+  const yasld::StaticEnvironment environment{ symbols };
 
   yasld::Loader loader(
     [](std::size_t size, yasld::AllocationType)
@@ -46,7 +47,13 @@ int main(int argc, char *argv[])
       free(ptr);
     });
 
-  loader.set_environment(environment);
+  if (!loader.set_environment(environment))
+  {
+    printf("[host] Environment rejected\n");
+    while (true)
+    {
+    }
+  }
 
   void *module     = reinterpret_cast<void *>(0x08013000);
   auto  executable = loader.load_executable(module);
@@ -42,10 +42,17 @@ int main(int argc, char *argv[])
       free(ptr);
     });
 
-  const yasld::StaticEnvironment environment{
-    yasld::SymbolEntry{"printf", &printf}
+  const yasld::SymbolEntry symbols[] = {
+    yasld::SymbolEntry{ "printf", &printf },
   };
-  loader.set_environment(environment);
+  const yasld::StaticEnvironment environment{ symbols };
+  if (!loader.set_environment(environment))
+  {
+    printf("[host] Environment rejected\n");
+    while (true)
+    {
+    }
+  }
 
   void *module     = reinterpret_cast<void *>(0x08013000);
   auto  executable = loader.load_executable(module);
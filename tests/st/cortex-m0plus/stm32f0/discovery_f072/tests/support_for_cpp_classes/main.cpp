@@ -78,18 +78,20 @@ int main(int argc, char *argv[])
   board_init();
   puts("[host] STM32F0 Discovery Board started!");
 
-  const yasld::StaticEnvironment environment{
+  const yasld::SymbolEntry symbols[] = {
+    yasld::SymbolEntry{ "_ZN22ExternalImplementation3sumEv", &sum_wrapper },
+    yasld::SymbolEntry{ "_ZN22ExternalImplementationC1ESt17basic_string_"
+                        "viewIcSt11char_traitsIcEEii",
+                        &create_external_implementation },
+    yasld::SymbolEntry{
+      "_ZdlPvj", static_cast<void (*)(void *, size_t)>(&operator delete) },
+    yasld::SymbolEntry{ "_Znwj",
+                        static_cast<void *(*)(size_t)>(&operator new) },
     yasld::SymbolEntry{ "printf", &printf },
     yasld::SymbolEntry{ "puts", &puts },
-    yasld::SymbolEntry{ "_Znwj",
-                       static_cast<void *(*)(size_t)>(&operator new) },
     yasld::SymbolEntry{ "strlen", &strlen },
-    yasld::SymbolEntry{
-                       "_ZdlPvj", static_cast<void (*)(void *, size_t)>(&operator delete) },
-    yasld::SymbolEntry{ "_ZN22ExternalImplementationC1ESt17basic_string_"
-                        "viewIcSt11char_traitsIcEEii", &create_external_implementation },
-    yasld::SymbolEntry{ "_ZN22ExternalImplementation3sumEv", &sum_wrapper },
   };
+  const yasld::StaticEnvironment environment{ symbols };
 
   yasld::Loader loader(
     [](std::size_t size, yasld::AllocationType)
@@ -101,7 +103,13 @@ int main(int argc, char *argv[])
       free(ptr);
     });
 
-  loader.set_environment(environment);
+  if (!loader.set_environment(environment))
+  {
+    printf("[host] Environment rejected\n");
+    while (true)
+    {
+    }
+  }
 
   void *module     = reinterpret_cast<void *>(0x08013000);
   auto  executable = loader.load_executable(module);
@@ -40,7 +40,7 @@ int            main(int argc, char *argv[])
   board_init();
   puts("[host] STM32F0 Nucleo Board started!");
 
-  const yasld::StaticEnvironment environment{};
+  const yasld::StaticEnvironment environment{ {} };
 
   yasld::Loader                  loader(
     [](std::size_t size, yasld::AllocationType)
@@ -53,7 +53,13 @@ int            main(int argc, char *argv[])
     });
   l = &loader;
 
-  loader.set_environment(environment);
+  if (!loader.set_environment(environment))
+  {
+    printf("[host] Environment rejected\n");
+    while (true)
+    {
+    }
+  }
 
   void *module = reinterpret_cast<void *>(0x08013000);
   auto  exec   = loader.load_executable(module);
@@ -33,27 +33,8 @@
 
 #include "globals.h"
 
-yasld::Loader *l;
-
 extern "C"
 {
-  void __attribute__((noinline))
-  sv_call_handler(std::size_t svc_id, std::size_t *args)
-  {
-    switch (svc_id)
-    {
-    case 10:
-    {
-      process_entry_supervisor_call(l, args);
-    }
-    break;
-    case 11:
-    {
-      process_exit_supervisor_call(l, args);
-    }
-    break;
-    };
-  }
   signed  __aeabi_idiv(signed numerator, signed denominator);
 
   ssize_t _write(int fd, const char *buf, size_t count);
@@ -77,9 +58,10 @@ int main(int argc, char *argv[])
   init_baselibc_stdout();
   puts("[host] STM32F0 Nucleo Board started!");
 
-  const yasld::StaticEnvironment environment{
-    yasld::SymbolEntry{"stdout", &stdout_file}
+  const yasld::SymbolEntry symbols[] = {
+    yasld::SymbolEntry{ "stdout", &stdout_file },
   };
+  const yasld::StaticEnvironment environment{ symbols };
 
   yasld::Loader loader(
     [](std::size_t size, yasld::AllocationType)
@@ -90,10 +72,16 @@ int main(int argc, char *argv[])
     {
       free(ptr);
     });
-  l = &loader;
+  yasld::set_supervisor_call_loader(loader);
 
   loader.register_file_resolver(&resolver);
-  loader.set_environment(environment);
+  if (!loader.set_environment(environment))
+  {
+    printf("[host] Environment rejected\n");
+    while (true)
+    {
+    }
+  }
 
   void *module = reinterpret_cast<void *>(0x08013000);
   auto  exec   = loader.load_executable(module);
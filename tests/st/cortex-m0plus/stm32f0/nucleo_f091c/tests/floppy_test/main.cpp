@@ -37,28 +37,8 @@
 
 #include "globals.h"
 
-yasld::Loader *l;
-
 extern "C"
 {
-  void __attribute__((noinline))
-  sv_call_handler(std::size_t svc_id, std::size_t *args)
-  {
-    switch (svc_id)
-    {
-    case 10:
-    {
-      yasld::process_entry_supervisor_call(l, args);
-    }
-    break;
-    case 11:
-    {
-      yasld::process_exit_supervisor_call(l, args);
-    }
-    break;
-    };
-  }
-
   void do_stupid_things(const char *prefix)
   {
     printf("%s: is doing stupid things\n", prefix);
@@ -139,12 +119,13 @@ int main(int argc, char *argv[])
   init_baselibc_stdout();
   puts("[host] STM32F0 Nucleo Board started!");
 
-  const yasld::StaticEnvironment environment{
-    yasld::SymbolEntry{"stdout",              &stdout_file       },
-    yasld::SymbolEntry{ "do_stupid_things",   &do_stupid_things  },
-    yasld::SymbolEntry{ "greet_youtube_fans", &greet_youtube_fans},
-    yasld::SymbolEntry{ "sleep",              &sleep             }
+  const yasld::SymbolEntry symbols[] = {
+    yasld::SymbolEntry{ "do_stupid_things", &do_stupid_things },
+    yasld::SymbolEntry{ "greet_youtube_fans", &greet_youtube_fans },
+    yasld::SymbolEntry{ "sleep", &sleep },
+    yasld::SymbolEntry{ "stdout", &stdout_file },
   };
+  const yasld::StaticEnvironment environment{ symbols };
 
   yasld::Loader loader(
     [](std::size_t size, yasld::AllocationType)
@@ -155,10 +136,16 @@ int main(int argc, char *argv[])
     {
       free(ptr);
     });
-  l = &loader;
+  yasld::set_supervisor_call_loader(loader);
 
   loader.register_file_resolver(&resolver);
-  loader.set_environment(environment);
+  if (!loader.set_environment(environment))
+  {
+    printf("[host] Environment rejected\n");
+    while (true)
+    {
+    }
+  }
 
   void *module   = reinterpret_cast<void *>(0x08013000);
   auto  exec     = loader.load_executable(module);
@@ -0,0 +1,101 @@
+/**
+ * main.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "board_init.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include <yasld/environment.hpp>
+#include <yasld/loader.hpp>
+
+#include "yasld/supervisor_call.hpp"
+
+int main(int argc, char *argv[])
+{
+  static_cast<void>(argc);
+  static_cast<void>(argv);
+  board_init();
+  puts("[host] STM32F4 Discovery Board started!");
+
+  const yasld::SymbolEntry symbols[] = {
+    yasld::SymbolEntry{ "printf", &printf },
+    yasld::SymbolEntry{ "puts", &puts },
+    yasld::SymbolEntry{ "strlen", &strlen },
+  };
+  const yasld::StaticEnvironment environment{ symbols };
+
+  yasld::Loader loader(
+    [](std::size_t size, yasld::AllocationType)
+    {
+      return malloc(size);
+    },
+    [](void *ptr)
+    {
+      free(ptr);
+    });
+  yasld::set_supervisor_call_loader(loader);
+
+  if (!loader.set_environment(environment))
+  {
+    printf("[host] Environment rejected\n");
+    while (true)
+    {
+    }
+  }
+
+  void *module  = reinterpret_cast<void *>(0x08020000);
+  auto  library = loader.load_library(module);
+  if (!library)
+  {
+    printf("[host] Loading failed\n");
+    while (true)
+    {
+    }
+  }
+
+  printf("[host] Module loaded\n");
+  auto sum = yasld::SymbolGet<int(int, int)>::get_symbol(**library, "_Z3sumii");
+  auto str = yasld::SymbolGet<std::string_view(
+    const std::string_view &, const std::string_view &)>::
+    get_symbol(
+      **library,
+      "_ZN1a1b1c11process_strERKSt17basic_string_viewIcSt11char_"
+      "traitsIcEES7_");
+  // fifth argument is passed on stack through Thumb-2 wrapper
+  auto c_fun = yasld::SymbolGet<int(int, int, int, int, int)>::get_symbol(
+    **library, "c_fun");
+  if (!sum || !str || !c_fun)
+  {
+    printf("[host] Symbol not found\n");
+    while (true)
+    {
+    }
+  }
+
+  printf("[host][sum] Sum is: %d\n", sum(15, 22));
+  printf("[host][process_str] Str is: %s\n", str("hello", "elo").data());
+  printf("[host][c_fun] Calculated: %d\n", c_fun(1, 10, 20, 30, 5));
+  printf("[host] TEST SUCCESS\n");
+  while (true)
+  {
+  }
+}
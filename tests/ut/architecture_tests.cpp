@@ -0,0 +1,86 @@
+/**
+ * architecture_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "yasld/arch.hpp"
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+
+namespace yasld
+{
+
+class LoaderArchitectureShould : public test::LoaderFixture
+{
+protected:
+  static test::Image build_executable(Header::Architecture arch)
+  {
+    return test::ImageBuilder("executable", Header::Type::Executable)
+      .add_export("main", 0)
+      .set_architecture(arch)
+      .build();
+  }
+};
+
+TEST_F(LoaderArchitectureShould, AcceptImagesForOlderArchitecture)
+{
+  const auto image = build_executable(Header::Architecture::Armv6_m);
+  EXPECT_TRUE(loader_.load_executable(image.data()));
+}
+
+TEST_F(LoaderArchitectureShould, AcceptImagesForSameArchitecture)
+{
+  const auto image = build_executable(architecture);
+  EXPECT_TRUE(loader_.load_executable(image.data()));
+}
+
+TEST_F(LoaderArchitectureShould, RejectImagesForUnknownArchitecture)
+{
+  const auto image = build_executable(Header::Architecture::Unknown);
+  EXPECT_FALSE(loader_.load_executable(image.data()));
+}
+
+TEST_F(LoaderArchitectureShould, RejectImagesForNewerArchitecture)
+{
+  const auto image = build_executable(static_cast<Header::Architecture>(
+    static_cast<uint16_t>(architecture) + 1));
+  EXPECT_FALSE(loader_.load_executable(image.data()));
+}
+
+TEST_F(LoaderArchitectureShould, RejectLibrariesForNewerArchitecture)
+{
+  add_image(
+    "libfoo",
+    test::ImageBuilder("libfoo", Header::Type::Library)
+      .add_export("foo", 4)
+      .set_architecture(static_cast<Header::Architecture>(
+        static_cast<uint16_t>(architecture) + 1))
+      .build());
+  const auto image = test::ImageBuilder("executable", Header::Type::Executable)
+                       .add_dependency("libfoo")
+                       .add_import("foo")
+                       .add_export("main", 0)
+                       .build();
+  EXPECT_FALSE(loader_.load_executable(image.data()));
+}
+
+} // namespace yasld
@@ -0,0 +1,235 @@
+/**
+ * call_context_stack_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/call_context_stack.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "yasld/loader.hpp"
+#include "yasld/module.hpp"
+
+#include "image_builder.hpp"
+
+namespace yasld
+{
+
+class CallContextStackShould : public ::testing::Test
+{
+public:
+  CallContextStackShould()
+    : sut_{ 3 }
+  {
+    YasldAllocatorHolder::get().set_allocator(
+      [this](std::size_t size, AllocationType type)
+      {
+        allocations_.push_back(type);
+        return fail_allocation_ ? nullptr : std::malloc(size);
+      });
+    YasldAllocatorHolder::get().set_release(
+      [](void *ptr)
+      {
+        std::free(ptr);
+      });
+  }
+
+  ~CallContextStackShould() override
+  {
+    // allocator must not outlive fixture it refers to
+    YasldAllocatorHolder::get().set_allocator(
+      [](std::size_t size, AllocationType)
+      {
+        return std::malloc(size);
+      });
+  }
+
+protected:
+  std::vector<AllocationType> allocations_;
+  bool                        fail_allocation_ = false;
+  Module                      first_;
+  Module                      second_;
+  CallContextStack            sut_;
+};
+
+TEST_F(CallContextStackShould, AllocateCapacityBeforePush)
+{
+  EXPECT_TRUE(allocations_.empty());
+  EXPECT_TRUE(sut_.allocate());
+  EXPECT_EQ(allocations_, std::vector{ AllocationType::CallContext });
+  EXPECT_TRUE(sut_.push(first_, {}));
+  EXPECT_TRUE(sut_.push(second_, {}));
+  EXPECT_TRUE(sut_.push(first_, {}));
+  EXPECT_EQ(allocations_, std::vector{ AllocationType::CallContext });
+}
+
+TEST_F(CallContextStackShould, RejectPushWithoutAllocation)
+{
+  EXPECT_FALSE(sut_.push(first_, {}));
+  EXPECT_TRUE(allocations_.empty());
+  EXPECT_TRUE(sut_.empty());
+}
+
+TEST_F(CallContextStackShould, PopCallersInReverseOrder)
+{
+  ASSERT_TRUE(sut_.allocate());
+  EXPECT_TRUE(sut_.push(first_, {}));
+  EXPECT_TRUE(sut_.push(second_, {}));
+  EXPECT_EQ(sut_.size(), 2);
+
+  auto entry = sut_.pop();
+  ASSERT_TRUE(entry);
+  EXPECT_EQ(entry->module, &second_);
+  entry = sut_.pop();
+  ASSERT_TRUE(entry);
+  EXPECT_EQ(entry->module, &first_);
+  EXPECT_TRUE(sut_.empty());
+  EXPECT_FALSE(sut_.pop());
+}
+
+TEST_F(CallContextStackShould, KeepModuleUntilLastEntryPopped)
+{
+  ASSERT_TRUE(sut_.allocate());
+  EXPECT_TRUE(sut_.push(first_, {}));
+  EXPECT_TRUE(sut_.push(second_, {}));
+  EXPECT_TRUE(sut_.push(first_, {}));
+
+  sut_.pop();
+  EXPECT_TRUE(sut_.contains(first_));
+  EXPECT_TRUE(sut_.contains(second_));
+  sut_.pop();
+  EXPECT_TRUE(sut_.contains(first_));
+  EXPECT_FALSE(sut_.contains(second_));
+  sut_.pop();
+  EXPECT_FALSE(sut_.contains(first_));
+}
+
+TEST_F(CallContextStackShould, RejectPushBeyondCapacity)
+{
+  ASSERT_TRUE(sut_.allocate());
+  for (std::size_t i = 0; i < sut_.capacity(); ++i)
+  {
+    EXPECT_TRUE(sut_.push(first_, {}));
+  }
+  EXPECT_FALSE(sut_.push(second_, {}));
+  EXPECT_EQ(sut_.size(), sut_.capacity());
+  EXPECT_FALSE(sut_.contains(second_));
+}
+
+TEST_F(CallContextStackShould, RejectPushWhenAllocationFails)
+{
+  fail_allocation_ = true;
+  EXPECT_FALSE(sut_.allocate());
+  EXPECT_FALSE(sut_.push(first_, {}));
+  EXPECT_TRUE(sut_.empty());
+}
+
+class LoaderTasksShould : public ::testing::Test
+{
+public:
+  LoaderTasksShould()
+    : loader_{ [](std::size_t size, AllocationType)
+               {
+                 return std::malloc(size);
+               },
+               [](void *ptr)
+               {
+                 std::free(ptr);
+               } }
+    , image_{ test::ImageBuilder("executable", Header::Type::Executable)
+                .add_export("main", 0)
+                .set_data_size(16, 0)
+                .build() }
+    , executable_{ loader_.load_executable(image_.data()) }
+  {
+  }
+
+protected:
+  std::size_t data() const
+  {
+    return reinterpret_cast<std::size_t>((*executable_)->get_data().data());
+  }
+
+  Loader                                    loader_;
+  test::Image                               image_;
+  std::optional<Loader::ObservedExecutable> executable_;
+};
+
+TEST_F(LoaderTasksShould, FindActiveModuleOfRunningTask)
+{
+  ASSERT_TRUE(executable_);
+  EXPECT_TRUE(loader_.add_task(1));
+  EXPECT_TRUE(loader_.add_task(2));
+
+  EXPECT_TRUE(loader_.on_task_switch(1));
+  EXPECT_TRUE(loader_.get_call_context_stack().push(**executable_, {}));
+  EXPECT_EQ(loader_.find_active_module(data()), &**executable_);
+
+  EXPECT_TRUE(loader_.on_task_switch(2));
+  EXPECT_EQ(loader_.find_active_module(data()), nullptr);
+  EXPECT_TRUE((*executable_)->get_active());
+
+  EXPECT_TRUE(loader_.on_task_switch(1));
+  EXPECT_TRUE(loader_.get_call_context_stack().pop());
+  EXPECT_EQ(loader_.find_active_module(data()), nullptr);
+  EXPECT_FALSE((*executable_)->get_active());
+}
+
+TEST_F(LoaderTasksShould, KeepStackOfRunningTaskWhenTasksChange)
+{
+  ASSERT_TRUE(executable_);
+  EXPECT_TRUE(loader_.add_task(5));
+  EXPECT_TRUE(loader_.on_task_switch(5));
+  EXPECT_TRUE(loader_.get_call_context_stack().push(**executable_, {}));
+
+  EXPECT_TRUE(loader_.add_task(1));
+  EXPECT_TRUE(loader_.add_task(3));
+  loader_.remove_task(1);
+  EXPECT_EQ(loader_.get_call_context_stack().size(), 1);
+  EXPECT_EQ(loader_.find_active_module(data()), &**executable_);
+  loader_.get_call_context_stack().pop();
+}
+
+TEST_F(LoaderTasksShould, LeaveModulesOfRemovedTask)
+{
+  ASSERT_TRUE(executable_);
+  EXPECT_TRUE(loader_.add_task(1));
+  EXPECT_TRUE(loader_.on_task_switch(1));
+  EXPECT_TRUE(loader_.get_call_context_stack().push(**executable_, {}));
+  EXPECT_TRUE(loader_.get_call_context_stack().push(**executable_, {}));
+
+  loader_.remove_task(1);
+  EXPECT_FALSE((*executable_)->get_active());
+}
+
+TEST_F(LoaderTasksShould, UseDefaultStackForUnknownTask)
+{
+  ASSERT_TRUE(executable_);
+  CallContextStack &initial = loader_.get_call_context_stack();
+  EXPECT_TRUE(loader_.add_task(1));
+  EXPECT_TRUE(loader_.on_task_switch(1));
+  EXPECT_NE(&loader_.get_call_context_stack(), &initial);
+
+  EXPECT_FALSE(loader_.on_task_switch(2));
+  EXPECT_EQ(&loader_.get_call_context_stack(), &initial);
+}
+
+} // namespace yasld
@@ -0,0 +1,155 @@
+/**
+ * compressed_sections_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "yasld/image_source.hpp"
+#include "yasld/loader.hpp"
+#include "yasld/parser.hpp"
+
+#include "image_builder.hpp"
+#include "memory_source.hpp"
+
+namespace yasld
+{
+
+namespace
+{
+
+const Header *header_of(const test::Image &image)
+{
+  return reinterpret_cast<const Header *>(image.data());
+}
+
+} // namespace
+
+class LoaderCompressedSectionsShould : public ::testing::Test
+{
+public:
+  LoaderCompressedSectionsShould()
+    : loader_{ [](std::size_t size, AllocationType)
+               {
+                 return std::malloc(size);
+               },
+               [](void *ptr)
+               {
+                 std::free(ptr);
+               } }
+    , raw_{ build(false, false) }
+    , compressed_{ build(true, true) }
+  {
+  }
+
+protected:
+  static test::Image build(bool text, bool data)
+  {
+    return test::ImageBuilder("executable", Header::Type::Executable)
+      .add_export("main", 0)
+      .add_fini(8)
+      .set_text_size(1024)
+      .set_data_size(700, 16)
+      .compress_sections(text, data)
+      .build();
+  }
+
+  void expect_loaded(const Module &module) const
+  {
+    const Parser parser(header_of(raw_));
+    const auto   text = module.get_text();
+    ASSERT_EQ(text.size(), parser.get_text().size());
+    EXPECT_EQ(
+      std::memcmp(text.data(), parser.get_text().data(), text.size()), 0);
+    const auto data = module.get_data();
+    ASSERT_EQ(data.size(), parser.get_data().size());
+    EXPECT_EQ(
+      std::memcmp(data.data(), parser.get_data().data(), data.size()), 0);
+  }
+
+  Loader      loader_;
+  test::Image raw_;
+  test::Image compressed_;
+};
+
+TEST_F(LoaderCompressedSectionsShould, StoreSmallerSections)
+{
+  const auto &raw        = *header_of(raw_)->section_directory();
+  const auto &compressed = *header_of(compressed_)->section_directory();
+  EXPECT_TRUE(header_of(compressed_)->has(Header::Flag::CompressedText));
+  EXPECT_TRUE(header_of(compressed_)->has(Header::Flag::CompressedData));
+  EXPECT_LT(compressed.text.size, raw.text.size);
+  EXPECT_LT(compressed.data.size, raw.data.size);
+  EXPECT_EQ(header_of(compressed_)->code_length, raw.text.size);
+}
+
+TEST_F(LoaderCompressedSectionsShould, DecompressSectionsOfMappedImage)
+{
+  auto executable = loader_.load_executable(compressed_.data());
+  ASSERT_TRUE(executable);
+  expect_loaded(**executable);
+}
+
+TEST_F(LoaderCompressedSectionsShould, DecompressSectionsReadFromSource)
+{
+  test::MemorySource source(compressed_);
+  auto               executable = loader_.load_executable(source);
+  ASSERT_TRUE(executable);
+  expect_loaded(**executable);
+}
+
+TEST_F(LoaderCompressedSectionsShould, CopyCompressedTextToRam)
+{
+  loader_.set_placement(
+    { .text = TextPlacement::ExecuteInPlace, .region = {} });
+  const auto image      = build(true, false);
+  auto       executable = loader_.load_executable(image.data());
+  ASSERT_TRUE(executable);
+  EXPECT_NE(
+    (*executable)->get_text().data(),
+    Parser(header_of(image)).get_text().data());
+  expect_loaded(**executable);
+}
+
+TEST_F(LoaderCompressedSectionsShould, DecompressInBoundedSteps)
+{
+  ASSERT_TRUE(loader_.start_loading_executable(compressed_.data()));
+  while (loader_.step(1) == Loader::LoadStatus::InProgress)
+  {
+  }
+  auto executable = loader_.take_executable();
+  ASSERT_TRUE(executable);
+  expect_loaded(**executable);
+}
+
+TEST_F(LoaderCompressedSectionsShould, RejectCorruptedSection)
+{
+  const auto &directory = *header_of(compressed_)->section_directory();
+  // first sequence of data becomes a match before start of output
+  auto *data = reinterpret_cast<uint8_t *>(compressed_.data()) +
+               directory.data.offset;
+  data[0] = 0x00;
+  data[1] = 0x01;
+  data[2] = 0x00;
+  EXPECT_FALSE(loader_.load_executable(compressed_.data()));
+}
+
+} // namespace yasld
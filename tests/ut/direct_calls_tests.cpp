@@ -0,0 +1,116 @@
+/**
+ * direct_calls_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+
+namespace yasld
+{
+
+class LoaderDirectCallsShould : public test::LoaderFixture
+{
+public:
+  LoaderDirectCallsShould()
+    : library_{ add_image(
+        "libfoo",
+        test::ImageBuilder("libfoo", Header::Type::Library)
+          .add_export("foo", 4)
+          .add_dependency("libbar")
+          .add_import("bar")
+          .set_text_size(64)
+          .set_lot_base_slot(slot_offset)
+          .build()) }
+    , executable_{ test::ImageBuilder("executable", Header::Type::Executable)
+                     .add_dependency("libfoo")
+                     .add_import("foo")
+                     .add_export("main", 0)
+                     .build() }
+  {
+    add_image(
+      "libbar",
+      test::ImageBuilder("libbar", Header::Type::Library)
+        .add_export("bar", 4)
+        .build());
+  }
+
+protected:
+  static std::size_t read_slot(const Module &module)
+  {
+    std::size_t value = 0;
+    std::memcpy(
+      &value, module.get_text().data() + slot_offset, sizeof(std::size_t));
+    return value;
+  }
+
+  static constexpr uint32_t slot_offset = 32;
+
+  const test::Image &library_;
+  test::Image        executable_;
+};
+
+TEST_F(LoaderDirectCallsShould, StoreLotBaseInTextCopiedToRam)
+{
+  auto executable = loader_.load_executable(executable_.data());
+  ASSERT_TRUE(executable);
+  ASSERT_EQ((*executable)->get_modules().size(), 1);
+  Module &library = *(*executable)->get_modules().front();
+
+  const auto *image_begin =
+    reinterpret_cast<const std::byte *>(library_.data());
+  const auto *image_end =
+    image_begin + library_.size() * sizeof(test::ImageBlock);
+  const auto text = library.get_text();
+  EXPECT_TRUE(text.data() < image_begin || text.data() >= image_end);
+  ASSERT_EQ(text.size(), 64);
+  for (std::size_t i = 0; i < slot_offset; ++i)
+  {
+    EXPECT_EQ(text[i], static_cast<std::byte>(i));
+  }
+
+  EXPECT_EQ(
+    read_slot(library),
+    reinterpret_cast<std::size_t>(library.get_lot().data()));
+  EXPECT_EQ(
+    (*executable)->get_lot()[0],
+    reinterpret_cast<std::size_t>(text.data()) + 4);
+}
+
+TEST_F(LoaderDirectCallsShould, StoreLotBaseOfEachInstance)
+{
+  auto first  = loader_.load_library(library_.data());
+  auto second = loader_.load_library(library_.data());
+  ASSERT_TRUE(first && second);
+
+  EXPECT_NE((*first)->get_text().data(), (*second)->get_text().data());
+  EXPECT_EQ(
+    read_slot(**first),
+    reinterpret_cast<std::size_t>((*first)->get_lot().data()));
+  EXPECT_EQ(
+    read_slot(**second),
+    reinterpret_cast<std::size_t>((*second)->get_lot().data()));
+}
+
+} // namespace yasld
@@ -0,0 +1,120 @@
+/**
+ * environment_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/environment.hpp"
+
+#include <gtest/gtest.h>
+
+#include "yasld/loader.hpp"
+
+namespace yasld
+{
+
+namespace
+{
+
+int stdout_file    = 0;
+int errno_value    = 0;
+int puts_function  = 0;
+int abort_function = 0;
+
+// Same form as table emitted by generate_environment.py
+constexpr SymbolEntry sorted_symbols[] = {
+  SymbolEntry{ "abort", &abort_function },
+  SymbolEntry{ "errno", &errno_value },
+  SymbolEntry{ "puts", &puts_function },
+  SymbolEntry{ "stdout", &stdout_file },
+};
+
+constinit const StaticEnvironment constant_environment{ sorted_symbols };
+
+} // namespace
+
+TEST(StaticEnvironmentShould, FindSymbolsInSortedTable)
+{
+  const StaticEnvironment &sut = constant_environment;
+
+  ASSERT_NE(sut.find_symbol("stdout"), nullptr);
+  EXPECT_EQ(sut.find_symbol("stdout")->address, &stdout_file);
+  ASSERT_NE(sut.find_symbol("errno"), nullptr);
+  EXPECT_EQ(sut.find_symbol("errno")->address, &errno_value);
+  ASSERT_NE(sut.find_symbol("abort"), nullptr);
+  EXPECT_EQ(sut.find_symbol("abort")->name, "abort");
+  ASSERT_NE(sut.find_symbol("puts"), nullptr);
+  EXPECT_EQ(sut.find_symbol("puts")->name, "puts");
+}
+
+TEST(StaticEnvironmentShould, RejectMissingSymbols)
+{
+  const SymbolEntry symbols[] = {
+    SymbolEntry{ "puts", &puts_function },
+    SymbolEntry{ "stdout", &stdout_file },
+  };
+  const StaticEnvironment sut{ symbols };
+
+  EXPECT_EQ(sut.find_symbol("put"), nullptr);
+  EXPECT_EQ(sut.find_symbol("putsx"), nullptr);
+  EXPECT_EQ(sut.find_symbol("a"), nullptr);
+  EXPECT_EQ(sut.find_symbol("z"), nullptr);
+}
+
+TEST(StaticEnvironmentShould, HandleEmptyTable)
+{
+  const StaticEnvironment sut{ {} };
+  EXPECT_EQ(sut.find_symbol("puts"), nullptr);
+}
+
+TEST(StaticEnvironmentShould, BeRejectedByLoaderWhenUnsorted)
+{
+  const SymbolEntry symbols[] = {
+    SymbolEntry{ "stdout", &stdout_file },
+    SymbolEntry{ "puts", &puts_function },
+  };
+  const StaticEnvironment sut{ symbols };
+  Loader                  loader;
+
+  EXPECT_FALSE(sut.is_valid());
+  EXPECT_FALSE(loader.set_environment(sut));
+  EXPECT_TRUE(constant_environment.is_valid());
+  EXPECT_TRUE(loader.set_environment(constant_environment));
+}
+
+TEST(StaticEnvironmentShould, ChangeFingerprintWithAddresses)
+{
+  const SymbolEntry same[] = {
+    SymbolEntry{ "abort", &abort_function },
+    SymbolEntry{ "errno", &errno_value },
+    SymbolEntry{ "puts", &puts_function },
+    SymbolEntry{ "stdout", &stdout_file },
+  };
+  const SymbolEntry moved[] = {
+    SymbolEntry{ "abort", &abort_function },
+    SymbolEntry{ "errno", &errno_value },
+    SymbolEntry{ "puts", &puts_function },
+    SymbolEntry{ "stdout", &errno_value },
+  };
+
+  const auto fingerprint = constant_environment.fingerprint();
+  EXPECT_EQ(constant_environment.fingerprint(), fingerprint);
+  EXPECT_EQ(StaticEnvironment{ same }.fingerprint(), fingerprint);
+  EXPECT_NE(StaticEnvironment{ moved }.fingerprint(), fingerprint);
+}
+
+} // namespace yasld
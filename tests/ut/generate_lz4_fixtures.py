@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+#
+# generate_lz4_fixtures.py
+#
+# Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+#
+# This program is free software: you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation, either version
+# 3 of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be
+# useful, but WITHOUT ANY WARRANTY; without even the implied
+# warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+# PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General
+# Public License along with this program. If not, see
+# <https://www.gnu.org/licenses/>.
+#
+
+# Generates header with blocks compressed by mkimage LZ4 encoder, so unit
+# tests decode the same stream that is stored in images.
+
+import argparse
+import sys
+
+from pathlib import Path
+
+sys.path.append(str((Path(__file__).parent.parent.parent / "mkimage").absolute()))
+
+import lz4
+
+parser = argparse.ArgumentParser(
+    description="Generates LZ4 test fixtures with mkimage encoder"
+)
+parser.add_argument("-i", "--input", action="store", help="Binary compressed as is")
+parser.add_argument("-o", "--output", action="store", help="Generated C++ header")
+
+args, _ = parser.parse_known_args()
+
+
+# same as create_data() in lz4_decoder_tests.cpp
+def mixed():
+    data = bytearray((i * 7 + i // 3) & 0xFF for i in range(300))
+    data += bytearray([0xAA] * 600)
+    data += bytearray(i % 37 for i in range(1000))
+    return data
+
+
+def pseudo_random(size, seed):
+    data = bytearray()
+    for _ in range(size):
+        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+        data.append(seed >> 16 & 0xFF)
+    return data
+
+
+# block repeated further than maximal match offset is stored as literals
+def long_distance():
+    block = pseudo_random(512, 1)
+    return block + pseudo_random(lz4.MAX_OFFSET, 2) + block
+
+
+fixtures = [
+    ("short", bytearray(b"yasld lz4")),
+    ("mixed", mixed()),
+    ("long_distance", long_distance()),
+]
+with open(args.input, "rb") as file:
+    fixtures.append((Path(args.input).stem, bytearray(file.read())))
+
+
+def to_array(name, data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x{:02x}".format(b) for b in data[i : i + 16]))
+    return "inline constexpr uint8_t {}[] = {{\n{}\n}};\n".format(
+        name, ",\n".join(lines)
+    )
+
+
+output = """// Generated by generate_lz4_fixtures.py, do not edit
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace yasld::test
+{
+
+struct Lz4Fixture
+{
+  const char               *name;
+  std::span<const uint8_t> data;
+  std::span<const uint8_t> compressed;
+};
+
+"""
+for name, data in fixtures:
+    output += to_array(name + "_data", data) + "\n"
+    output += to_array(name + "_compressed", lz4.compress(data)) + "\n"
+
+output += "inline constexpr Lz4Fixture lz4_fixtures[] = {\n"
+for name, _ in fixtures:
+    output += '  {{ "{0}", {0}_data, {0}_compressed }},\n'.format(name)
+output += "};\n\n} // namespace yasld::test\n"
+
+with open(args.output, "w") as file:
+    file.write(output)
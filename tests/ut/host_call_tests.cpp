@@ -0,0 +1,142 @@
+/**
+ * host_call_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/host_call.hpp"
+
+#include <gtest/gtest.h>
+
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+
+extern "C"
+{
+  int call_entry(std::size_t address, const void *lot);
+  int call_main(int argc, char *argv[], std::size_t address, const void *lot);
+}
+
+namespace yasld
+{
+
+namespace
+{
+
+std::size_t lot_seen_by_module = 0;
+
+int entry()
+{
+  lot_seen_by_module = get_current_lot();
+  return 7;
+}
+
+int main_with_arguments(int argc, char *argv[])
+{
+  lot_seen_by_module = get_current_lot();
+  return argc + argv[0][0];
+}
+
+std::size_t lot_of(Module &module)
+{
+  return reinterpret_cast<std::size_t>(module.get_lot().data());
+}
+
+} // namespace
+
+class HostCallShould : public test::LoaderFixture
+{
+public:
+  HostCallShould()
+    : executable_{ test::ImageBuilder("executable", Header::Type::Executable)
+                     .add_dependency("libfoo")
+                     .add_import("foo")
+                     .add_export("main", 0)
+                     .set_data_size(16, 0)
+                     .build() }
+  {
+    set_current_lot(0);
+    lot_seen_by_module = 0;
+    add_image(
+      "libfoo",
+      test::ImageBuilder("libfoo", Header::Type::Library)
+        .add_export("foo", 4)
+        .set_data_size(16, 16)
+        .build());
+  }
+
+protected:
+  test::Image executable_;
+};
+
+TEST_F(HostCallShould, CallEntryWithLotOfModule)
+{
+  int lot = 0;
+  set_current_lot(0x100);
+  EXPECT_EQ(call_entry(reinterpret_cast<std::size_t>(&entry), &lot), 7);
+  EXPECT_EQ(lot_seen_by_module, reinterpret_cast<std::size_t>(&lot));
+  EXPECT_EQ(get_current_lot(), 0x100);
+}
+
+TEST_F(HostCallShould, PassArgumentsToMain)
+{
+  int        lot    = 0;
+  char       name[] = "a";
+  char      *argv[] = { name, nullptr };
+  const auto main   = reinterpret_cast<std::size_t>(&main_with_arguments);
+  EXPECT_EQ(call_main(1, argv, main, &lot), 1 + 'a');
+  EXPECT_EQ(lot_seen_by_module, reinterpret_cast<std::size_t>(&lot));
+  EXPECT_EQ(get_current_lot(), 0);
+}
+
+TEST_F(HostCallShould, SwitchLotForCallBetweenModules)
+{
+  auto executable = loader_.load_executable(executable_.data());
+  ASSERT_TRUE(executable);
+  Module &library = *(*executable)->get_modules().front();
+  const auto text =
+    reinterpret_cast<std::size_t>(library.get_text().data()) + 4;
+
+  set_current_lot(lot_of(**executable));
+  ASSERT_TRUE(enter_module_call(loader_, text));
+  EXPECT_EQ(get_current_lot(), lot_of(library));
+  EXPECT_TRUE(library.get_active());
+
+  // library calls back into executable
+  const auto callback =
+    reinterpret_cast<std::size_t>((*executable)->get_text().data());
+  ASSERT_TRUE(enter_module_call(loader_, callback));
+  EXPECT_EQ(get_current_lot(), lot_of(**executable));
+  ASSERT_TRUE(exit_module_call(loader_));
+  EXPECT_EQ(get_current_lot(), lot_of(library));
+
+  ASSERT_TRUE(exit_module_call(loader_));
+  EXPECT_EQ(get_current_lot(), lot_of(**executable));
+  EXPECT_FALSE(library.get_active());
+}
+
+TEST_F(HostCallShould, RejectExitWithoutEntry)
+{
+  set_current_lot(0x100);
+  EXPECT_FALSE(exit_module_call(loader_));
+  EXPECT_FALSE(enter_module_call(loader_, 0x10));
+  EXPECT_EQ(get_current_lot(), 0x100);
+}
+
+} // namespace yasld
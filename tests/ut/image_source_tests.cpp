@@ -0,0 +1,241 @@
+/**
+ * image_source_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/image_source.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "yasld/block_cache.hpp"
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+#include "memory_source.hpp"
+
+namespace yasld
+{
+
+namespace
+{
+
+std::span<const std::byte> as_bytes(const test::Image &image)
+{
+  return std::as_bytes(std::span(image));
+}
+
+} // namespace
+
+class BlockCacheShould : public ::testing::Test
+{
+public:
+  BlockCacheShould()
+    : memory_(1000)
+    , storage_{ memory_ }
+    , sut_{ storage_ }
+  {
+    for (std::size_t i = 0; i < memory_.size(); ++i)
+    {
+      memory_[i] = static_cast<std::byte>(i);
+    }
+  }
+
+protected:
+  std::vector<std::byte> read(std::size_t offset, std::size_t size)
+  {
+    std::vector<std::byte> buffer(size);
+    EXPECT_TRUE(sut_.read(offset, buffer));
+    return buffer;
+  }
+
+  std::vector<std::byte> expected(std::size_t offset, std::size_t size)
+  {
+    return { memory_.begin() + static_cast<std::ptrdiff_t>(offset),
+             memory_.begin() + static_cast<std::ptrdiff_t>(offset + size) };
+  }
+
+  std::vector<std::byte> memory_;
+  test::MemorySource     storage_;
+  BlockCache<64, 4>      sut_;
+};
+
+TEST_F(BlockCacheShould, ReadAcrossBlocks)
+{
+  EXPECT_EQ(read(60, 200), expected(60, 200));
+  EXPECT_EQ(read(990, 10), expected(990, 10));
+  std::vector<std::byte> buffer(11);
+  EXPECT_FALSE(sut_.read(990, buffer));
+}
+
+TEST_F(BlockCacheShould, ServeRepeatedReadsFromCache)
+{
+  EXPECT_EQ(read(200, 8), expected(200, 8));
+  const int reads = storage_.reads;
+  EXPECT_EQ(read(200, 8), expected(200, 8));
+  EXPECT_EQ(read(196, 4), expected(196, 4));
+  EXPECT_EQ(storage_.reads, reads);
+}
+
+TEST_F(BlockCacheShould, ReadAheadOnSequentialAccess)
+{
+  EXPECT_EQ(read(0, 16), expected(0, 16));
+  EXPECT_EQ(storage_.reads, 2);
+  // whole next block was prefetched by previous read
+  for (std::size_t offset = 16; offset < 128; offset += 16)
+  {
+    EXPECT_EQ(read(offset, 16), expected(offset, 16));
+  }
+  EXPECT_EQ(storage_.reads, 3);
+}
+
+TEST_F(BlockCacheShould, EvictLeastRecentlyUsedBlock)
+{
+  read(0, 1);
+  read(512, 1);
+  read(256, 1);
+  read(0, 1);
+  const int reads = storage_.reads;
+  // random access without read-ahead, 0 and 256 blocks are recently used
+  read(768, 1);
+  read(0, 1);
+  read(256, 1);
+  EXPECT_EQ(storage_.reads, reads + 1);
+}
+
+class LoaderImageSourceShould : public ::testing::Test
+{
+public:
+  LoaderImageSourceShould()
+    : loader_{ [](std::size_t size, AllocationType)
+               {
+                 return std::malloc(size);
+               },
+               [](void *ptr)
+               {
+                 std::free(ptr);
+               } }
+    , library_image_{ test::ImageBuilder("libfoo", Header::Type::Library)
+                        .add_export("foo", 8)
+                        .set_text_size(300)
+                        .set_data_size(100, 20)
+                        .build() }
+    , executable_image_{ test::ImageBuilder(
+                           "executable",
+                           Header::Type::Executable)
+                           .add_dependency("libfoo")
+                           .add_import("foo")
+                           .add_export("main", 0)
+                           .set_text_size(1000)
+                           .set_data_size(200, 0)
+                           .build() }
+    , library_storage_{ as_bytes(library_image_) }
+    , executable_storage_{ as_bytes(executable_image_) }
+    , library_{ library_storage_ }
+    , executable_{ executable_storage_ }
+  {
+    loader_.register_source_resolver(
+      [this](const std::string_view &name) -> ImageSource *
+      {
+        return name == "libfoo" ? &library_ : nullptr;
+      });
+  }
+
+protected:
+  static void expect_section(
+    std::span<const std::byte>     section,
+    const test::Image             &image,
+    const SectionDirectory::Entry &entry)
+  {
+    ASSERT_EQ(section.size(), entry.size);
+    EXPECT_EQ(
+      std::memcmp(
+        section.data(),
+        reinterpret_cast<const std::byte *>(image.data()) + entry.offset,
+        entry.size),
+      0);
+  }
+
+  static const SectionDirectory &directory(const test::Image &image)
+  {
+    return *reinterpret_cast<const Header *>(image.data())
+              ->section_directory();
+  }
+
+  Loader             loader_;
+  test::Image        library_image_;
+  test::Image        executable_image_;
+  test::MemorySource library_storage_;
+  test::MemorySource executable_storage_;
+  BlockCache<128, 4> library_;
+  BlockCache<128, 4> executable_;
+};
+
+TEST_F(LoaderImageSourceShould, CopyTextAndDataToRam)
+{
+  auto executable = loader_.load_executable(executable_);
+  ASSERT_TRUE(executable);
+
+  const auto text = (*executable)->get_text();
+  const auto *image_begin =
+    reinterpret_cast<const std::byte *>(executable_image_.data());
+  const auto *image_end =
+    image_begin + executable_image_.size() * sizeof(test::ImageBlock);
+  EXPECT_TRUE(text.data() < image_begin || text.data() >= image_end);
+  expect_section(text, executable_image_, directory(executable_image_).text);
+  expect_section(
+    (*executable)->get_data(),
+    executable_image_,
+    directory(executable_image_).data);
+  EXPECT_EQ((*executable)->get_name(), "executable");
+
+  ASSERT_EQ((*executable)->get_modules().size(), 1);
+  const auto &library = *(*executable)->get_modules().front();
+  expect_section(
+    library.get_text(), library_image_, directory(library_image_).text);
+  EXPECT_EQ(
+    (*executable)->get_lot()[0],
+    reinterpret_cast<std::size_t>(library.get_text().data()) + 8);
+}
+
+TEST_F(LoaderImageSourceShould, ReadEachStorageBlockOnce)
+{
+  auto executable = loader_.load_executable(executable_);
+  ASSERT_TRUE(executable);
+
+  const std::size_t image_size = executable_storage_.size();
+  EXPECT_LE(executable_storage_.bytes, image_size);
+  EXPECT_LE(
+    static_cast<std::size_t>(executable_storage_.reads),
+    (image_size + 127) / 128);
+}
+
+TEST_F(LoaderImageSourceShould, RejectImagesWithoutSectionDirectory)
+{
+  const auto image = test::ImageBuilder("v1", Header::Type::Executable)
+                       .set_version(1)
+                       .add_export("main", 0)
+                       .build();
+  test::MemorySource storage{ as_bytes(image) };
+  EXPECT_FALSE(loader_.load_executable(storage));
+}
+
+} // namespace yasld
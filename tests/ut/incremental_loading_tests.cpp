@@ -0,0 +1,182 @@
+/**
+ * incremental_loading_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+
+namespace yasld
+{
+
+class LoaderIncrementalLoadingShould : public test::LoaderFixture
+{
+public:
+  LoaderIncrementalLoadingShould()
+    : LoaderFixture(
+        [](std::size_t size, AllocationType)
+        {
+          ++allocations;
+          return std::malloc(size);
+        },
+        [](void *ptr)
+        {
+          if (ptr != nullptr)
+          {
+            --allocations;
+          }
+          std::free(ptr);
+        })
+    , library_{ add_image(
+        "libfoo",
+        test::ImageBuilder("libfoo", Header::Type::Library)
+          .add_export("foo", 4)
+          .add_export("bar", 8)
+          .set_data_size(200, 100)
+          .build()) }
+  {
+    allocations = 0;
+  }
+
+protected:
+  test::Image create_executable(const std::vector<std::string> &imports)
+  {
+    test::ImageBuilder builder("executable", Header::Type::Executable);
+    builder.add_dependency("libfoo").set_data_size(100, 0);
+    for (const auto &name : imports)
+    {
+      builder.add_import(name);
+    }
+    return builder.add_export("main", 0).build();
+  }
+
+  std::vector<std::size_t> get_imports(
+    Loader::ObservedExecutable &executable,
+    std::size_t                 size)
+  {
+    const auto lot = executable->get_lot();
+    return { lot.begin(), lot.begin() + static_cast<std::ptrdiff_t>(size) };
+  }
+
+  int count_steps(const test::Image &image)
+  {
+    EXPECT_TRUE(loader_.start_loading_library(image.data()));
+    int steps = 0;
+    while (loader_.step(1) == Loader::LoadStatus::InProgress)
+    {
+      ++steps;
+    }
+    EXPECT_TRUE(loader_.take_library());
+    return steps;
+  }
+
+  static inline int  allocations = 0;
+  const test::Image &library_;
+};
+
+TEST_F(LoaderIncrementalLoadingShould, LoadModuleInBoundedSteps)
+{
+  const auto image = create_executable({ "foo", "bar" });
+
+  std::vector<std::size_t> expected;
+  {
+    auto executable = loader_.load_executable(image.data());
+    ASSERT_TRUE(executable);
+    expected = get_imports(*executable, 2);
+  }
+
+  ASSERT_TRUE(loader_.start_loading_executable(image.data()));
+  EXPECT_FALSE(loader_.take_executable());
+
+  int steps = 0;
+  while (loader_.step(1) == Loader::LoadStatus::InProgress)
+  {
+    ++steps;
+  }
+  // header, dependency, data blocks and relocations of both modules
+  EXPECT_GT(steps, 10);
+
+  auto executable = loader_.take_executable();
+  ASSERT_TRUE(executable);
+  EXPECT_EQ(get_imports(*executable, 2), expected);
+  EXPECT_EQ((*executable)->get_modules().size(), 1);
+  EXPECT_EQ(loader_.step(1), Loader::LoadStatus::Failed);
+}
+
+TEST_F(LoaderIncrementalLoadingShould, RelocateInitInBlocks)
+{
+  constexpr std::size_t entries = 64;
+  test::ImageBuilder    builder("libinit", Header::Type::Library);
+  for (std::size_t i = 0; i < entries; ++i)
+  {
+    builder.add_fini(0);
+  }
+  const auto large = builder.build();
+  const auto small =
+    test::ImageBuilder("libinit", Header::Type::Library).add_fini(0).build();
+
+  const std::size_t blocks =
+    entries * sizeof(std::size_t) / Loader::load_block_size;
+  EXPECT_GE(
+    static_cast<std::size_t>(count_steps(large) - count_steps(small)),
+    blocks - 1);
+}
+
+TEST_F(LoaderIncrementalLoadingShould, RejectSecondLoadInProgress)
+{
+  const auto image = create_executable({ "foo" });
+
+  ASSERT_TRUE(loader_.start_loading_executable(image.data()));
+  EXPECT_EQ(loader_.step(1), Loader::LoadStatus::InProgress);
+  EXPECT_FALSE(loader_.start_loading_library(library_.data()));
+  EXPECT_FALSE(loader_.load_executable(image.data()));
+
+  EXPECT_EQ(loader_.step(1000), Loader::LoadStatus::Done);
+  EXPECT_TRUE(loader_.take_executable());
+}
+
+TEST_F(LoaderIncrementalLoadingShould, ReleaseDependenciesWhenLoadingFails)
+{
+  const auto image = create_executable({ "foo", "missing" });
+  {
+    // loader keeps buffers for registry and load stack
+    ASSERT_TRUE(loader_.load_executable(create_executable({ "foo" }).data()));
+  }
+  const int allocated_by_loader = allocations;
+
+  ASSERT_TRUE(loader_.start_loading_executable(image.data()));
+  Loader::LoadStatus status = Loader::LoadStatus::InProgress;
+  while (status == Loader::LoadStatus::InProgress)
+  {
+    status = loader_.step(3);
+  }
+
+  EXPECT_EQ(status, Loader::LoadStatus::Failed);
+  EXPECT_FALSE(loader_.take_executable());
+  EXPECT_EQ(allocations, allocated_by_loader);
+}
+
+} // namespace yasld
@@ -0,0 +1,193 @@
+/**
+ * lazy_binding_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/lazy_binding.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "yasld/environment.hpp"
+#include "yasld/loader.hpp"
+
+#include "counting_environment.hpp"
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+
+namespace yasld
+{
+
+namespace
+{
+
+int   function         = 0;
+int   object           = 0;
+void *function_address = &function;
+void *object_address   = &object;
+
+const std::vector<SymbolEntry> symbols = {
+  SymbolEntry{ "function", function_address },
+  SymbolEntry{ "object", object_address },
+};
+
+} // namespace
+
+class LoaderLazyBindingShould : public test::LoaderFixture
+{
+public:
+  LoaderLazyBindingShould()
+    : environment_{ symbols }
+  {
+    loader_.set_environment(environment_);
+  }
+
+  void SetUp() override
+  {
+    lazy_binding_ = loader_.set_lazy_binding(true);
+  }
+
+protected:
+  std::optional<Loader::ObservedExecutable> load(const test::Image &image)
+  {
+    auto executable = loader_.load_executable(image.data());
+    EXPECT_TRUE(executable);
+    return executable;
+  }
+
+  static LazyBinding *get_binding(std::size_t lot_entry)
+  {
+    return reinterpret_cast<LazyBinding *>(
+      lot_entry & ~lazy_binding_thunk_flags);
+  }
+
+  const std::size_t expected_function_ =
+    reinterpret_cast<std::size_t>(&function);
+  const std::size_t expected_object_ = reinterpret_cast<std::size_t>(&object);
+
+  test::CountingEnvironment environment_;
+  bool                      lazy_binding_ = false;
+};
+
+using LoaderLazyBindingSupportShould = test::LoaderFixture;
+
+TEST_F(LoaderLazyBindingSupportShould, ResolveEagerlyWithoutThunk)
+{
+  test::CountingEnvironment environment(symbols);
+  loader_.set_environment(environment);
+  EXPECT_EQ(loader_.set_lazy_binding(true), lazy_binding_supported);
+  if (lazy_binding_supported)
+  {
+    return;
+  }
+
+  const auto image = test::ImageBuilder("host", Header::Type::Executable)
+                       .add_imported_function("function")
+                       .add_export("main", 0)
+                       .build();
+  auto       executable = loader_.load_executable(image.data());
+  ASSERT_TRUE(executable);
+  EXPECT_EQ(
+    (*executable)->get_lot()[0], reinterpret_cast<std::size_t>(&function));
+  EXPECT_EQ(environment.lookups, 1);
+}
+
+TEST_F(LoaderLazyBindingShould, ResolveImportedFunctionsOnFirstCall)
+{
+  if (!lazy_binding_)
+  {
+    GTEST_SKIP() << "Lazy binding is not supported on this architecture";
+  }
+  const auto image = test::ImageBuilder("lazy", Header::Type::Executable)
+                       .add_imported_function("function")
+                       .add_import("object")
+                       .add_export("main", 0)
+                       .build();
+  auto       executable = load(image);
+  ASSERT_TRUE(executable);
+  auto lot = (*executable)->get_lot();
+
+  EXPECT_EQ(environment_.lookups, 1);
+  EXPECT_EQ(lot[1], expected_object_);
+
+  LazyBinding *binding = get_binding(lot[0]);
+  EXPECT_EQ(binding->self, binding);
+  EXPECT_EQ(
+    binding->resolver,
+    reinterpret_cast<std::size_t>(&yasld_lazy_binding_resolver));
+  EXPECT_EQ(binding->lot_index, 0);
+
+  EXPECT_EQ(loader_.resolve_lazy_binding(*binding), expected_function_);
+  EXPECT_EQ(lot[0], expected_function_);
+  EXPECT_EQ(environment_.lookups, 2);
+}
+
+TEST_F(LoaderLazyBindingShould, ResolveEagerlyWhenDisabled)
+{
+  loader_.set_lazy_binding(false);
+  const auto image = test::ImageBuilder("eager", Header::Type::Executable)
+                       .add_imported_function("function")
+                       .add_import("object")
+                       .add_export("main", 0)
+                       .build();
+  auto       executable = load(image);
+  ASSERT_TRUE(executable);
+  auto lot = (*executable)->get_lot();
+
+  EXPECT_EQ(environment_.lookups, 2);
+  EXPECT_EQ(lot[0], expected_function_);
+  EXPECT_EQ(lot[1], expected_object_);
+}
+
+TEST_F(LoaderLazyBindingShould, ResolveEagerlyWithoutMarkedFunctions)
+{
+  const auto image = test::ImageBuilder("unmarked", Header::Type::Executable)
+                       .add_import("function")
+                       .add_import("object")
+                       .add_export("main", 0)
+                       .build();
+  auto       executable = load(image);
+  ASSERT_TRUE(executable);
+  auto lot = (*executable)->get_lot();
+
+  EXPECT_EQ(environment_.lookups, 2);
+  EXPECT_EQ(lot[0], expected_function_);
+  EXPECT_EQ(lot[1], expected_object_);
+}
+
+TEST_F(LoaderLazyBindingShould, ReportMissingFunctionOnFirstCall)
+{
+  if (!lazy_binding_)
+  {
+    GTEST_SKIP() << "Lazy binding is not supported on this architecture";
+  }
+  const auto image = test::ImageBuilder("missing", Header::Type::Executable)
+                       .add_imported_function("missing")
+                       .add_export("main", 0)
+                       .build();
+  auto       executable = load(image);
+  ASSERT_TRUE(executable);
+  auto       lot   = (*executable)->get_lot();
+  const auto thunk = lot[0];
+
+  EXPECT_EQ(loader_.resolve_lazy_binding(*get_binding(thunk)), std::nullopt);
+  EXPECT_EQ(lot[0], thunk);
+}
+
+} // namespace yasld
@@ -0,0 +1,172 @@
+/**
+ * lz4_decoder_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/lz4_decoder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "lz4_encoder.hpp"
+#include "lz4_fixtures.hpp"
+
+namespace yasld
+{
+
+namespace
+{
+
+// Literal runs and matches longer than 15 bytes use length extensions
+std::vector<uint8_t> create_data()
+{
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < 300; ++i)
+  {
+    data.push_back(static_cast<uint8_t>(i * 7 + i / 3));
+  }
+  data.insert(data.end(), 600, 0xaa);
+  for (uint32_t i = 0; i < 1000; ++i)
+  {
+    data.push_back(static_cast<uint8_t>(i % 37));
+  }
+  return data;
+}
+
+std::span<const std::byte> as_input(const std::vector<uint8_t> &data)
+{
+  return std::as_bytes(std::span(data));
+}
+
+} // namespace
+
+class Lz4DecoderShould : public ::testing::Test
+{
+public:
+  Lz4DecoderShould()
+    : data_{ create_data() }
+    , compressed_{ test::lz4_compress(data_) }
+    , output_(data_.size())
+    , sut_{ std::as_writable_bytes(std::span(output_)) }
+  {
+  }
+
+protected:
+  std::vector<uint8_t> data_;
+  std::vector<uint8_t> compressed_;
+  std::vector<uint8_t> output_;
+  Lz4Decoder           sut_;
+};
+
+TEST_F(Lz4DecoderShould, DecodeCompressedData)
+{
+  EXPECT_LT(compressed_.size(), data_.size() / 2);
+  EXPECT_TRUE(sut_.decode(as_input(compressed_)));
+  EXPECT_TRUE(sut_.finished());
+  EXPECT_EQ(sut_.written(), data_.size());
+  EXPECT_EQ(output_, data_);
+}
+
+TEST_F(Lz4DecoderShould, DecodeInputPassedInChunks)
+{
+  const auto input = as_input(compressed_);
+  for (std::size_t i = 0; i < input.size(); ++i)
+  {
+    EXPECT_FALSE(sut_.finished());
+    ASSERT_TRUE(sut_.decode(input.subspan(i, 1)));
+  }
+  EXPECT_TRUE(sut_.finished());
+  EXPECT_EQ(output_, data_);
+}
+
+TEST_F(Lz4DecoderShould, CopyOverlappingMatch)
+{
+  // literal 'a', match of 8 bytes from offset 1, last literals "bcdef"
+  const std::vector<uint8_t> input = {
+    0x14, 'a', 0x01, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'
+  };
+  std::vector<uint8_t> output(14);
+  Lz4Decoder           sut(std::as_writable_bytes(std::span(output)));
+  EXPECT_TRUE(sut.decode(as_input(input)));
+  EXPECT_TRUE(sut.finished());
+  std::vector<uint8_t> expected(9, 'a');
+  expected.insert(expected.end(), { 'b', 'c', 'd', 'e', 'f' });
+  EXPECT_EQ(output, expected);
+}
+
+TEST_F(Lz4DecoderShould, RejectMatchOutsideOfOutput)
+{
+  const std::vector<uint8_t> input = { 0x10, 'a', 0x02, 0x00 };
+  EXPECT_FALSE(sut_.decode(as_input(input)));
+
+  const std::vector<uint8_t> zero_offset = { 0x10, 'a', 0x00, 0x00 };
+  Lz4Decoder sut(std::as_writable_bytes(std::span(output_)));
+  EXPECT_FALSE(sut.decode(as_input(zero_offset)));
+}
+
+TEST_F(Lz4DecoderShould, RejectOutputOverflow)
+{
+  std::vector<uint8_t> output(data_.size() - 1);
+  Lz4Decoder           sut(std::as_writable_bytes(std::span(output)));
+  EXPECT_FALSE(sut.decode(as_input(compressed_)));
+}
+
+TEST_F(Lz4DecoderShould, NotFinishTruncatedStream)
+{
+  EXPECT_TRUE(
+    sut_.decode(as_input(compressed_).first(compressed_.size() - 1)));
+  EXPECT_FALSE(sut_.finished());
+}
+
+// Blocks compressed by mkimage/lz4.py, the encoder used for images
+TEST(Lz4DecoderMkimageBlocksShould, DecodeToOriginalData)
+{
+  for (const auto &fixture : test::lz4_fixtures)
+  {
+    SCOPED_TRACE(fixture.name);
+    std::vector<uint8_t> output(fixture.data.size());
+    Lz4Decoder           sut(std::as_writable_bytes(std::span(output)));
+    EXPECT_TRUE(sut.decode(std::as_bytes(fixture.compressed)));
+    EXPECT_TRUE(sut.finished());
+    EXPECT_TRUE(std::ranges::equal(output, fixture.data));
+  }
+}
+
+TEST(Lz4DecoderMkimageBlocksShould, DecodeInputPassedInChunks)
+{
+  constexpr std::size_t chunk_size = 61;
+  for (const auto &fixture : test::lz4_fixtures)
+  {
+    SCOPED_TRACE(fixture.name);
+    std::vector<uint8_t> output(fixture.data.size());
+    Lz4Decoder           sut(std::as_writable_bytes(std::span(output)));
+    const auto           input = std::as_bytes(fixture.compressed);
+    for (std::size_t i = 0; i < input.size(); i += chunk_size)
+    {
+      ASSERT_TRUE(sut.decode(
+        input.subspan(i, std::min(chunk_size, input.size() - i))));
+    }
+    EXPECT_TRUE(sut.finished());
+    EXPECT_TRUE(std::ranges::equal(output, fixture.data));
+  }
+}
+
+} // namespace yasld
@@ -0,0 +1,197 @@
+/**
+ * memory_usage_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/memory_usage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <map>
+
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+
+namespace yasld
+{
+
+class LoaderMemoryUsageShould : public test::LoaderFixture
+{
+public:
+  LoaderMemoryUsageShould()
+    : LoaderFixture(
+        [](std::size_t size, AllocationType type)
+        {
+          void *memory = std::malloc(size);
+          allocations[memory] = { size, type };
+          return memory;
+        },
+        [](void *ptr)
+        {
+          allocations.erase(ptr);
+          std::free(ptr);
+        })
+    , initial_{ YasldAllocatorHolder::get().get_usage() }
+    , executable_{ test::ImageBuilder("executable", Header::Type::Executable)
+                     .add_dependency("libbar")
+                     .add_dependency("libbaz")
+                     .add_export("main", 0)
+                     .set_data_size(100, 20)
+                     .build() }
+  {
+    // loader constructor allocations are counted in initial usage
+    allocations.clear();
+    add_image(
+      "libbaz",
+      test::ImageBuilder("libbaz", Header::Type::Library)
+        .set_data_size(64, 32)
+        .build());
+    add_image(
+      "libbar",
+      test::ImageBuilder("libbar", Header::Type::Library)
+        .add_dependency("libbaz")
+        .set_data_size(8, 0)
+        .build());
+  }
+
+protected:
+  Loader::ObservedExecutable load()
+  {
+    auto executable = loader_.load_executable(executable_.data());
+    EXPECT_TRUE(executable);
+    return std::move(*executable);
+  }
+
+  // Live memory of loader allocator for given type
+  static AllocationStatistics allocated(AllocationType type)
+  {
+    AllocationStatistics statistics{ 0, 0 };
+    for (const auto &[memory, allocation] : allocations)
+    {
+      if (allocation.second == type)
+      {
+        statistics.bytes += allocation.first;
+        ++statistics.allocations;
+      }
+    }
+    return statistics;
+  }
+
+  // memory allocated before test is not tracked by test allocator
+  void expect_usage_of_allocator() const
+  {
+    const auto &usage = loader_.get_memory_usage();
+    for (std::size_t i = 0; i < MemoryUsage::number_of_types; ++i)
+    {
+      const auto type    = static_cast<AllocationType>(i);
+      const auto initial = initial_.get(type);
+      EXPECT_EQ(usage.get(type).bytes - initial.bytes, allocated(type).bytes)
+        << i;
+      EXPECT_EQ(
+        usage.get(type).allocations - initial.allocations,
+        allocated(type).allocations)
+        << i;
+    }
+  }
+
+  static inline std::map<void *, std::pair<std::size_t, AllocationType>>
+              allocations;
+  MemoryUsage initial_;
+  test::Image executable_;
+};
+
+TEST_F(LoaderMemoryUsageShould, CountAllocationsPerType)
+{
+  auto executable = load();
+  expect_usage_of_allocator();
+  EXPECT_GT(loader_.get_memory_usage().get(AllocationType::Arena).bytes, 0);
+
+  loader_.set_module_arena(false);
+  auto second = load();
+  expect_usage_of_allocator();
+  EXPECT_GE(
+    loader_.get_memory_usage().get(AllocationType::Data).bytes, 100 + 20);
+
+  loader_.unload(std::move(executable));
+  loader_.unload(std::move(second));
+  expect_usage_of_allocator();
+}
+
+TEST_F(LoaderMemoryUsageShould, ReportMemoryOfModule)
+{
+  loader_.set_module_arena(false);
+  auto        executable = load();
+  const auto &usage      = executable->get_memory_usage();
+  EXPECT_EQ(usage.get(AllocationType::Data).bytes, 100 + 20);
+  EXPECT_EQ(usage.get(AllocationType::Data).allocations, 1);
+  EXPECT_EQ(
+    usage.get(AllocationType::OffsetTable).bytes,
+    executable->get_lot().size_bytes());
+  EXPECT_EQ(
+    usage.get(AllocationType::Module).bytes, 2 * sizeof(SharedModule));
+  EXPECT_EQ(usage.get(AllocationType::Arena).bytes, 0);
+
+  const auto &library = *executable->get_modules().front();
+  EXPECT_EQ(library.get_name(), "libbar");
+  EXPECT_GT(
+    library.get_memory_usage().get(AllocationType::Module).bytes,
+    sizeof(SharedModule));
+}
+
+TEST_F(LoaderMemoryUsageShould, CountSharedDependencyOnce)
+{
+  auto        executable = load();
+  auto       &libbar     = *executable->get_modules()[0];
+  const auto &libbaz     = *executable->get_modules()[1];
+  EXPECT_EQ(libbar.get_modules()[0].get(), &libbaz);
+
+  const std::size_t expected = executable->get_memory_usage().bytes() +
+                               libbar.get_memory_usage().bytes() +
+                               libbaz.get_memory_usage().bytes();
+  const auto        total    = executable->get_total_memory_usage();
+  EXPECT_EQ(total.bytes(), expected);
+  EXPECT_EQ(total.get(AllocationType::Arena).allocations, 3);
+  EXPECT_EQ(
+    libbar.get_total_memory_usage().bytes(),
+    libbar.get_memory_usage().bytes() + libbaz.get_memory_usage().bytes());
+}
+
+TEST_F(LoaderMemoryUsageShould, KeepHighWaterMark)
+{
+  // loader keeps buffers for registry and load stack
+  loader_.unload(load());
+  loader_.reset_memory_peak();
+  const std::size_t initial = loader_.get_memory_usage().bytes();
+  EXPECT_EQ(loader_.get_memory_usage().peak_bytes(), initial);
+
+  auto              executable = load();
+  const std::size_t loaded     = loader_.get_memory_usage().bytes();
+  EXPECT_GT(loaded, initial);
+  loader_.unload(std::move(executable));
+
+  EXPECT_EQ(loader_.get_memory_usage().bytes(), initial);
+  EXPECT_GE(loader_.get_memory_usage().peak_bytes(), loaded);
+
+  loader_.reset_memory_peak();
+  EXPECT_EQ(loader_.get_memory_usage().peak_bytes(), initial);
+}
+
+} // namespace yasld
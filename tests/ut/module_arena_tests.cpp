@@ -0,0 +1,207 @@
+/**
+ * module_arena_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+#include "yasld/environment.hpp"
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+
+namespace yasld
+{
+
+class LoaderArenaShould : public test::LoaderFixture
+{
+public:
+  LoaderArenaShould()
+    : LoaderFixture(
+        [](std::size_t size, AllocationType type)
+        {
+          void *memory = std::malloc(size);
+          allocations.push_back({ type, memory, size });
+          return memory;
+        },
+        [](void *ptr)
+        {
+          if (ptr != nullptr)
+          {
+            ++releases;
+          }
+          std::free(ptr);
+        })
+    , executable_{ test::ImageBuilder("executable", Header::Type::Executable)
+                     .add_dependency("libfoo")
+                     .add_import("foo")
+                     .add_export("main", 0)
+                     .set_data_size(16, 16)
+                     .add_fini(4)
+                     .build() }
+  {
+    allocations.clear();
+    releases = 0;
+    loader_.set_environment(environment_);
+    add_image(
+      "libfoo",
+      test::ImageBuilder("libfoo", Header::Type::Library)
+        .add_export("foo", 4)
+        .add_import("bar")
+        .set_data_size(32, 16)
+        .add_fini(8)
+        .build());
+  }
+
+  ~LoaderArenaShould()
+  {
+    allocations.clear();
+  }
+
+protected:
+  struct Allocation
+  {
+    AllocationType type;
+    void          *address;
+    std::size_t    size;
+  };
+
+  static std::size_t count(AllocationType type)
+  {
+    return static_cast<std::size_t>(std::count_if(
+      allocations.begin(),
+      allocations.end(),
+      [type](const Allocation &allocation)
+      {
+        return allocation.type == type;
+      }));
+  }
+
+  template <typename T>
+  static bool is_in_arena(const std::span<T> &region)
+  {
+    const auto *begin = reinterpret_cast<const std::byte *>(region.data());
+    const auto *end   = begin + region.size_bytes();
+    return std::any_of(
+      allocations.begin(),
+      allocations.end(),
+      [begin, end](const Allocation &allocation)
+      {
+        const auto *arena = static_cast<const std::byte *>(allocation.address);
+        return allocation.type == AllocationType::Arena && begin >= arena &&
+               end <= arena + allocation.size;
+      });
+  }
+
+  static inline std::vector<Allocation> allocations;
+  static inline int                     releases = 0;
+  int                                   bar_     = 0;
+  const SymbolEntry                     symbols_[1] = { SymbolEntry{ "bar",
+                                                             &bar_ } };
+  const StaticEnvironment               environment_{ symbols_ };
+  test::Image                           executable_;
+};
+
+TEST_F(LoaderArenaShould, PlaceModuleRegionsInSingleAllocation)
+{
+  auto executable = loader_.load_executable(executable_.data());
+  ASSERT_TRUE(executable);
+
+  EXPECT_EQ(count(AllocationType::Arena), 2);
+  EXPECT_EQ(count(AllocationType::OffsetTable), 0);
+  EXPECT_EQ(count(AllocationType::Data), 0);
+  EXPECT_EQ(count(AllocationType::Init), 0);
+
+  ASSERT_EQ((*executable)->get_modules().size(), 1);
+  Module &library = *(*executable)->get_modules().front();
+  for (Module *module : { static_cast<Module *>(&**executable), &library })
+  {
+    EXPECT_TRUE(is_in_arena(module->get_lot()));
+    EXPECT_TRUE(is_in_arena(module->get_init()));
+    EXPECT_TRUE(is_in_arena(module->get_data()));
+    EXPECT_TRUE(is_in_arena(module->get_bss()));
+  }
+  EXPECT_TRUE(is_in_arena(std::span(&library, 1)));
+}
+
+TEST_F(LoaderArenaShould, AlignRegionsInArena)
+{
+  auto executable = loader_.load_executable(executable_.data());
+  ASSERT_TRUE(executable);
+
+  Module    &library    = *(*executable)->get_modules().front();
+  const auto is_aligned = [](const void *region)
+  {
+    return reinterpret_cast<std::size_t>(region) % alignof(std::max_align_t) ==
+           0;
+  };
+  EXPECT_TRUE(is_aligned(library.get_lot().data()));
+  EXPECT_TRUE(is_aligned(library.get_init().data()));
+  EXPECT_TRUE(is_aligned(library.get_data().data()));
+}
+
+TEST_F(LoaderArenaShould, ReleaseArenaWithModule)
+{
+  {
+    auto executable = loader_.load_executable(executable_.data());
+    ASSERT_TRUE(executable);
+    releases = 0;
+  }
+  // executable arena, library arena with module object
+  EXPECT_EQ(releases, 2);
+}
+
+TEST_F(LoaderArenaShould, AllocateRegionsSeparatelyWhenDisabled)
+{
+  loader_.set_module_arena(false);
+  auto executable = loader_.load_executable(executable_.data());
+  ASSERT_TRUE(executable);
+
+  EXPECT_EQ(count(AllocationType::Arena), 0);
+  EXPECT_EQ(count(AllocationType::OffsetTable), 2);
+  EXPECT_EQ(count(AllocationType::Data), 2);
+  EXPECT_EQ(count(AllocationType::Init), 2);
+  EXPECT_FALSE(is_in_arena((*executable)->get_lot()));
+}
+
+TEST_F(LoaderArenaShould, AllocateFromBaseWhenRegionTaken)
+{
+  alignas(std::size_t) std::byte region[4 * sizeof(std::size_t)];
+  RegionAllocator<std::size_t, OffsetTableAllocator> allocator(region);
+
+  std::size_t *first  = allocator.allocate(4);
+  std::size_t *second = allocator.allocate(2);
+  EXPECT_TRUE(allocator.contains(first));
+  EXPECT_FALSE(allocator.contains(second));
+  EXPECT_EQ(count(AllocationType::OffsetTable), 1);
+
+  allocator.deallocate(first, 4);
+  std::size_t *third = allocator.allocate(1);
+  EXPECT_TRUE(allocator.contains(third));
+  allocator.deallocate(third, 1);
+  allocator.deallocate(second, 2);
+  EXPECT_EQ(releases, 1);
+}
+
+} // namespace yasld
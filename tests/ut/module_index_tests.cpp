@@ -0,0 +1,230 @@
+/**
+ * module_index_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/module_index.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+#include "yasld/library.hpp"
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+
+namespace yasld
+{
+
+class ModuleIndexShould : public ::testing::Test
+{
+public:
+  ModuleIndexShould()
+  {
+    YasldAllocatorHolder::get().set_allocator(
+      [](std::size_t size, AllocationType)
+      {
+        return std::malloc(size);
+      });
+    YasldAllocatorHolder::get().set_release(
+      [](void *ptr)
+      {
+        std::free(ptr);
+      });
+  }
+
+protected:
+  static Library create_library(std::span<const std::byte> text)
+  {
+    Library library;
+    library.set_text(text);
+    library.allocate_data(16, 8);
+    return library;
+  }
+
+  static std::size_t address(std::span<const std::byte> section)
+  {
+    return reinterpret_cast<std::size_t>(section.data());
+  }
+
+  std::vector<Module *> find(std::size_t program_counter) const
+  {
+    std::vector<Module *> modules;
+    for (const auto &range : sut_.find(program_counter))
+    {
+      modules.push_back(range.module);
+    }
+    return modules;
+  }
+
+  std::array<std::byte, 32> text_a_ = {};
+  std::array<std::byte, 32> text_b_ = {};
+  ModuleIndex               sut_;
+};
+
+TEST_F(ModuleIndexShould, FindModuleForEachRange)
+{
+  auto a = create_library(text_a_);
+  auto b = create_library(text_b_);
+  ASSERT_TRUE(sut_.insert(a));
+  ASSERT_TRUE(sut_.insert(b));
+  EXPECT_EQ(sut_.size(), 6);
+
+  for (Module *module : { &a, &b })
+  {
+    const std::vector<Module *> expected = { module };
+    EXPECT_EQ(find(address(module->get_text())), expected);
+    EXPECT_EQ(find(address(module->get_text()) + 31), expected);
+    EXPECT_EQ(find(address(module->get_data()) + 8), expected);
+    EXPECT_EQ(find(address(module->get_bss()) + 7), expected);
+  }
+  EXPECT_TRUE(find(0).empty());
+}
+
+TEST_F(ModuleIndexShould, ReturnAllModulesSharingText)
+{
+  auto a = create_library(text_a_);
+  auto b = create_library(text_a_);
+  ASSERT_TRUE(sut_.insert(a));
+  ASSERT_TRUE(sut_.insert(b));
+
+  EXPECT_EQ(find(address(text_a_) + 4).size(), 2);
+  EXPECT_EQ(find(address(a.get_data())), std::vector<Module *>{ &a });
+  EXPECT_EQ(find(address(b.get_data())), std::vector<Module *>{ &b });
+}
+
+TEST_F(ModuleIndexShould, FindModuleWithLot)
+{
+  auto a = create_library(text_a_);
+  auto b = create_library(text_b_);
+  auto c = create_library(text_b_);
+  a.allocate_lot(4);
+  b.allocate_lot(2);
+  ASSERT_TRUE(sut_.insert(a));
+  ASSERT_TRUE(sut_.insert(b));
+  ASSERT_TRUE(sut_.insert(c));
+
+  const auto lot_of = [](Module &module)
+  {
+    return reinterpret_cast<std::size_t>(module.get_lot().data());
+  };
+  EXPECT_EQ(sut_.find_with_lot(lot_of(a)), &a);
+  EXPECT_EQ(sut_.find_with_lot(lot_of(b)), &b);
+  EXPECT_EQ(sut_.find_with_lot(lot_of(a) + sizeof(std::size_t)), nullptr);
+  // module without LOT is not identified by null R9
+  EXPECT_EQ(sut_.find_with_lot(0), nullptr);
+}
+
+TEST_F(ModuleIndexShould, FollowMovedAndDestroyedModules)
+{
+  std::optional<Library> a(create_library(text_a_));
+  a->allocate_lot(1);
+  ASSERT_TRUE(sut_.insert(*a));
+  const auto lot = reinterpret_cast<std::size_t>(a->get_lot().data());
+
+  std::optional<Library> moved(std::move(*a));
+  a.reset();
+  EXPECT_EQ(find(address(text_a_)), std::vector<Module *>{ &*moved });
+  EXPECT_EQ(sut_.find_with_lot(lot), &*moved);
+
+  moved.reset();
+  EXPECT_EQ(sut_.size(), 0);
+  EXPECT_TRUE(find(address(text_a_)).empty());
+  EXPECT_EQ(sut_.find_with_lot(lot), nullptr);
+}
+
+class LoaderModuleLookupShould : public ::testing::Test
+{
+public:
+  LoaderModuleLookupShould()
+    : loader_{ [](std::size_t size, AllocationType)
+               {
+                 return std::malloc(size);
+               },
+               [](void *ptr)
+               {
+                 std::free(ptr);
+               } }
+    , library_{ test::ImageBuilder("libfoo", Header::Type::Library)
+                  .add_export("foo", 4)
+                  .set_data_size(16, 16)
+                  .build() }
+    , executable_{ test::ImageBuilder("executable", Header::Type::Executable)
+                     .add_dependency("libfoo")
+                     .add_import("foo")
+                     .add_export("main", 0)
+                     .set_data_size(16, 0)
+                     .build() }
+  {
+    loader_.register_file_resolver(
+      [this](const std::string_view &name) -> std::optional<const void *>
+      {
+        if (name == "libfoo")
+        {
+          return library_.data();
+        }
+        return std::nullopt;
+      });
+  }
+
+protected:
+  Loader      loader_;
+  test::Image library_;
+  test::Image executable_;
+};
+
+TEST_F(LoaderModuleLookupShould, UseCallerLotForSharedText)
+{
+  auto first  = loader_.load_executable(executable_.data());
+  auto second = loader_.load_executable(executable_.data());
+  auto other  = loader_.load_library(library_.data());
+  ASSERT_TRUE(first && second && other);
+
+  Module *library = (*first)->get_modules().front().get();
+  const std::size_t text =
+    reinterpret_cast<std::size_t>(library->get_text().data()) + 4;
+  const auto lot_of = [](Module &module)
+  {
+    return reinterpret_cast<std::size_t>(module.get_lot().data());
+  };
+
+  // R9 of runtime system doesn't point to any LOT
+  constexpr std::size_t runtime_lot = 1;
+
+  // library loaded as dependency and standalone shares text
+  EXPECT_EQ(loader_.find_module_for_pc_and_lot(text, lot_of(**first)), library);
+  EXPECT_EQ(
+    loader_.find_module_for_pc_and_lot(text, lot_of(**second)), library);
+  EXPECT_EQ(loader_.find_module_for_pc_and_lot(text, runtime_lot), &**other);
+
+  const std::size_t data =
+    reinterpret_cast<std::size_t>((*second)->get_data().data());
+  EXPECT_EQ(
+    loader_.find_module_for_pc_and_lot(data, runtime_lot), &**second);
+
+  EXPECT_EQ(loader_.find_active_module(text), nullptr);
+  EXPECT_TRUE(loader_.get_call_context_stack().push(*library, {}));
+  EXPECT_EQ(loader_.find_active_module(text), library);
+  loader_.get_call_context_stack().pop();
+}
+
+} // namespace yasld
@@ -0,0 +1,148 @@
+/**
+ * module_registry_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/module_registry.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+
+#include "yasld/library.hpp"
+
+namespace yasld
+{
+
+class ModuleRegistryShould : public ::testing::Test
+{
+public:
+  ModuleRegistryShould()
+  {
+    YasldAllocatorHolder::get().set_allocator(
+      [](std::size_t size, AllocationType) -> void *
+      {
+        if (fail_allocation)
+        {
+          return nullptr;
+        }
+        ++allocations;
+        return std::malloc(size);
+      });
+    YasldAllocatorHolder::get().set_release(
+      [](void *ptr)
+      {
+        if (ptr != nullptr)
+        {
+          --allocations;
+        }
+        std::free(ptr);
+      });
+    allocations     = 0;
+    fail_allocation = false;
+  }
+
+protected:
+  Module *create_library()
+  {
+    void *memory = YasldAllocatorHolder::get().allocate(
+      sizeof(Library), AllocationType::Module);
+    Module *library = new (memory) Library;
+    library->set_allocation(sizeof(Library), AllocationType::Module);
+    return library;
+  }
+
+  static inline int  allocations     = 0;
+  static inline bool fail_allocation = false;
+  const char         image_a[4]      = {};
+  const char         image_b[4]      = {};
+};
+
+TEST_F(ModuleRegistryShould, ShareModuleLoadedFromSameImage)
+{
+  {
+    ModuleRegistry sut;
+    Module        *library = create_library();
+    {
+      auto first = sut.insert(image_a, library);
+      EXPECT_FALSE(sut.find(image_b));
+
+      auto second = sut.find(image_a);
+      ASSERT_TRUE(second);
+      EXPECT_EQ(second.get(), library);
+      EXPECT_EQ(sut.get_reference_count(library), 2);
+    }
+    EXPECT_EQ(sut.size(), 0);
+  }
+  EXPECT_EQ(allocations, 0);
+}
+
+TEST_F(ModuleRegistryShould, ReleaseModuleWithLastReference)
+{
+  {
+    ModuleRegistry sut;
+    auto           a = sut.insert(image_a, create_library());
+    auto           b = sut.insert(image_b, create_library());
+    EXPECT_EQ(sut.size(), 2);
+
+    auto a2 = sut.find(image_a);
+    a.reset();
+    EXPECT_EQ(sut.size(), 2);
+    EXPECT_EQ(sut.get_reference_count(a2.get()), 1);
+
+    a2.reset();
+    EXPECT_EQ(sut.size(), 1);
+    b.reset();
+    EXPECT_EQ(sut.size(), 0);
+  }
+  EXPECT_EQ(allocations, 0);
+}
+
+TEST_F(ModuleRegistryShould, ReleaseDependenciesOfReleasedModule)
+{
+  {
+    ModuleRegistry sut;
+    auto           parent = sut.insert(image_a, create_library());
+    ASSERT_TRUE(parent->allocate_modules(1));
+    parent->get_modules().push_back(
+      sut.insert(image_b, create_library()));
+    EXPECT_EQ(sut.size(), 2);
+
+    parent.reset();
+    EXPECT_EQ(sut.size(), 0);
+  }
+  EXPECT_EQ(allocations, 0);
+}
+
+TEST_F(ModuleRegistryShould, LeaveModuleWithCallerWhenInsertFails)
+{
+  {
+    ModuleRegistry sut;
+    Module        *library = create_library();
+    fail_allocation        = true;
+    EXPECT_FALSE(sut.insert(image_a, library));
+    EXPECT_EQ(sut.size(), 0);
+    EXPECT_FALSE(sut.find(image_a));
+    fail_allocation = false;
+    Module::destroy(library);
+  }
+  EXPECT_EQ(allocations, 0);
+}
+
+} // namespace yasld
@@ -31,6 +31,8 @@
 #include "yasld/relocation.hpp"
 #include "yasld/symbol.hpp"
 
+#include "image_builder.hpp"
+
 alignas(16) const std::vector<uint8_t> example_header = {
   0x59, 0x41, 0x46, 0x46, // YAFF
   0x01, 0x00, 0x01, 0x01, // executable, armv6-m, YASIFF version 1
@@ -266,3 +268,102 @@ TEST_F(ParserShould, ParseDataSection)
   EXPECT_EQ(
     data.data(), reinterpret_cast<const std::byte *>(header_) + data_offset);
 }
+
+class ParserWithSectionDirectoryShould : public ::testing::Test
+{
+public:
+  ParserWithSectionDirectoryShould()
+    : image_{ yasld::test::ImageBuilder("module", yasld::Header::Type::Library)
+                .add_dependency("libc")
+                .add_import("printf")
+                .add_import("malloc")
+                .add_export("function", 4)
+                .set_text_size(36)
+                .set_data_size(12, 4)
+                .build() }
+    , header_{ reinterpret_cast<const yasld::Header *>(image_.data()) }
+    , sut_{ header_ }
+  {
+  }
+
+protected:
+  std::size_t offset_of(const void *address) const
+  {
+    return static_cast<std::size_t>(
+      static_cast<const uint8_t *>(address) -
+      reinterpret_cast<const uint8_t *>(header_));
+  }
+
+  yasld::test::Image   image_;
+  const yasld::Header *header_;
+  const yasld::Parser  sut_;
+};
+
+TEST_F(ParserWithSectionDirectoryShould, ReadSectionsFromDirectory)
+{
+  const yasld::SectionDirectory *directory = header_->section_directory();
+  ASSERT_NE(directory, nullptr);
+
+  EXPECT_EQ(sut_.name(), "module");
+  ASSERT_EQ(sut_.get_imported_libraries().size(), 8);
+  EXPECT_EQ(sut_.get_imported_libraries().begin()->name(), "libc");
+
+  EXPECT_EQ(
+    offset_of(sut_.get_symbol_table_relocations().span().data()),
+    directory->symbol_table_relocations.offset);
+  EXPECT_EQ(sut_.get_symbol_table_relocations().span().size(), 2);
+
+  const auto imported = sut_.get_imported_symbol_table();
+  EXPECT_EQ(imported.size(), directory->imported_symbols.size);
+  auto symbol = imported.begin();
+  EXPECT_EQ(symbol->name(), "printf");
+  ++symbol;
+  EXPECT_EQ(symbol->name(), "malloc");
+  EXPECT_EQ(++symbol, imported.end());
+
+  const auto exported = sut_.get_exported_symbol_table();
+  EXPECT_EQ(exported.begin()->name(), "function");
+  EXPECT_EQ(exported.begin()->offset(), 4);
+
+  EXPECT_EQ(offset_of(sut_.get_text().data()), directory->text.offset);
+  EXPECT_EQ(offset_of(sut_.get_text().data()) % 16, 0);
+  EXPECT_EQ(sut_.get_text().size(), 36);
+  EXPECT_EQ(offset_of(sut_.get_data().data()), directory->data.offset);
+  EXPECT_EQ(sut_.get_data().size(), 12);
+}
+
+TEST_F(ParserWithSectionDirectoryShould, FindSameSectionsAsInVersion1)
+{
+  const auto legacy_image =
+    yasld::test::ImageBuilder("module", yasld::Header::Type::Library)
+      .add_dependency("libc")
+      .add_import("printf")
+      .add_import("malloc")
+      .add_export("function", 4)
+      .set_text_size(36)
+      .set_data_size(12, 4)
+      .set_version(1)
+      .build();
+  const auto *legacy_header =
+    reinterpret_cast<const yasld::Header *>(legacy_image.data());
+  ASSERT_EQ(legacy_header->section_directory(), nullptr);
+  const yasld::Parser legacy(legacy_header);
+
+  EXPECT_EQ(legacy.name(), sut_.name());
+  EXPECT_EQ(
+    legacy.get_imported_symbol_table().size(),
+    sut_.get_imported_symbol_table().size());
+  EXPECT_EQ(
+    legacy.get_exported_symbol_table().size(),
+    sut_.get_exported_symbol_table().size());
+  EXPECT_EQ(legacy.get_text().size(), sut_.get_text().size());
+  EXPECT_EQ(legacy.get_data().size(), sut_.get_data().size());
+  // only difference is directory placed after header
+  EXPECT_EQ(
+    offset_of(sut_.get_exported_symbol_table().begin().operator->()) -
+      sizeof(yasld::SectionDirectory),
+    static_cast<std::size_t>(
+      reinterpret_cast<const uint8_t *>(
+        legacy.get_exported_symbol_table().begin().operator->()) -
+      reinterpret_cast<const uint8_t *>(legacy_header)));
+}
@@ -0,0 +1,217 @@
+/**
+ * placement_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <span>
+
+#include "yasld/loader.hpp"
+#include "yasld/parser.hpp"
+
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+
+namespace yasld
+{
+
+class LoaderPlacementShould : public test::LoaderFixture
+{
+public:
+  LoaderPlacementShould()
+    : LoaderFixture(
+        [](std::size_t size, AllocationType type) -> void *
+        {
+          if (type != AllocationType::Text)
+          {
+            return std::malloc(size);
+          }
+          // fini entries are called from copied text
+          void *memory = test::ExecutableAllocator<std::byte>().allocate(size);
+          text_allocations[memory] = size;
+          return memory;
+        },
+        [](void *ptr)
+        {
+          const auto text = text_allocations.find(ptr);
+          if (text == text_allocations.end())
+          {
+            std::free(ptr);
+            return;
+          }
+          test::ExecutableAllocator<std::byte>().deallocate(
+            static_cast<std::byte *>(ptr), text->second);
+          text_allocations.erase(text);
+        })
+    , region_(4)
+    , library_{ add_image(
+        "libfoo",
+        test::ImageBuilder("libfoo", Header::Type::Library)
+          .add_export("foo", 4)
+          .set_text_size(32)
+          .add_fini(8)
+          .build()) }
+    , executable_{ test::ImageBuilder("executable", Header::Type::Executable)
+                     .add_dependency("libfoo")
+                     .add_import("foo")
+                     .add_export("main", 0)
+                     .build() }
+  {
+    region          = std::as_bytes(std::span(region_));
+    region_requests = 0;
+    region_releases = 0;
+    loader_.add_memory_region(MemoryRegion{
+      .name = "sram",
+      .allocate =
+        [](std::size_t size, AllocationType type) -> void *
+      {
+        ++region_requests;
+        if (type != AllocationType::Text || size > region.size())
+        {
+          return nullptr;
+        }
+        return const_cast<std::byte *>(region.data());
+      },
+      .release =
+        [](void *ptr)
+      {
+        if (ptr == region.data())
+        {
+          ++region_releases;
+        }
+      } });
+  }
+
+protected:
+  bool is_in_image(const Module &module, const test::Image &image) const
+  {
+    const auto *begin = reinterpret_cast<const std::byte *>(image.data());
+    const auto *end   = begin + image.size() * sizeof(test::ImageBlock);
+    const auto *text  = module.get_text().data();
+    return text >= begin && text < end;
+  }
+
+  void expect_relocated_to_text(Module &library) const
+  {
+    const auto text = reinterpret_cast<std::size_t>(library.get_text().data());
+    ASSERT_EQ(library.get_text().size(), 32);
+    EXPECT_TRUE(std::ranges::equal(
+      library.get_text(),
+      Parser(reinterpret_cast<const Header *>(library_.data())).get_text()));
+    ASSERT_EQ(library.get_fini().size(), 1);
+    EXPECT_EQ(library.get_fini()[0], text + 8);
+    EXPECT_EQ(library.find_symbol("foo"), text + 4);
+  }
+
+  static inline std::map<void *, std::size_t> text_allocations;
+  static inline std::span<const std::byte>    region;
+  static inline int                           region_requests = 0;
+  static inline int                           region_releases = 0;
+
+  test::Image        region_;
+  const test::Image &library_;
+  test::Image        executable_;
+};
+
+TEST_F(LoaderPlacementShould, ExecuteInPlaceByDefault)
+{
+  auto executable = loader_.load_executable(executable_.data());
+  ASSERT_TRUE(executable);
+  Module &library = *(*executable)->get_modules().front();
+
+  EXPECT_TRUE(is_in_image(library, library_));
+  EXPECT_TRUE(is_in_image(**executable, executable_));
+  EXPECT_EQ(region_requests, 0);
+}
+
+TEST_F(LoaderPlacementShould, CopyTextToRam)
+{
+  loader_.set_placement({ .text = TextPlacement::CopyToRam, .region = {} });
+  auto executable = loader_.load_executable(executable_.data());
+  ASSERT_TRUE(executable);
+  Module &library = *(*executable)->get_modules().front();
+
+  EXPECT_FALSE(is_in_image(library, library_));
+  EXPECT_FALSE(is_in_image(**executable, executable_));
+  expect_relocated_to_text(library);
+  EXPECT_EQ(
+    (*executable)->get_lot()[0],
+    reinterpret_cast<std::size_t>(library.get_text().data()) + 4);
+}
+
+TEST_F(LoaderPlacementShould, CopyTextToNamedRegion)
+{
+  loader_.set_placement(
+    { .text = TextPlacement::CopyToRegion, .region = "sram" });
+  {
+    auto library = loader_.load_library(library_.data());
+    ASSERT_TRUE(library);
+
+    EXPECT_EQ((*library)->get_text().data(), region.data());
+    expect_relocated_to_text(**library);
+    EXPECT_EQ(region_requests, 1);
+  }
+  EXPECT_EQ(region_releases, 1);
+}
+
+TEST_F(LoaderPlacementShould, ApplyPlacementResolvedForModule)
+{
+  loader_.register_placement_resolver(
+    [](const std::string_view &name) -> std::optional<Placement>
+    {
+      if (name == "libfoo")
+      {
+        return Placement{ .text   = TextPlacement::CopyToRegion,
+                          .region = "sram" };
+      }
+      return std::nullopt;
+    });
+  auto executable = loader_.load_executable(executable_.data());
+  ASSERT_TRUE(executable);
+  Module &library = *(*executable)->get_modules().front();
+
+  EXPECT_EQ(library.get_text().data(), region.data());
+  EXPECT_TRUE(is_in_image(**executable, executable_));
+}
+
+TEST_F(LoaderPlacementShould, RejectUnknownRegion)
+{
+  loader_.set_placement(
+    { .text = TextPlacement::CopyToRegion, .region = "itcm" });
+  EXPECT_FALSE(loader_.load_library(library_.data()));
+  EXPECT_EQ(region_requests, 0);
+}
+
+TEST_F(LoaderPlacementShould, RejectRegionWithoutMemory)
+{
+  loader_.set_placement(
+    { .text = TextPlacement::CopyToRegion, .region = "sram" });
+  auto executable = test::ImageBuilder("big", Header::Type::Library)
+                      .set_text_size(128)
+                      .build();
+  EXPECT_FALSE(loader_.load_library(executable.data()));
+  EXPECT_EQ(region_requests, 1);
+  EXPECT_EQ(region_releases, 0);
+}
+
+} // namespace yasld
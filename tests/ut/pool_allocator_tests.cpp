@@ -0,0 +1,144 @@
+/**
+ * pool_allocator_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/pool_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+
+namespace yasld
+{
+
+namespace
+{
+
+using TestPoolAllocator =
+  PoolAllocator<FixedBlockPool<32, 2>, FixedBlockPool<128, 2>>;
+
+} // namespace
+
+class PoolAllocatorShould : public ::testing::Test
+{
+public:
+  PoolAllocatorShould()
+    : sut_{ [](std::size_t size, AllocationType)
+            {
+              ++fallback_allocations;
+              return std::malloc(size);
+            },
+            [](void *ptr)
+            {
+              --fallback_allocations;
+              std::free(ptr);
+            } }
+  {
+    fallback_allocations = 0;
+  }
+
+protected:
+  void *allocate(std::size_t size)
+  {
+    return sut_.allocate(size, AllocationType::Data);
+  }
+
+  static inline int fallback_allocations = 0;
+  TestPoolAllocator sut_;
+};
+
+TEST_F(PoolAllocatorShould, TakeBlockFromSmallestFittingPool)
+{
+  void *small = allocate(8);
+  void *big   = allocate(33);
+  EXPECT_TRUE(sut_.get_pool<0>().contains(small));
+  EXPECT_TRUE(sut_.get_pool<1>().contains(big));
+  EXPECT_EQ(sut_.get_pool<0>().used_blocks(), 1);
+  EXPECT_EQ(sut_.get_pool<1>().used_blocks(), 1);
+  EXPECT_EQ(
+    reinterpret_cast<std::uintptr_t>(small) % alignof(std::max_align_t), 0);
+  EXPECT_EQ(fallback_allocations, 0);
+}
+
+TEST_F(PoolAllocatorShould, UseBiggerPoolWhenPoolIsExhausted)
+{
+  allocate(32);
+  allocate(32);
+  void *third = allocate(32);
+  EXPECT_TRUE(sut_.get_pool<1>().contains(third));
+  EXPECT_EQ(sut_.get_pool<0>().used_blocks(), 2);
+}
+
+TEST_F(PoolAllocatorShould, ReuseReleasedBlock)
+{
+  void *first  = allocate(16);
+  void *second = allocate(16);
+  sut_.release(first);
+  EXPECT_EQ(sut_.get_pool<0>().used_blocks(), 1);
+  EXPECT_EQ(allocate(16), first);
+  sut_.release(second);
+  sut_.release(first);
+  EXPECT_EQ(sut_.get_pool<0>().used_blocks(), 0);
+  EXPECT_EQ(sut_.get_pool<0>().peak_blocks(), 2);
+}
+
+TEST_F(PoolAllocatorShould, PassAllocationsThatDoNotFitToFallback)
+{
+  void *huge = allocate(129);
+  ASSERT_NE(huge, nullptr);
+  EXPECT_FALSE(sut_.get_pool<1>().contains(huge));
+  EXPECT_EQ(fallback_allocations, 1);
+  sut_.release(huge);
+  EXPECT_EQ(fallback_allocations, 0);
+
+  TestPoolAllocator without_fallback;
+  EXPECT_EQ(without_fallback.allocate(129, AllocationType::Data), nullptr);
+}
+
+TEST_F(PoolAllocatorShould, ReleaseAllModuleMemory)
+{
+  DefaultPoolAllocator pool;
+  Loader               loader(pool.get_allocator(), pool.get_release());
+  const auto           image =
+    test::ImageBuilder("executable", Header::Type::Executable)
+      .add_export("main", 0)
+      .set_data_size(100, 20)
+      .build();
+
+  for (int i = 0; i < 10; ++i)
+  {
+    auto executable = loader.load_executable(image.data());
+    ASSERT_TRUE(executable);
+    EXPECT_GT(pool.get_pool<0>().used_blocks(), 0);
+    loader.unload(std::move(*executable));
+  }
+  // loader keeps buffers for registry and load stack
+  const std::size_t used = pool.get_pool<0>().used_blocks() +
+                           pool.get_pool<1>().used_blocks() +
+                           pool.get_pool<2>().used_blocks() +
+                           pool.get_pool<3>().used_blocks();
+  EXPECT_LE(used, 4);
+}
+
+} // namespace yasld
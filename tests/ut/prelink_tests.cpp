@@ -0,0 +1,204 @@
+/**
+ * prelink_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/prelink_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "yasld/environment.hpp"
+#include "yasld/loader.hpp"
+
+#include "counting_environment.hpp"
+#include "image_builder.hpp"
+
+namespace yasld
+{
+
+namespace
+{
+
+int   first_function  = 0;
+int   second_function = 0;
+void *first_address   = &first_function;
+void *second_address  = &second_function;
+
+class MemoryPrelinkCache : public PrelinkCache
+{
+public:
+  std::optional<std::span<const std::size_t>> find(
+    const void *module_address,
+    uint32_t    fingerprint) const override
+  {
+    const auto entry = entries.find(module_address);
+    if (entry == entries.end() || entry->second.first != fingerprint)
+    {
+      return std::nullopt;
+    }
+    return entry->second.second;
+  }
+
+  void store(
+    const void                        *module_address,
+    uint32_t                           fingerprint,
+    const std::span<const std::size_t> imports) override
+  {
+    entries[module_address] = {
+      fingerprint, std::vector<std::size_t>(imports.begin(), imports.end())
+    };
+  }
+
+  std::map<const void *, std::pair<uint32_t, std::vector<std::size_t>>>
+    entries;
+};
+
+} // namespace
+
+class LoaderPrelinkShould : public ::testing::Test
+{
+public:
+  LoaderPrelinkShould()
+    : environment_{ {
+        SymbolEntry{ "first", first_address },
+        SymbolEntry{ "second", second_address },
+      } }
+    , loader_{ [](std::size_t size, AllocationType)
+               {
+                 return std::malloc(size);
+               },
+               [](void *ptr)
+               {
+                 std::free(ptr);
+               } }
+    , image_{ test::ImageBuilder("prelinked", Header::Type::Executable)
+                .add_import("first")
+                .add_import("second")
+                .add_export("main", 0)
+                .build() }
+  {
+    environment_.fingerprint_ = 0x1234;
+    loader_.set_environment(environment_);
+    loader_.set_prelink_cache(cache_);
+  }
+
+protected:
+  std::vector<std::size_t> load()
+  {
+    auto executable = loader_.load_executable(image_.data());
+    EXPECT_TRUE(executable);
+    if (!executable)
+    {
+      return {};
+    }
+    const auto lot = (*executable)->get_lot();
+    return { lot.begin(), lot.begin() + 2 };
+  }
+
+  const std::vector<std::size_t> expected_lot_ = {
+    reinterpret_cast<std::size_t>(&first_function),
+    reinterpret_cast<std::size_t>(&second_function)
+  };
+
+  test::CountingEnvironment environment_;
+  MemoryPrelinkCache        cache_;
+  Loader                    loader_;
+  test::Image               image_;
+};
+
+TEST_F(LoaderPrelinkShould, StoreImportsResolvedByName)
+{
+  EXPECT_EQ(load(), expected_lot_);
+  EXPECT_EQ(environment_.lookups, 2);
+  ASSERT_EQ(cache_.entries.size(), 1);
+  EXPECT_EQ(cache_.entries.begin()->second.second, expected_lot_);
+}
+
+TEST_F(LoaderPrelinkShould, CopyImportsWhenFingerprintMatches)
+{
+  EXPECT_EQ(load(), expected_lot_);
+  environment_.lookups = 0;
+
+  EXPECT_EQ(load(), expected_lot_);
+  EXPECT_EQ(environment_.lookups, 0);
+}
+
+TEST_F(LoaderPrelinkShould, CopyImportsInBoundedSteps)
+{
+  EXPECT_EQ(load(), expected_lot_);
+  environment_.lookups = 0;
+
+  ASSERT_TRUE(loader_.start_loading_executable(image_.data()));
+  while (loader_.step(1) == Loader::LoadStatus::InProgress)
+  {
+  }
+  auto executable = loader_.take_executable();
+  ASSERT_TRUE(executable);
+  const auto lot = (*executable)->get_lot();
+  EXPECT_EQ(
+    std::vector<std::size_t>(lot.begin(), lot.begin() + 2), expected_lot_);
+  EXPECT_EQ(environment_.lookups, 0);
+}
+
+TEST_F(LoaderPrelinkShould, ResolveByNameWhenEnvironmentChanged)
+{
+  EXPECT_EQ(load(), expected_lot_);
+  environment_.lookups      = 0;
+  environment_.fingerprint_ = 0x4321;
+
+  EXPECT_EQ(load(), expected_lot_);
+  EXPECT_EQ(environment_.lookups, 2);
+}
+
+TEST_F(LoaderPrelinkShould, ResolveByNameWhenImageReflashed)
+{
+  EXPECT_EQ(load(), expected_lot_);
+  environment_.lookups = 0;
+
+  // same address and size, only order of imports differs
+  const test::Image reflashed =
+    test::ImageBuilder("prelinked", Header::Type::Executable)
+      .add_import("second")
+      .add_import("first")
+      .add_export("main", 0)
+      .build();
+  ASSERT_EQ(reflashed.size(), image_.size());
+  std::copy(reflashed.begin(), reflashed.end(), image_.begin());
+
+  EXPECT_EQ(
+    load(),
+    std::vector<std::size_t>(expected_lot_.rbegin(), expected_lot_.rend()));
+  EXPECT_EQ(environment_.lookups, 2);
+}
+
+TEST_F(LoaderPrelinkShould, ResolveByNameWithoutEnvironmentFingerprint)
+{
+  environment_.fingerprint_ = std::nullopt;
+  EXPECT_EQ(load(), expected_lot_);
+  EXPECT_EQ(load(), expected_lot_);
+  EXPECT_EQ(environment_.lookups, 4);
+  EXPECT_TRUE(cache_.entries.empty());
+}
+
+} // namespace yasld
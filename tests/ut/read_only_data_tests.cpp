@@ -0,0 +1,87 @@
+/**
+ * read_only_data_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+
+#include "yasld/image_source.hpp"
+#include "yasld/loader.hpp"
+#include "yasld/parser.hpp"
+
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+#include "memory_source.hpp"
+
+namespace yasld
+{
+
+class LoaderReadOnlyDataShould : public test::LoaderFixture
+{
+protected:
+  static test::Image build(std::ptrdiff_t displacement)
+  {
+    return test::ImageBuilder("libfoo", Header::Type::Library)
+      .add_export("foo", 4)
+      .set_text_size(32)
+      .set_read_only_data_in_text(displacement)
+      .build();
+  }
+};
+
+TEST_F(LoaderReadOnlyDataShould, ReadLinkAddressFromText)
+{
+  const auto image  = build(0);
+  const auto header = reinterpret_cast<const Header *>(image.data());
+  EXPECT_TRUE(header->has(Header::Flag::ReadOnlyDataInText));
+  EXPECT_EQ(
+    Parser(header).get_link_address(),
+    reinterpret_cast<std::uintptr_t>(image.data()));
+
+  const auto other =
+    test::ImageBuilder("libbar", Header::Type::Library).build();
+  EXPECT_EQ(
+    Parser(reinterpret_cast<const Header *>(other.data())).get_link_address(),
+    std::nullopt);
+}
+
+TEST_F(LoaderReadOnlyDataShould, ExecuteImageInPlaceFromLinkAddress)
+{
+  const auto image   = build(0);
+  auto       library = loader_.load_library(image.data());
+  ASSERT_TRUE(library);
+  EXPECT_EQ(
+    (*library)->get_text().data(),
+    Parser(reinterpret_cast<const Header *>(image.data())).get_text().data());
+}
+
+TEST_F(LoaderReadOnlyDataShould, RejectImageMovedFromLinkAddress)
+{
+  const auto image = build(0x1000);
+  EXPECT_FALSE(loader_.load_library(image.data()));
+}
+
+TEST_F(LoaderReadOnlyDataShould, RejectImageReadFromSource)
+{
+  const auto         image = build(0);
+  test::MemorySource source(image);
+  EXPECT_FALSE(loader_.load_library(source));
+}
+
+} // namespace yasld
@@ -0,0 +1,152 @@
+/**
+ * symbol_hash_table_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "yasld/symbol_hash_table.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace yasld
+{
+
+namespace
+{
+
+constexpr uint32_t number_of_buckets = 3;
+constexpr uint32_t bloom_size        = 2;
+constexpr uint32_t bloom_shift       = 6;
+
+// Builds exported symbol table followed by hash table, same as mkimage does
+std::vector<uint32_t> build_image(std::vector<std::string_view> names)
+{
+  std::stable_sort(
+    names.begin(),
+    names.end(),
+    [](const std::string_view &a, const std::string_view &b)
+    {
+      return SymbolHashTable::hash(a) % number_of_buckets <
+             SymbolHashTable::hash(b) % number_of_buckets;
+    });
+
+  std::vector<uint32_t> symbols;
+  std::vector<uint32_t> offsets;
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    offsets.push_back(static_cast<uint32_t>(symbols.size() * 4));
+    symbols.push_back(static_cast<uint32_t>(i << 2));
+    std::vector<uint32_t> name((names[i].size() + 4) / 4, 0);
+    std::memcpy(name.data(), names[i].data(), names[i].size());
+    symbols.insert(symbols.end(), name.begin(), name.end());
+  }
+
+  std::vector<uint32_t> bloom(bloom_size, 0);
+  std::vector<uint32_t> buckets(number_of_buckets, 0xffffffff);
+  std::vector<uint32_t> chain;
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    const uint32_t h      = SymbolHashTable::hash(names[i]);
+    const uint32_t bucket = h % number_of_buckets;
+    bloom[(h / 32) & (bloom_size - 1)] |=
+      (1u << (h % 32)) | (1u << ((h >> bloom_shift) % 32));
+    if (buckets[bucket] == 0xffffffff)
+    {
+      buckets[bucket] = static_cast<uint32_t>(i);
+    }
+    const bool last =
+      i + 1 == names.size() ||
+      SymbolHashTable::hash(names[i + 1]) % number_of_buckets != bucket;
+    chain.push_back((h & ~1u) | (last ? 1u : 0u));
+  }
+
+  std::vector<uint32_t> image = symbols;
+  image.push_back(number_of_buckets);
+  image.push_back(bloom_size);
+  image.push_back(bloom_shift);
+  image.insert(image.end(), bloom.begin(), bloom.end());
+  image.insert(image.end(), buckets.begin(), buckets.end());
+  image.insert(image.end(), chain.begin(), chain.end());
+  image.insert(image.end(), offsets.begin(), offsets.end());
+  return image;
+}
+
+} // namespace
+
+class SymbolHashTableShould : public ::testing::Test
+{
+public:
+  SymbolHashTableShould()
+    : names_{ "printf", "puts", "malloc", "free", "main", "_start", "a" }
+    , image_{ build_image(names_) }
+    , symbols_size_{ image_.size() - 3 - bloom_size - number_of_buckets -
+                     2 * names_.size() }
+    , sut_{ reinterpret_cast<std::uintptr_t>(image_.data() + symbols_size_),
+            reinterpret_cast<std::uintptr_t>(image_.data()),
+            static_cast<uint16_t>(names_.size()) }
+  {
+  }
+
+protected:
+  const Symbol *find(const std::string_view &name) const
+  {
+    return sut_.find(name, SymbolHashTable::hash(name));
+  }
+
+  std::vector<std::string_view> names_;
+  std::vector<uint32_t>         image_;
+  std::size_t                   symbols_size_;
+  SymbolHashTable               sut_;
+};
+
+TEST_F(SymbolHashTableShould, CalculateHash)
+{
+  EXPECT_EQ(SymbolHashTable::hash(""), 5381);
+  EXPECT_EQ(SymbolHashTable::hash("a"), 177670);
+  EXPECT_EQ(SymbolHashTable::hash("printf"), 0x156b2bb8);
+}
+
+TEST_F(SymbolHashTableShould, ReportSize)
+{
+  EXPECT_EQ(sut_.size(), (image_.size() - symbols_size_) * sizeof(uint32_t));
+}
+
+TEST_F(SymbolHashTableShould, FindExportedSymbols)
+{
+  for (const auto &name : names_)
+  {
+    const Symbol *symbol = find(name);
+    ASSERT_NE(symbol, nullptr) << name;
+    EXPECT_EQ(symbol->name(), name);
+  }
+}
+
+TEST_F(SymbolHashTableShould, RejectMissingSymbols)
+{
+  EXPECT_EQ(find("calloc"), nullptr);
+  EXPECT_EQ(find("print"), nullptr);
+  EXPECT_EQ(find("printf_"), nullptr);
+  EXPECT_EQ(find(""), nullptr);
+}
+
+} // namespace yasld
@@ -0,0 +1,140 @@
+/**
+ * unload_tests.cpp
+ *
+ * Copyright (C) 2024 Mateusz Stadnik <matgla@live.com>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version
+ * 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "yasld/loader.hpp"
+
+#include "image_builder.hpp"
+#include "loader_fixture.hpp"
+
+namespace yasld
+{
+
+class LoaderUnloadShould : public test::LoaderFixture
+{
+public:
+  LoaderUnloadShould()
+    : LoaderFixture(
+        [](std::size_t size, AllocationType)
+        {
+          ++allocations;
+          return std::malloc(size);
+        },
+        [](void *ptr)
+        {
+          if (ptr != nullptr)
+          {
+            --allocations;
+          }
+          std::free(ptr);
+        })
+    , executable_{ test::ImageBuilder("executable", Header::Type::Executable)
+                     .add_dependency("libfoo")
+                     .add_import("foo")
+                     .add_export("main", 0)
+                     .set_data_size(16, 16)
+                     .add_fini(4)
+                     .add_fini(12)
+                     .build() }
+  {
+    allocations = 0;
+    add_image(
+      "libfoo",
+      test::ImageBuilder("libfoo", Header::Type::Library)
+        .add_export("foo", 4)
+        .set_data_size(32, 16)
+        .add_fini(8)
+        .build());
+  }
+
+protected:
+  Loader::ObservedExecutable load()
+  {
+    auto executable = loader_.load_executable(executable_.data());
+    EXPECT_TRUE(executable);
+    return std::move(*executable);
+  }
+
+  // loader keeps buffers for registry and load stack
+  int baseline()
+  {
+    loader_.unload(load());
+    return allocations;
+  }
+
+  static inline int allocations = 0;
+  test::Image       executable_;
+};
+
+TEST_F(LoaderUnloadShould, RelocateFiniArray)
+{
+  auto       executable = load();
+  const auto text =
+    reinterpret_cast<std::size_t>(executable->get_text().data());
+
+  const std::vector<std::size_t> expected = { text + 4, text + 12 };
+  const auto                     fini     = executable->get_fini();
+  EXPECT_EQ(std::vector<std::size_t>(fini.begin(), fini.end()), expected);
+  EXPECT_EQ(executable->get_init().size(), 2);
+  ASSERT_EQ(executable->get_modules().size(), 1);
+  EXPECT_EQ(executable->get_modules().front()->get_fini().size(), 1);
+
+  executable->finalize();
+  EXPECT_TRUE(executable->get_fini().empty());
+}
+
+TEST_F(LoaderUnloadShould, ReleaseAllModuleMemory)
+{
+  const int initial = baseline();
+
+  for (int i = 0; i < 10; ++i)
+  {
+    auto executable = load();
+    EXPECT_GT(allocations, initial);
+    loader_.unload(std::move(executable));
+    EXPECT_EQ(allocations, initial);
+  }
+}
+
+TEST_F(LoaderUnloadShould, KeepSharedDependencyUntilLastConsumerIsUnloaded)
+{
+  const int initial = baseline();
+
+  auto          first   = load();
+  auto          second  = load();
+  const Module *library = first->get_modules().front().get();
+  EXPECT_EQ(second->get_modules().front().get(), library);
+
+  loader_.unload(std::move(first));
+  EXPECT_GT(allocations, initial);
+  EXPECT_EQ(second->get_modules().front()->get_fini().size(), 1);
+  EXPECT_EQ(
+    second->find_symbol("foo"),
+    reinterpret_cast<std::size_t>(library->get_text().data()) + 4);
+
+  loader_.unload(std::move(second));
+  EXPECT_EQ(allocations, initial);
+}
+
+} // namespace yasld